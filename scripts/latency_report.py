@@ -0,0 +1,137 @@
+#!/usr/bin/env python3
+"""Fetch or parse T-Deck latency histograms (@LAT) and print percentiles."""
+
+from __future__ import annotations
+
+import argparse
+import sys
+import time
+from pathlib import Path
+from typing import Iterable, Optional
+
+LAT_PREFIX = "LAT "
+LAT_END = "LAT END"
+
+
+class Hist:
+    def __init__(self, name: str, count: int, sum_us: int, max_us: int, buckets: list[int]):
+        self.name = name
+        self.count = count
+        self.sum_us = sum_us
+        self.max_us = max_us
+        self.buckets = buckets
+
+    def mean_ms(self) -> float:
+        return self.sum_us / self.count / 1000.0 if self.count else 0.0
+
+    def percentile_ms(self, pct: float) -> float:
+        """Estimate a percentile by interpolating inside the log2 bucket."""
+        if not self.count:
+            return 0.0
+        target = self.count * pct / 100.0
+        seen = 0
+        for i, n in enumerate(self.buckets):
+            if n and seen + n >= target:
+                lo = 0 if i == 0 else 1 << i
+                hi = min(1 << (i + 1), max(self.max_us, lo))
+                frac = (target - seen) / n
+                return (lo + (hi - lo) * frac) / 1000.0
+            seen += n
+        return self.max_us / 1000.0
+
+
+def parse_lines(lines: Iterable[str]) -> list[Hist]:
+    hists = []
+    for raw in lines:
+        line = raw.strip()
+        if line.startswith("AGENT "):
+            continue
+        if line == LAT_END:
+            break
+        if not line.startswith(LAT_PREFIX):
+            continue
+        parts = line[len(LAT_PREFIX):].split()
+        if not parts:
+            continue
+        fields = dict(p.split("=", 1) for p in parts[1:] if "=" in p)
+        try:
+            buckets = [int(x) for x in fields.get("b", "").split(",") if x]
+            hists.append(Hist(parts[0], int(fields["n"]), int(fields["sum_us"]),
+                              int(fields["max_us"]), buckets))
+        except (KeyError, ValueError):
+            print(f"skipping malformed line: {line}", file=sys.stderr)
+    return hists
+
+
+def fetch_lines(port: str, baud: int, timeout_s: float, reset: bool) -> list[str]:
+    try:
+        import serial
+    except ImportError as exc:  # pragma: no cover - import error path
+        raise SystemExit("pyserial is required. Run: uv sync") from exc
+    from tdeck_agent import read_line
+
+    lines = []
+    with serial.Serial(port=port, baudrate=baud, timeout=0.1) as ser:
+        ser.write(b"@LAT\n")
+        ser.flush()
+        deadline = time.monotonic() + timeout_s
+        while True:
+            line = read_line(ser, deadline)
+            if line is None:
+                raise TimeoutError("timed out waiting for LAT END")
+            if line.startswith("AGENT ERR"):
+                raise RuntimeError(line)
+            lines.append(line)
+            if line.strip() == LAT_END:
+                break
+        if reset:
+            ser.write(b"@LAT RESET\n")
+            ser.flush()
+    return lines
+
+
+def print_report(hists: list[Hist], show_empty: bool) -> None:
+    print(f"{'histogram':<24}{'n':>8}{'mean':>9}{'p50':>9}{'p90':>9}{'p99':>9}{'max':>9}  (ms)")
+    for h in hists:
+        if not h.count and not show_empty:
+            continue
+        print(f"{h.name:<24}{h.count:>8}{h.mean_ms():>9.1f}{h.percentile_ms(50):>9.1f}"
+              f"{h.percentile_ms(90):>9.1f}{h.percentile_ms(99):>9.1f}{h.max_us / 1000.0:>9.1f}")
+
+
+def main() -> int:
+    parser = argparse.ArgumentParser(description="Report keypress-to-panel latency histograms.")
+    parser.add_argument("--input", help="Parse a captured @LAT dump instead of reading the device")
+    parser.add_argument("--port", help="Serial port (default: auto-detect)")
+    parser.add_argument("--baud", type=int, default=115200, help="Serial baud rate")
+    parser.add_argument("--timeout", type=float, default=4.0, help="Seconds to wait for the dump")
+    parser.add_argument("--reset", action="store_true", help="Clear device histograms after reading")
+    parser.add_argument("--all", action="store_true", help="Also list empty histograms")
+    args = parser.parse_args()
+
+    if args.input:
+        lines = Path(args.input).read_text(encoding="utf-8", errors="replace").splitlines()
+    else:
+        sys.path.insert(0, str(Path(__file__).resolve().parent))
+        from tdeck_agent import auto_detect_port
+
+        port: Optional[str] = args.port or auto_detect_port()
+        if not port:
+            print("Could not auto-detect a single serial port. Pass --port explicitly.", file=sys.stderr)
+            return 2
+        try:
+            lines = fetch_lines(port, args.baud, args.timeout, args.reset)
+        except (TimeoutError, RuntimeError) as exc:
+            print(str(exc), file=sys.stderr)
+            return 5
+
+    hists = parse_lines(lines)
+    if not hists:
+        print("no LAT lines found", file=sys.stderr)
+        return 3
+    print_report(hists, args.all)
+    return 0
+
+
+if __name__ == "__main__":
+    raise SystemExit(main())
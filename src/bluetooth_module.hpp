@@ -38,6 +38,16 @@ static BLECharacteristic* bt_status_char = NULL;
 
 static char bt_peer_addr[18] = "";
 
+// Negotiated connection interval; trackpad motion is reported once per interval.
+#define BT_DEFAULT_CONN_INTERVAL_MS  15U
+#define BT_MIN_CONN_INTERVAL_MS      8U
+static volatile uint32_t bt_conn_interval_ms = BT_DEFAULT_CONN_INTERVAL_MS;
+
+static uint32_t btConnIntervalMs() {
+    uint32_t ms = bt_conn_interval_ms;
+    return ms < BT_MIN_CONN_INTERVAL_MS ? BT_MIN_CONN_INTERVAL_MS : ms;
+}
+
 struct BtScanEntry {
     char addr[18];
     char name[32];
@@ -243,8 +253,7 @@ class BtServerCallbacks : public BLEServerCallbacks {
         bt_advertising = false;
         bt_state = BT_STATE_CONNECTED;
         btSetStatusValue("connected");
-        render_requested = true;
-        term_render_requested = true;
+        requestRender(RENDER_EDITOR | RENDER_TERMINAL);
         SERIAL_LOGLN("BT: client connected");
     }
 
@@ -252,7 +261,9 @@ class BtServerCallbacks : public BLEServerCallbacks {
         onConnect(pServer);
         if (param) {
             btFormatAddr(param->connect.remote_bda, bt_peer_addr, sizeof(bt_peer_addr));
-            SERIAL_LOGF("BT: peer=%s\n", bt_peer_addr);
+            // Interval is in 1.25 ms units.
+            bt_conn_interval_ms = ((uint32_t)param->connect.conn_params.interval * 5U) / 4U;
+            SERIAL_LOGF("BT: peer=%s interval=%lums\n", bt_peer_addr, (unsigned long)bt_conn_interval_ms);
             esp_err_t err = esp_ble_set_encryption(param->connect.remote_bda, ESP_BLE_SEC_ENCRYPT_NO_MITM);
             if (err != ESP_OK) {
                 SERIAL_LOGF("BT: set_encryption failed err=%d\n", (int)err);
@@ -266,8 +277,7 @@ class BtServerCallbacks : public BLEServerCallbacks {
         bt_advertising = false;
         bt_state = BT_STATE_OFF;
         btSetStatusValue("idle");
-        render_requested = true;
-        term_render_requested = true;
+        requestRender(RENDER_EDITOR | RENDER_TERMINAL);
         SERIAL_LOGLN("BT: client disconnected");
     }
 
@@ -300,8 +310,7 @@ class BtSecurityCallbacks : public BLESecurityCallbacks {
         } else {
             SERIAL_LOGF("BT: pair failed reason=0x%02X\n", auth_cmpl.fail_reason);
         }
-        render_requested = true;
-        term_render_requested = true;
+        requestRender(RENDER_EDITOR | RENDER_TERMINAL);
     }
 
     bool onConfirmPIN(uint32_t pin) override {
@@ -456,8 +465,7 @@ bool btSetEnabled(bool enabled) {
         config_bt_enabled = false;
         bt_bonded = false;
         bt_peer_addr[0] = '\0';
-        render_requested = true;
-        term_render_requested = true;
+        requestRender(RENDER_EDITOR | RENDER_TERMINAL);
         SERIAL_LOGLN("BT: disabled");
         return true;
     }
@@ -470,13 +478,11 @@ bool btSetEnabled(bool enabled) {
     }
     if (!bt_initialized) {
         config_bt_enabled = false;
-        render_requested = true;
-        term_render_requested = true;
+        requestRender(RENDER_EDITOR | RENDER_TERMINAL);
         SERIAL_LOGLN("BT: enable failed");
         return false;
     }
-    render_requested = true;
-    term_render_requested = true;
+    requestRender(RENDER_EDITOR | RENDER_TERMINAL);
     return true;
 }
 
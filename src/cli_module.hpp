@@ -127,7 +127,7 @@ static int listRemoteFiles() {
     return file_list_count;
 }
 
-// Load a remote file into text_buf
+// Load a remote file into the notepad document
 static bool loadRemoteFile(const char* name) {
     char url[256];
     mountFileUrl(url, sizeof(url), name);
@@ -136,23 +136,26 @@ static bool loadRemoteFile(const char* name) {
     if (code != 200) return false;
 
     int sz = body.length();
-    if (sz > MAX_TEXT_LEN) sz = MAX_TEXT_LEN;
-    memcpy(text_buf, body.c_str(), sz);
-    text_buf[sz] = '\0';
-    text_len = sz;
-    cursor_pos = text_len;
+    char* data = (char*)textAlloc(sz + 1);
+    if (!data) return false;
+    memcpy(data, body.c_str(), sz);
+    body = String();
+    if (!textAdoptOriginal(data, sz)) return false;
     scroll_line = 0;
     file_modified = false;
     file_is_remote = true;
     return true;
 }
 
-// Save text_buf to remote file
+// Save the notepad document to remote file
 static bool saveRemoteFile(const char* name) {
     char url[256];
     mountFileUrl(url, sizeof(url), name);
+    char* body = textFlattenAlloc();
+    if (!body) return false;
     String resp;
-    int code = httpPut(url, text_buf, text_len, &resp);
+    int code = httpPut(url, body, text_len, &resp);
+    free(body);
     if (code == 200) {
         file_modified = false;
         return true;
@@ -228,14 +231,14 @@ void finishWifiScanCommand() {
     if (n == WIFI_SCAN_FAILED) {
         cmdSetResult("Scan failed");
         WiFi.scanDelete();
-        render_requested = true;
+        requestRender(RENDER_EDITOR);
         return;
     }
 
     if (n <= 0) {
         cmdSetResult("No WiFi networks found");
         WiFi.scanDelete();
-        render_requested = true;
+        requestRender(RENDER_EDITOR);
         return;
     }
 
@@ -253,13 +256,13 @@ void finishWifiScanCommand() {
 
     WiFi.scanDelete();
     if (!cmdWifiPickerStart()) {
-        render_requested = true;
+        requestRender(RENDER_EDITOR);
         return;
     }
     if (hidden > 0) {
         cmdAddLine("+%d hidden SSID(s)", hidden);
     }
-    render_requested = true;
+    requestRender(RENDER_EDITOR);
 }
 
 void wifiScanPoll() {
@@ -295,7 +298,7 @@ void maybeTransferUiRefresh(volatile uint32_t* last_ms) {
     uint32_t now = millis();
     if (now - *last_ms >= 250) {
         *last_ms = now;
-        render_requested = true;
+        requestRender(RENDER_EDITOR);
     }
 }
 
@@ -313,33 +316,33 @@ bool isSafeTransferName(const char* name) {
     return true;
 }
 
-bool sshWriteAll(ssh_channel channel, const uint8_t* data, size_t len) {
-    size_t offset = 0;
-    while (offset < len) {
-        int n = ssh_channel_write(channel, data + offset, len - offset);
-        if (n <= 0) return false;
-        offset += (size_t)n;
-    }
-    return true;
+// Exec channel I/O goes through the session owner (ssh_mux_module), so
+// the interactive shell keeps running during transfers.
+bool sshWriteAll(SshMuxChannel* channel, const uint8_t* data, size_t len) {
+    return sshMuxWrite(channel, data, len);
 }
 
-bool sshReadExact(ssh_channel channel, uint8_t* out, size_t len) {
+bool sshReadExact(SshMuxChannel* channel, uint8_t* out, size_t len) {
     size_t offset = 0;
     while (offset < len) {
-        int n = ssh_channel_read(channel, out + offset, len - offset, 0);
+        int n = sshMuxRead(channel, out + offset, len - offset, SSH_MUX_IO_TIMEOUT_MS);
         if (n <= 0) return false;
         offset += (size_t)n;
     }
     return true;
 }
 
-bool sshReadLine(ssh_channel channel, char* out, size_t out_len) {
+bool sshReadLineWithTimeout(SshMuxChannel* channel, char* out, size_t out_len, uint32_t timeout_ms) {
     if (!out || out_len < 2) return false;
     size_t pos = 0;
+    uint32_t start_ms = millis();
     while (true) {
+        uint32_t elapsed = (uint32_t)(millis() - start_ms);
+        if (elapsed >= timeout_ms) return false;
         char c = 0;
-        int n = ssh_channel_read(channel, &c, 1, 0);
-        if (n <= 0) return false;
+        int n = sshMuxRead(channel, (uint8_t*)&c, 1, timeout_ms - elapsed);
+        if (n < 0) return false;
+        if (n == 0) continue;
         if (c == '\r') continue;
         if (c == '\n') {
             out[pos] = '\0';
@@ -350,53 +353,19 @@ bool sshReadLine(ssh_channel channel, char* out, size_t out_len) {
     }
 }
 
-bool sshReadLineWithTimeout(ssh_channel channel, char* out, size_t out_len, uint32_t timeout_ms) {
-    if (!out || out_len < 2) return false;
-    size_t pos = 0;
-    uint32_t start_ms = millis();
-    while ((uint32_t)(millis() - start_ms) < timeout_ms) {
-        char c = 0;
-        int n = ssh_channel_read_nonblocking(channel, &c, 1, 0);
-        if (n > 0) {
-            if (c == '\r') continue;
-            if (c == '\n') {
-                out[pos] = '\0';
-                return true;
-            }
-            if (pos + 1 >= out_len) return false;
-            out[pos++] = c;
-            continue;
-        }
-        if (n == SSH_ERROR || ssh_channel_is_eof(channel)) return false;
-        vTaskDelay(pdMS_TO_TICKS(5));
-    }
-    return false;
+bool sshReadLine(SshMuxChannel* channel, char* out, size_t out_len) {
+    return sshReadLineWithTimeout(channel, out, out_len, SSH_MUX_IO_TIMEOUT_MS);
 }
 
-bool sshOpenExecChannel(const char* command, ssh_channel* out_channel) {
-    if (!ssh_connected || !ssh_sess || !command || !out_channel) return false;
-    ssh_channel channel = ssh_channel_new(ssh_sess);
-    if (!channel) return false;
-    if (ssh_channel_open_session(channel) != SSH_OK) {
-        ssh_channel_free(channel);
-        return false;
-    }
-    if (ssh_channel_request_exec(channel, command) != SSH_OK) {
-        ssh_channel_close(channel);
-        ssh_channel_free(channel);
-        return false;
-    }
-    *out_channel = channel;
-    return true;
+SshMuxOpenResult sshOpenExecChannel(const char* command, SshMuxChannel** out_channel) {
+    SshMuxOpenResult result = SSH_MUX_NO_SESSION;
+    if (!out_channel) return result;
+    *out_channel = sshMuxOpenExec(command, NULL, NULL, &result);
+    return result;
 }
 
-int sshCloseExecChannel(ssh_channel channel) {
-    if (!channel) return -1;
-    ssh_channel_send_eof(channel);
-    ssh_channel_close(channel);
-    int exit_status = ssh_channel_get_exit_status(channel);
-    ssh_channel_free(channel);
-    return exit_status;
+int sshCloseExecChannel(SshMuxChannel* channel) {
+    return sshMuxClose(channel);
 }
 
 bool ensureSshForTransfer(const char* action_label) {
@@ -407,7 +376,7 @@ bool ensureSshForTransfer(const char* action_label) {
     }
 
     cmdSetResult("%s: connecting SSH...", action_label);
-    render_requested = true;
+    requestRender(RENDER_EDITOR);
 
     uint32_t start_ms = millis();
     while (!ssh_connected) {
@@ -418,37 +387,31 @@ bool ensureSshForTransfer(const char* action_label) {
 
     if (!ssh_connected || !ssh_sess) {
         cmdSetResult("%s failed: SSH connect failed", action_label);
-        render_requested = true;
+        requestRender(RENDER_EDITOR);
         return false;
     }
     return true;
 }
 
-void pauseSshReceiveTaskForExec(bool* out_paused) {
-    if (!out_paused) return;
-    if (ssh_recv_task_handle) {
-        vTaskDelete(ssh_recv_task_handle);
-        ssh_recv_task_handle = NULL;
-        *out_paused = true;
-    }
-}
-
-void resumeSshReceiveTaskForExec(bool was_paused) {
-    if (!was_paused) return;
-    if (!ssh_recv_task_handle && ssh_connected && ssh_chan) {
-        xTaskCreatePinnedToCore(
-            sshReceiveTask,
-            "ssh_recv",
-            16384,
-            NULL,
-            1,
-            &ssh_recv_task_handle,
-            0
-        );
+// Open an exec channel for a transfer. Reconnects once when the session
+// turned out to be dead (common after long transfers); busy channels or a
+// refused command leave the shell alone and just report the reason.
+bool sshOpenExecForTransfer(const char* command, const char* action_label, SshMuxChannel** out_channel) {
+    SshMuxOpenResult result = sshOpenExecChannel(command, out_channel);
+    if (result == SSH_MUX_SESSION_LOST || result == SSH_MUX_NO_SESSION) {
+        char retry_label[32];
+        snprintf(retry_label, sizeof(retry_label), "%s retry", action_label);
+        sshDisconnect();
+        if (!ensureSshForTransfer(retry_label)) return false;
+        result = sshOpenExecChannel(command, out_channel);
     }
+    if (result == SSH_MUX_OPENED) return true;
+    cmdSetResult("%s start failed: %s", action_label, sshMuxOpenResultText(result));
+    requestRender(RENDER_EDITOR);
+    return false;
 }
 
-bool uploadStreamFile(ssh_channel channel, const char* file_name) {
+bool uploadStreamFile(SshMuxChannel* channel, const char* file_name) {
     if (!isSafeTransferName(file_name)) return false;
 
     String path = "/" + String(file_name);
@@ -637,7 +600,7 @@ bool parseDownloadHeader(const char* line, size_t* out_size, char* out_name, siz
     return true;
 }
 
-bool downloadStreamFile(ssh_channel channel, const char* file_name, size_t file_size) {
+bool downloadStreamFile(SshMuxChannel* channel, const char* file_name, size_t file_size) {
     String path = "/" + String(file_name);
     uint8_t buf[TRANSFER_CHUNK_SIZE];
     size_t remaining = file_size;
@@ -728,13 +691,13 @@ void uploadTask(void* param) {
     upload_started_ms = millis();
     upload_last_ui_ms = upload_started_ms;
 
+    // Base files must be complete on SD before they are read.
+    storageWaitIdle();
     if (!ensureSshForTransfer("Upload")) {
         upload_running = false;
         vTaskDelete(NULL);
         return;
     }
-    bool paused_recv = false;
-    pauseSshReceiveTaskForExec(&paused_recv);
 
     // List flat files at root
     int n = listDirectory("/");
@@ -747,27 +710,13 @@ void uploadTask(void* param) {
         }
     }
     cmdSetResult("Uploading %d files...", upload_total_count);
-    render_requested = true;
+    requestRender(RENDER_EDITOR);
 
-    ssh_channel channel = NULL;
-    if (!sshOpenExecChannel(REMOTE_UPLOAD_STREAM_CMD, &channel)) {
-        // Recover from stale/broken SSH sessions.
-        sshDisconnect();
-        if (!ensureSshForTransfer("Upload retry")) {
-            resumeSshReceiveTaskForExec(paused_recv);
-            upload_running = false;
-            vTaskDelete(NULL);
-            return;
-        }
-        pauseSshReceiveTaskForExec(&paused_recv);
-        if (!sshOpenExecChannel(REMOTE_UPLOAD_STREAM_CMD, &channel)) {
-            cmdSetResult("Upload start failed: %s", ssh_get_error(ssh_sess));
-            render_requested = true;
-            resumeSshReceiveTaskForExec(paused_recv);
-            upload_running = false;
-            vTaskDelete(NULL);
-            return;
-        }
+    SshMuxChannel* channel = NULL;
+    if (!sshOpenExecForTransfer(REMOTE_UPLOAD_STREAM_CMD, "Upload", &channel)) {
+        upload_running = false;
+        vTaskDelete(NULL);
+        return;
     }
 
     bool stream_ok = true;
@@ -779,14 +728,14 @@ void uploadTask(void* param) {
             break;
         }
         upload_done_count++;
-        render_requested = true;
+        requestRender(RENDER_EDITOR);
     }
 
     if (stream_ok) {
         const char done[] = "DONE\n";
         stream_ok = sshWriteAll(channel, (const uint8_t*)done, sizeof(done) - 1);
     }
-    ssh_channel_send_eof(channel);
+    sshMuxSendEof(channel);
 
     char reply[TRANSFER_LINE_MAX];
     bool got_reply = stream_ok && sshReadLine(channel, reply, sizeof(reply));
@@ -797,8 +746,7 @@ void uploadTask(void* param) {
     } else {
         cmdSetResult("Upload failed (%d/%d)", upload_done_count, upload_total_count);
     }
-    render_requested = true;
-    resumeSshReceiveTaskForExec(paused_recv);
+    requestRender(RENDER_EDITOR);
     upload_running = false;
     vTaskDelete(NULL);
 }
@@ -812,6 +760,7 @@ void downloadTask(void* param) {
     download_started_ms = millis();
     download_last_ui_ms = download_started_ms;
 
+    storageWaitIdle();
     if (!ensureSshForTransfer("Download")) {
         download_running = false;
         vTaskDelete(NULL);
@@ -819,39 +768,22 @@ void downloadTask(void* param) {
     }
     if (!resetDownloadManifest()) {
         cmdSetResult("Download prep failed");
-        render_requested = true;
+        requestRender(RENDER_EDITOR);
         download_running = false;
         vTaskDelete(NULL);
         return;
     }
-    bool paused_recv = false;
-    pauseSshReceiveTaskForExec(&paused_recv);
 
-    ssh_channel channel = NULL;
-    if (!sshOpenExecChannel(REMOTE_DOWNLOAD_STREAM_CMD, &channel)) {
-        // Recover from stale/broken SSH sessions.
-        sshDisconnect();
-        if (!ensureSshForTransfer("Download retry")) {
-            cleanupDownloadManifest();
-            resumeSshReceiveTaskForExec(paused_recv);
-            download_running = false;
-            vTaskDelete(NULL);
-            return;
-        }
-        pauseSshReceiveTaskForExec(&paused_recv);
-        if (!sshOpenExecChannel(REMOTE_DOWNLOAD_STREAM_CMD, &channel)) {
-            cmdSetResult("Download start failed: %s", ssh_get_error(ssh_sess));
-            render_requested = true;
-            cleanupDownloadManifest();
-            resumeSshReceiveTaskForExec(paused_recv);
-            download_running = false;
-            vTaskDelete(NULL);
-            return;
-        }
+    SshMuxChannel* channel = NULL;
+    if (!sshOpenExecForTransfer(REMOTE_DOWNLOAD_STREAM_CMD, "Download", &channel)) {
+        cleanupDownloadManifest();
+        download_running = false;
+        vTaskDelete(NULL);
+        return;
     }
 
     cmdSetResult("Downloading...");
-    render_requested = true;
+    requestRender(RENDER_EDITOR);
 
     bool stream_ok = true;
     bool saw_done = false;
@@ -882,7 +814,7 @@ void downloadTask(void* param) {
                 break;
             }
             download_done_count++;
-            render_requested = true;
+            requestRender(RENDER_EDITOR);
         } else {
             stream_ok = false;
         }
@@ -903,8 +835,7 @@ void downloadTask(void* param) {
     } else {
         cmdSetResult("Download failed (%d/%d)", download_done_count, download_total_count);
     }
-    render_requested = true;
-    resumeSshReceiveTaskForExec(paused_recv);
+    requestRender(RENDER_EDITOR);
     download_running = false;
     vTaskDelete(NULL);
 }
@@ -919,6 +850,9 @@ bool startUploadTransfer() {
         return false;
     }
 
+    // Uploads read base files from SD; fold the open file's journal first.
+    journalFoldCurrent();
+
     // Mark running before scheduling task so shortcut "wait upload" cannot race.
     upload_running = true;
     BaseType_t rc = xTaskCreatePinnedToCore(
@@ -1094,7 +1028,7 @@ bool shortcutWaitForFlagClear(volatile bool* flag, const char* label) {
     while (*flag) {
         if ((uint32_t)(millis() - start) >= SHORTCUT_WAIT_TIMEOUT_MS) {
             cmdSetResult("Shortcut timeout: %s", label);
-            render_requested = true;
+            requestRender(RENDER_EDITOR);
             return false;
         }
         vTaskDelay(pdMS_TO_TICKS(100));
@@ -1109,37 +1043,8 @@ bool runShortcutRemoteCommand(const char* remote_cmd) {
     }
     if (!ensureSshForTransfer("Remote")) return false;
 
-    bool paused_recv = false;
-    if (ssh_recv_task_handle) {
-        vTaskDelete(ssh_recv_task_handle);
-        ssh_recv_task_handle = NULL;
-        paused_recv = true;
-    }
-    auto resumeRecvTask = [&]() {
-        if (!paused_recv) return;
-        if (!ssh_recv_task_handle && ssh_connected && ssh_chan) {
-            xTaskCreatePinnedToCore(
-                sshReceiveTask,
-                "ssh_recv",
-                16384,
-                NULL,
-                1,
-                &ssh_recv_task_handle,
-                0
-            );
-        }
-    };
-
-    ssh_channel channel = NULL;
-    if (!sshOpenExecChannel("/bin/sh -s", &channel)) {
-        // Recover from stale/broken SSH sessions (common after long transfers).
-        sshDisconnect();
-        if (!ensureSshForTransfer("Remote retry") || !sshOpenExecChannel("/bin/sh -s", &channel)) {
-            cmdSetResult("Remote start failed: %s", ssh_get_error(ssh_sess));
-            resumeRecvTask();
-            return false;
-        }
-    }
+    SshMuxChannel* channel = NULL;
+    if (!sshOpenExecForTransfer("/bin/sh -s", "Remote", &channel)) return false;
 
     char script[SHORTCUT_STEP_MAX + 96];
     int script_len = snprintf(
@@ -1153,16 +1058,14 @@ bool runShortcutRemoteCommand(const char* remote_cmd) {
     if (script_len <= 0 || script_len >= (int)sizeof(script)) {
         sshCloseExecChannel(channel);
         cmdSetResult("Remote cmd too long");
-        resumeRecvTask();
         return false;
     }
     if (!sshWriteAll(channel, (const uint8_t*)script, (size_t)script_len)) {
         sshCloseExecChannel(channel);
         cmdSetResult("Remote write failed");
-        resumeRecvTask();
         return false;
     }
-    ssh_channel_send_eof(channel);
+    sshMuxSendEof(channel);
 
     bool got_marker = false;
     int remote_rc = -1;
@@ -1180,7 +1083,7 @@ bool runShortcutRemoteCommand(const char* remote_cmd) {
 
         char line[TRANSFER_LINE_MAX];
         if (!sshReadLineWithTimeout(channel, line, sizeof(line), slice_ms)) {
-            if (ssh_channel_is_eof(channel)) break;
+            if (sshMuxIsEof(channel)) break;
             continue;
         }
         line_reads++;
@@ -1193,37 +1096,30 @@ bool runShortcutRemoteCommand(const char* remote_cmd) {
     int exit_status = sshCloseExecChannel(channel);
     if (timed_out) {
         cmdSetResult("Remote timeout");
-        resumeRecvTask();
         return false;
     }
     if (!got_marker) {
         if (exit_status == 0) {
             cmdSetResult("Remote OK");
-            resumeRecvTask();
             return true;
         }
         if (exit_status > 0) {
             cmdSetResult("Remote failed (%d)", exit_status);
-            resumeRecvTask();
             return false;
         }
         cmdSetResult("Remote no status");
-        resumeRecvTask();
         return false;
     }
     if (remote_rc != 0) {
         cmdSetResult("Remote failed (%d)", remote_rc);
-        resumeRecvTask();
         return false;
     }
     if (exit_status != 0) {
         cmdSetResult("Remote shell failed (%d)", exit_status);
-        resumeRecvTask();
         return false;
     }
 
     cmdSetResult("Remote OK");
-    resumeRecvTask();
     return true;
 }
 
@@ -1307,14 +1203,14 @@ void shortcutTask(void* param) {
     if (!loadShortcutSteps(path, steps, &step_count, &parse_error_line)) {
         if (parse_error_line > 0) cmdSetResult("Shortcut parse fail L%d", parse_error_line);
         else cmdSetResult("Shortcut load failed: %s", name);
-        render_requested = true;
+        requestRender(RENDER_EDITOR);
         shortcut_running = false;
         vTaskDelete(NULL);
         return;
     }
     if (step_count <= 0) {
         cmdSetResult("Shortcut empty: %s", name);
-        render_requested = true;
+        requestRender(RENDER_EDITOR);
         shortcut_running = false;
         vTaskDelete(NULL);
         return;
@@ -1322,10 +1218,10 @@ void shortcutTask(void* param) {
 
     for (int i = 0; i < step_count; i++) {
         cmdSetResult("Run %s %d/%d", name, i + 1, step_count);
-        render_requested = true;
+        requestRender(RENDER_EDITOR);
         if (!executeShortcutStep(steps[i])) {
             if (!cmd_result_valid) cmdSetResult("Shortcut failed %s L%d", name, i + 1);
-            render_requested = true;
+            requestRender(RENDER_EDITOR);
             shortcut_running = false;
             vTaskDelete(NULL);
             return;
@@ -1333,7 +1229,7 @@ void shortcutTask(void* param) {
     }
 
     cmdSetResult("Shortcut done: %s", name);
-    render_requested = true;
+    requestRender(RENDER_EDITOR);
     shortcut_running = false;
     vTaskDelete(NULL);
 }
@@ -1910,7 +1806,7 @@ void finishGnssScanCommand() {
                snap.checksum_failures,
                snap.parse_failures);
     gnss_scan_pending = false;
-    render_requested = true;
+    requestRender(RENDER_EDITOR);
 }
 
 void gnssScanPoll() {
@@ -1934,7 +1830,7 @@ void finishMeshtasticScanCommand() {
     if (!meshtasticScanStatus(&snap)) {
         meshtastic_scan_pending = false;
         cmdSetResult("MSS failed");
-        render_requested = true;
+        requestRender(RENDER_EDITOR);
         return;
     }
     meshtastic_scan_pending = false;
@@ -1983,7 +1879,7 @@ void finishMeshtasticScanCommand() {
                (unsigned long)state.scan_count,
                (unsigned long)state.scan_fail_count);
     if (!snap.ok && snap.error[0] != '\0') cmdAddLine("Why:%s", snap.error);
-    render_requested = true;
+    requestRender(RENDER_EDITOR);
 }
 
 void meshtasticScanPoll() {
@@ -2075,7 +1971,7 @@ void finishModemScanCommand() {
     if (snap.cops[0] != '\0') cmdAddLine("%s", snap.cops);
     if (!snap.ok && snap.error[0] != '\0') cmdAddLine("Err:%s", snap.error);
 
-    render_requested = true;
+    requestRender(RENDER_EDITOR);
 }
 
 void modemScanPoll() {
@@ -2095,7 +1991,7 @@ void modemPowerNotifyPoll() {
     } else {
         cmdSetResult("Modem failed: %s", modemLastError()[0] ? modemLastError() : "err");
     }
-    render_requested = true;
+    requestRender(RENDER_EDITOR);
 }
 
 void modemScanCommand() {
@@ -2123,7 +2019,7 @@ void finishBtScanCommand() {
 
     if (!ok) {
         cmdSetResult("BT scan failed");
-        render_requested = true;
+        requestRender(RENDER_EDITOR);
         return;
     }
 
@@ -2137,7 +2033,7 @@ void finishBtScanCommand() {
         cmdAddLine("%c %s %ddBm", found[i].has_name ? '*' : ' ', label, found[i].rssi);
     }
     if (total > shown) cmdAddLine("... +%d more", total - shown);
-    render_requested = true;
+    requestRender(RENDER_EDITOR);
 }
 
 void btScanPoll() {
@@ -2180,10 +2076,8 @@ void dailyOpenCommand() {
             current_file = String("/") + String(name);
             cmdSetResult("Daily %s (%d B)", name, text_len);
         } else {
-            text_len = 0;
-            cursor_pos = 0;
+            textClear();
             scroll_line = 0;
-            text_buf[0] = '\0';
             current_file = String("/") + String(name);
             file_is_remote = true;
             file_modified = false;
@@ -2195,10 +2089,8 @@ void dailyOpenCommand() {
             current_file = path;
             cmdSetResult("Daily %s (%d B)", name, text_len);
         } else {
-            text_len = 0;
-            cursor_pos = 0;
+            textClear();
             scroll_line = 0;
-            text_buf[0] = '\0';
             current_file = path;
             file_modified = false;
             cmdSetResult("Daily new %s", name);
@@ -2219,6 +2111,27 @@ void clockDateCommand() {
     cmdSetResult("%s (%s)", stamp, timeSyncSourceName(time_sync_source));
 }
 
+// `/pattern` searches the terminal scrollback backwards from the newest line
+// and shows the match on the top row; a bare `/` repeats the last search
+// further back.
+static void cmdSearchScrollback(const char* pat) {
+    xSemaphoreTake(state_mutex, portMAX_DELAY);
+    termLock();
+    int total = 0;
+    int line = termSearch(pat, &total);
+    termUnlock();
+    if (line >= 0) app_mode = MODE_TERMINAL;
+    xSemaphoreGive(state_mutex);
+
+    if (!term_search_pat[0]) {
+        cmdSetResult("Usage: /pattern");
+    } else if (line < 0) {
+        cmdSetResult("/%s: no match", term_search_pat);
+    } else {
+        cmdSetResult("/%s: line %d of %d", term_search_pat, line + 1, total);
+    }
+}
+
 bool executeCommand(const char* cmd) {
     // Parse command word and argument
     char word[CMD_BUF_LEN + 1];
@@ -2228,6 +2141,10 @@ bool executeCommand(const char* cmd) {
 
     while (*cmd == ' ') cmd++;
     if (*cmd == '\0') { cmd_result_valid = false; return false; }
+    if (*cmd == '/') {
+        cmdSearchScrollback(cmd + 1);
+        return true;
+    }
     bool recognized = true;
 
     int wi = 0;
@@ -2266,8 +2183,8 @@ bool executeCommand(const char* cmd) {
                 cmdSetResult("Remote %s (%d B)", arg, text_len);
                 app_mode = MODE_NOTEPAD;
             } else {
-                text_len = 0; cursor_pos = 0; scroll_line = 0;
-                text_buf[0] = '\0';
+                textClear();
+                scroll_line = 0;
                 current_file = String("/") + String(arg);
                 file_is_remote = true;
                 file_modified = false;
@@ -2283,8 +2200,8 @@ bool executeCommand(const char* cmd) {
                 cmdSetResult("Loaded %s (%d B)", arg, text_len);
                 app_mode = MODE_NOTEPAD;
             } else {
-                text_len = 0; cursor_pos = 0; scroll_line = 0;
-                text_buf[0] = '\0';
+                textClear();
+                scroll_line = 0;
                 current_file = path;
                 file_modified = false;
                 cmdSetResult("New: %s", arg);
@@ -2312,11 +2229,8 @@ bool executeCommand(const char* cmd) {
             } else if (current_file.length() == 0) {
                 current_file = "/UNSAVED";
             }
-            if (saveToFile(current_file.c_str())) {
-                cmdSetResult("Saved %s (%d B)", current_file.c_str(), text_len);
-            } else {
-                cmdSetResult("Save failed");
-            }
+            // Reports "Saving ..."; the storage worker posts the outcome.
+            saveToFile(current_file.c_str());
         }
     } else if (strcmp(word, "daily") == 0) {
         dailyOpenCommand();
@@ -2364,6 +2278,8 @@ bool executeCommand(const char* cmd) {
             String path = "/" + String(arg);
             sdAcquire();
             bool ok = SD.remove(path.c_str());
+            SD.remove(journalSidecarPath(path.c_str(), ".jnl").c_str());
+            if (ok && jnl_base_path == path) journalDetach();
             sdRelease();
             cmdSetResult(ok ? "Removed %s" : "Failed: %s", arg);
         }
@@ -2379,20 +2295,33 @@ bool executeCommand(const char* cmd) {
         } else if (!ssh_connected || !ssh_chan) {
             cmdSetResult("SSH not connected");
         } else {
-            for (int i = 0; i < text_len; i += 64) {
-                int chunk = (text_len - i > 64) ? 64 : (text_len - i);
-                ssh_channel_write(ssh_chan, &text_buf[i], chunk);
-                vTaskDelay(pdMS_TO_TICKS(10));
+            for (int i = 0; i < text_len;) {
+                const char* run;
+                int chunk = textRunAt(i, &run);
+                sshSendString(run, chunk);
+                i += chunk;
             }
             cmdSetResult("Pasted %d chars", text_len);
         }
     } else if (strcmp(word, "ssh") == 0) {
         app_mode = MODE_TERMINAL;
+        // `ssh <host>` points this session at another host (config user/port).
+        if (arg[0] != '\0' && !ssh_connecting && strcmp(arg, ssh_target_host) != 0) {
+            if (ssh_connected) sshDisconnect();
+            strncpy(ssh_target_host, arg, sizeof(ssh_target_host) - 1);
+            ssh_target_host[sizeof(ssh_target_host) - 1] = '\0';
+        }
         if (!ssh_connected && !ssh_connecting) {
             sshConnectAsync();
         }
     } else if (strcmp(word, "np") == 0) {
         app_mode = MODE_NOTEPAD;
+    } else if (strcmp(word, "le") == 0) {
+        termLock();
+        term_line_enabled = !term_line_enabled;
+        termLineClear();
+        termUnlock();
+        cmdSetResult("Line edit %s", term_line_enabled ? "on" : "off");
     } else if (strcmp(word, "dc") == 0) {
         sshDisconnect();
         cmdSetResult("Disconnected");
@@ -2566,10 +2495,10 @@ bool executeCommand(const char* cmd) {
         cmdClearResult();
         cmdAddLine("l/ls e/edit w/save daily r/rm");
         cmdAddLine("mount umount push");
-        cmdAddLine("u/upload d/download p/paste ssh np dc");
+        cmdAddLine("u/upload d/download p/paste ssh [host] np dc le");
         cmdAddLine("ws wfi bs bt gs/gpss gps mds mdm msh mss");
         cmdAddLine("mss tx <text> / !<node> <text>");
-        cmdAddLine("date s/status h/help");
+        cmdAddLine("date s/status h/help /pat (search term)");
         cmdAddLine("<name> runs /name.x shortcut");
     } else {
         if (arg[0] == '\0' && shortcut_running) {
@@ -2675,101 +2604,96 @@ bool handleCommandKeyPress(int event_code) {
 }
 
 void renderCommandPrompt() {
-    partial_count++;
     // Half screen: top half stays (notepad/terminal content), bottom half is command area
     int cmd_area_y = SCREEN_H / 2;
     int region_h = SCREEN_H - cmd_area_y;
 
-    display.setPartialWindow(0, cmd_area_y, SCREEN_W, region_h);
-    display.firstPage();
-    do {
-        display.fillScreen(GxEPD_WHITE);
-        display.setTextColor(GxEPD_BLACK);
-        display.setFont(NULL);
+    fbBeginDraw();
+    frame_canvas.fillRect(0, cmd_area_y, SCREEN_W, region_h, GxEPD_WHITE);
 
-        // Separator line
-        display.drawLine(0, cmd_area_y, SCREEN_W, cmd_area_y, GxEPD_BLACK);
+    // Separator line
+    frame_canvas.drawLine(0, cmd_area_y, SCREEN_W, cmd_area_y, GxEPD_BLACK);
 
-        int y = cmd_area_y + 2;
+    int y = cmd_area_y + 2;
 
-        // Show multi-line result
-        if (cmd_result_valid) {
-            for (int i = 0; i < cmd_result_count; i++) {
-                display.setCursor(MARGIN_X, y);
-                display.print(cmd_result[i]);
-                y += CHAR_H;
-                if (y >= SCREEN_H - STATUS_H - CHAR_H - 2) break;
-            }
+    // Show multi-line result
+    if (cmd_result_valid) {
+        for (int i = 0; i < cmd_result_count; i++) {
+            frame_canvas.setCursor(MARGIN_X, y);
+            frame_canvas.print(cmd_result[i]);
+            y += CHAR_H;
+            if (y >= SCREEN_H - STATUS_H - CHAR_H - 2) break;
         }
+    }
 
-        // Draw prompt line at bottom of command area (above status bar)
-        int py = SCREEN_H - STATUS_H - CHAR_H - 2;
-        display.setCursor(MARGIN_X, py);
-        if (cmdPickerIsActive()) {
-            display.print("> ");
-            display.print(cmdPickerPromptWord());
-        } else {
-            display.print("> ");
-            display.print(cmd_buf);
-            // Cursor
-            int cx = MARGIN_X + (cmd_len + 2) * CHAR_W;
-            display.fillRect(cx, py - 1, CHAR_W, CHAR_H, GxEPD_BLACK);
-        }
-
-        // Status bar
-        int bar_y = SCREEN_H - STATUS_H;
-        display.fillRect(0, bar_y, SCREEN_W, STATUS_H, GxEPD_BLACK);
-        display.setTextColor(GxEPD_WHITE);
-        display.setFont(NULL);
-        char status_left[72];
+    // Draw prompt line at bottom of command area (above status bar)
+    int py = SCREEN_H - STATUS_H - CHAR_H - 2;
+    frame_canvas.setCursor(MARGIN_X, py);
+    if (cmdPickerIsActive()) {
+        frame_canvas.print("> ");
+        frame_canvas.print(cmdPickerPromptWord());
+    } else {
+        frame_canvas.print("> ");
+        frame_canvas.print(cmd_buf);
+        // Cursor
+        int cx = MARGIN_X + (cmd_len + 2) * CHAR_W;
+        frame_canvas.fillRect(cx, py - 1, CHAR_W, CHAR_H, GxEPD_BLACK);
+    }
+
+    // Status bar
+    int bar_y = SCREEN_H - STATUS_H;
+    frame_canvas.fillRect(0, bar_y, SCREEN_W, STATUS_H, GxEPD_BLACK);
+    frame_canvas.setTextColor(GxEPD_WHITE);
+    frame_canvas.setFont(NULL);
+    char status_left[72];
+    status_left[0] = '\0';
+    bool show_runtime = false;
+    if (upload_running) {
+        uint32_t done = upload_bytes_done;
+        uint32_t total = upload_bytes_total;
+        uint32_t elapsed_ms = millis() - upload_started_ms;
+        uint32_t rate = (elapsed_ms > 0)
+            ? (uint32_t)(((uint64_t)done * 1000ULL) / elapsed_ms)
+            : 0;
+        char done_s[12], total_s[12], rate_s[12];
+        char ul[56];
+        formatBytesCompact(done, done_s, sizeof(done_s));
+        formatBytesCompact(total, total_s, sizeof(total_s));
+        formatBytesCompact(rate, rate_s, sizeof(rate_s));
+        snprintf(ul, sizeof(ul), "U %d/%d %s/%s %s/s",
+                 (int)upload_done_count, (int)upload_total_count,
+                 done_s, total_s, rate_s);
+        snprintf(status_left, sizeof(status_left), "%s", ul);
+    } else if (download_running) {
+        uint32_t done = download_bytes_done;
+        uint32_t total = download_bytes_total;
+        uint32_t elapsed_ms = millis() - download_started_ms;
+        uint32_t rate = (elapsed_ms > 0)
+            ? (uint32_t)(((uint64_t)done * 1000ULL) / elapsed_ms)
+            : 0;
+        char done_s[12], total_s[12], rate_s[12];
+        char dl[56];
+        formatBytesCompact(done, done_s, sizeof(done_s));
+        formatBytesCompact(total, total_s, sizeof(total_s));
+        formatBytesCompact(rate, rate_s, sizeof(rate_s));
+        snprintf(dl, sizeof(dl), "D %d/%d %s/%s %s/s",
+                 (int)download_done_count, (int)download_total_count,
+                 done_s, total_s, rate_s);
+        snprintf(status_left, sizeof(status_left), "%s", dl);
+    } else if (shortcut_running) {
+        snprintf(status_left, sizeof(status_left), "[RUN] shortcut...");
+    } else if (cmdPickerIsActive()) {
+        snprintf(status_left, sizeof(status_left), "%s", cmdPickerStatusHint());
+    } else {
         status_left[0] = '\0';
-        bool show_runtime = false;
-        if (upload_running) {
-            uint32_t done = upload_bytes_done;
-            uint32_t total = upload_bytes_total;
-            uint32_t elapsed_ms = millis() - upload_started_ms;
-            uint32_t rate = (elapsed_ms > 0)
-                ? (uint32_t)(((uint64_t)done * 1000ULL) / elapsed_ms)
-                : 0;
-            char done_s[12], total_s[12], rate_s[12];
-            char ul[56];
-            formatBytesCompact(done, done_s, sizeof(done_s));
-            formatBytesCompact(total, total_s, sizeof(total_s));
-            formatBytesCompact(rate, rate_s, sizeof(rate_s));
-            snprintf(ul, sizeof(ul), "U %d/%d %s/%s %s/s",
-                     (int)upload_done_count, (int)upload_total_count,
-                     done_s, total_s, rate_s);
-            snprintf(status_left, sizeof(status_left), "%s", ul);
-        } else if (download_running) {
-            uint32_t done = download_bytes_done;
-            uint32_t total = download_bytes_total;
-            uint32_t elapsed_ms = millis() - download_started_ms;
-            uint32_t rate = (elapsed_ms > 0)
-                ? (uint32_t)(((uint64_t)done * 1000ULL) / elapsed_ms)
-                : 0;
-            char done_s[12], total_s[12], rate_s[12];
-            char dl[56];
-            formatBytesCompact(done, done_s, sizeof(done_s));
-            formatBytesCompact(total, total_s, sizeof(total_s));
-            formatBytesCompact(rate, rate_s, sizeof(rate_s));
-            snprintf(dl, sizeof(dl), "D %d/%d %s/%s %s/s",
-                     (int)download_done_count, (int)download_total_count,
-                     done_s, total_s, rate_s);
-            snprintf(status_left, sizeof(status_left), "%s", dl);
-        } else if (shortcut_running) {
-            snprintf(status_left, sizeof(status_left), "[RUN] shortcut...");
-        } else if (cmdPickerIsActive()) {
-            snprintf(status_left, sizeof(status_left), "%s", cmdPickerStatusHint());
-        } else {
-            status_left[0] = '\0';
-            show_runtime = true;
-        }
+        show_runtime = true;
+    }
 
-        char status_right[48];
-        status_right[0] = '\0';
-        if (show_runtime) {
-            buildStatusRight(status_right, sizeof(status_right), true);
-        }
-        drawStatusBarLine(status_left, status_right, bar_y);
-    } while (display.nextPage());
+    char status_right[48];
+    status_right[0] = '\0';
+    if (show_runtime) {
+        buildStatusRight(status_right, sizeof(status_right), true);
+    }
+    drawStatusBarLine(status_left, status_right, bar_y);
+    fbPush();
 }
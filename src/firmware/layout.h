@@ -1,6 +1,5 @@
 #pragma once
 
-#define MAX_TEXT_LEN    4096
 #define CHAR_W          6
 #define CHAR_H          8
 #define MARGIN_X        0
@@ -11,5 +10,5 @@
 #define COLS_PER_LINE   ((SCREEN_W - MARGIN_X * 2) / CHAR_W)
 #define ROWS_PER_SCREEN ((SCREEN_H - MARGIN_Y - STATUS_H) / CHAR_H)
 
-#define TERM_ROWS       100
+#define TERM_ROWS       ROWS_PER_SCREEN  // live grid; older lines live in PSRAM scrollback
 #define TERM_COLS       COLS_PER_LINE
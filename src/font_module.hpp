@@ -0,0 +1,188 @@
+#pragma once
+
+// --- Glyph Blitter ---
+//
+// Text rows in the notepad and terminal are drawn straight into the
+// frame_canvas buffer instead of going through GFX print (which turns every
+// glyph into ~40 virtual drawPixel calls). The atlas is the classic GFX 5x7
+// font for printable ASCII, transposed at compile time from its column bytes
+// to one 6-bit row pattern per scanline (bit 5 = leftmost pixel, bit 0 = the
+// blank spacing column). Glyphs are placed exactly where GFX would put them:
+// 8 scanlines from the cursor y, so descenders still reach the row below.
+// Other bytes fall back to GFX drawChar.
+
+static constexpr uint8_t FONT_FIRST = 0x20;
+static constexpr uint8_t FONT_LAST = 0x7E;
+
+#define FONT_ROW(j, a, b, c, d, e) \
+    (uint8_t)(((((a) >> (j)) & 1) << 5) | ((((b) >> (j)) & 1) << 4) | ((((c) >> (j)) & 1) << 3) | \
+              ((((d) >> (j)) & 1) << 2) | ((((e) >> (j)) & 1) << 1))
+#define FONT_GLYPH(a, b, c, d, e) { \
+    FONT_ROW(0, a, b, c, d, e), FONT_ROW(1, a, b, c, d, e), FONT_ROW(2, a, b, c, d, e), FONT_ROW(3, a, b, c, d, e), \
+    FONT_ROW(4, a, b, c, d, e), FONT_ROW(5, a, b, c, d, e), FONT_ROW(6, a, b, c, d, e), FONT_ROW(7, a, b, c, d, e) }
+
+static constexpr uint8_t font_atlas[FONT_LAST - FONT_FIRST + 1][CHAR_H] = {
+    FONT_GLYPH(0x00, 0x00, 0x00, 0x00, 0x00),  // ' '
+    FONT_GLYPH(0x00, 0x00, 0x5F, 0x00, 0x00),  // !
+    FONT_GLYPH(0x00, 0x07, 0x00, 0x07, 0x00),  // "
+    FONT_GLYPH(0x14, 0x7F, 0x14, 0x7F, 0x14),  // #
+    FONT_GLYPH(0x24, 0x2A, 0x7F, 0x2A, 0x12),  // $
+    FONT_GLYPH(0x23, 0x13, 0x08, 0x64, 0x62),  // %
+    FONT_GLYPH(0x36, 0x49, 0x56, 0x20, 0x50),  // &
+    FONT_GLYPH(0x00, 0x08, 0x07, 0x03, 0x00),  // '
+    FONT_GLYPH(0x00, 0x1C, 0x22, 0x41, 0x00),  // (
+    FONT_GLYPH(0x00, 0x41, 0x22, 0x1C, 0x00),  // )
+    FONT_GLYPH(0x2A, 0x1C, 0x7F, 0x1C, 0x2A),  // *
+    FONT_GLYPH(0x08, 0x08, 0x3E, 0x08, 0x08),  // +
+    FONT_GLYPH(0x00, 0x80, 0x70, 0x30, 0x00),  // ,
+    FONT_GLYPH(0x08, 0x08, 0x08, 0x08, 0x08),  // -
+    FONT_GLYPH(0x00, 0x00, 0x60, 0x60, 0x00),  // .
+    FONT_GLYPH(0x20, 0x10, 0x08, 0x04, 0x02),  // /
+    FONT_GLYPH(0x3E, 0x51, 0x49, 0x45, 0x3E),  // 0
+    FONT_GLYPH(0x00, 0x42, 0x7F, 0x40, 0x00),  // 1
+    FONT_GLYPH(0x72, 0x49, 0x49, 0x49, 0x46),  // 2
+    FONT_GLYPH(0x21, 0x41, 0x49, 0x4D, 0x33),  // 3
+    FONT_GLYPH(0x18, 0x14, 0x12, 0x7F, 0x10),  // 4
+    FONT_GLYPH(0x27, 0x45, 0x45, 0x45, 0x39),  // 5
+    FONT_GLYPH(0x3C, 0x4A, 0x49, 0x49, 0x31),  // 6
+    FONT_GLYPH(0x41, 0x21, 0x11, 0x09, 0x07),  // 7
+    FONT_GLYPH(0x36, 0x49, 0x49, 0x49, 0x36),  // 8
+    FONT_GLYPH(0x46, 0x49, 0x49, 0x29, 0x1E),  // 9
+    FONT_GLYPH(0x00, 0x00, 0x14, 0x00, 0x00),  // :
+    FONT_GLYPH(0x00, 0x40, 0x34, 0x00, 0x00),  // ;
+    FONT_GLYPH(0x00, 0x08, 0x14, 0x22, 0x41),  // <
+    FONT_GLYPH(0x14, 0x14, 0x14, 0x14, 0x14),  // =
+    FONT_GLYPH(0x00, 0x41, 0x22, 0x14, 0x08),  // >
+    FONT_GLYPH(0x02, 0x01, 0x59, 0x09, 0x06),  // ?
+    FONT_GLYPH(0x3E, 0x41, 0x5D, 0x59, 0x4E),  // @
+    FONT_GLYPH(0x7C, 0x12, 0x11, 0x12, 0x7C),  // A
+    FONT_GLYPH(0x7F, 0x49, 0x49, 0x49, 0x36),  // B
+    FONT_GLYPH(0x3E, 0x41, 0x41, 0x41, 0x22),  // C
+    FONT_GLYPH(0x7F, 0x41, 0x41, 0x41, 0x3E),  // D
+    FONT_GLYPH(0x7F, 0x49, 0x49, 0x49, 0x41),  // E
+    FONT_GLYPH(0x7F, 0x09, 0x09, 0x09, 0x01),  // F
+    FONT_GLYPH(0x3E, 0x41, 0x41, 0x51, 0x73),  // G
+    FONT_GLYPH(0x7F, 0x08, 0x08, 0x08, 0x7F),  // H
+    FONT_GLYPH(0x00, 0x41, 0x7F, 0x41, 0x00),  // I
+    FONT_GLYPH(0x20, 0x40, 0x41, 0x3F, 0x01),  // J
+    FONT_GLYPH(0x7F, 0x08, 0x14, 0x22, 0x41),  // K
+    FONT_GLYPH(0x7F, 0x40, 0x40, 0x40, 0x40),  // L
+    FONT_GLYPH(0x7F, 0x02, 0x1C, 0x02, 0x7F),  // M
+    FONT_GLYPH(0x7F, 0x04, 0x08, 0x10, 0x7F),  // N
+    FONT_GLYPH(0x3E, 0x41, 0x41, 0x41, 0x3E),  // O
+    FONT_GLYPH(0x7F, 0x09, 0x09, 0x09, 0x06),  // P
+    FONT_GLYPH(0x3E, 0x41, 0x51, 0x21, 0x5E),  // Q
+    FONT_GLYPH(0x7F, 0x09, 0x19, 0x29, 0x46),  // R
+    FONT_GLYPH(0x26, 0x49, 0x49, 0x49, 0x32),  // S
+    FONT_GLYPH(0x03, 0x01, 0x7F, 0x01, 0x03),  // T
+    FONT_GLYPH(0x3F, 0x40, 0x40, 0x40, 0x3F),  // U
+    FONT_GLYPH(0x1F, 0x20, 0x40, 0x20, 0x1F),  // V
+    FONT_GLYPH(0x3F, 0x40, 0x38, 0x40, 0x3F),  // W
+    FONT_GLYPH(0x63, 0x14, 0x08, 0x14, 0x63),  // X
+    FONT_GLYPH(0x03, 0x04, 0x78, 0x04, 0x03),  // Y
+    FONT_GLYPH(0x61, 0x59, 0x49, 0x4D, 0x43),  // Z
+    FONT_GLYPH(0x00, 0x7F, 0x41, 0x41, 0x41),  // [
+    FONT_GLYPH(0x02, 0x04, 0x08, 0x10, 0x20),  // backslash
+    FONT_GLYPH(0x00, 0x41, 0x41, 0x41, 0x7F),  // ]
+    FONT_GLYPH(0x04, 0x02, 0x01, 0x02, 0x04),  // ^
+    FONT_GLYPH(0x40, 0x40, 0x40, 0x40, 0x40),  // _
+    FONT_GLYPH(0x00, 0x03, 0x07, 0x08, 0x00),  // `
+    FONT_GLYPH(0x20, 0x54, 0x54, 0x78, 0x40),  // a
+    FONT_GLYPH(0x7F, 0x28, 0x44, 0x44, 0x38),  // b
+    FONT_GLYPH(0x38, 0x44, 0x44, 0x44, 0x28),  // c
+    FONT_GLYPH(0x38, 0x44, 0x44, 0x28, 0x7F),  // d
+    FONT_GLYPH(0x38, 0x54, 0x54, 0x54, 0x18),  // e
+    FONT_GLYPH(0x00, 0x08, 0x7E, 0x09, 0x02),  // f
+    FONT_GLYPH(0x18, 0xA4, 0xA4, 0x9C, 0x78),  // g
+    FONT_GLYPH(0x7F, 0x08, 0x04, 0x04, 0x78),  // h
+    FONT_GLYPH(0x00, 0x44, 0x7D, 0x40, 0x00),  // i
+    FONT_GLYPH(0x20, 0x40, 0x40, 0x3D, 0x00),  // j
+    FONT_GLYPH(0x7F, 0x10, 0x28, 0x44, 0x00),  // k
+    FONT_GLYPH(0x00, 0x41, 0x7F, 0x40, 0x00),  // l
+    FONT_GLYPH(0x7C, 0x04, 0x78, 0x04, 0x78),  // m
+    FONT_GLYPH(0x7C, 0x08, 0x04, 0x04, 0x78),  // n
+    FONT_GLYPH(0x38, 0x44, 0x44, 0x44, 0x38),  // o
+    FONT_GLYPH(0xFC, 0x18, 0x24, 0x24, 0x18),  // p
+    FONT_GLYPH(0x18, 0x24, 0x24, 0x18, 0xFC),  // q
+    FONT_GLYPH(0x7C, 0x08, 0x04, 0x04, 0x08),  // r
+    FONT_GLYPH(0x48, 0x54, 0x54, 0x54, 0x24),  // s
+    FONT_GLYPH(0x04, 0x04, 0x3F, 0x44, 0x24),  // t
+    FONT_GLYPH(0x3C, 0x40, 0x40, 0x20, 0x7C),  // u
+    FONT_GLYPH(0x1C, 0x20, 0x40, 0x20, 0x1C),  // v
+    FONT_GLYPH(0x3C, 0x40, 0x30, 0x40, 0x3C),  // w
+    FONT_GLYPH(0x44, 0x28, 0x10, 0x28, 0x44),  // x
+    FONT_GLYPH(0x4C, 0x90, 0x90, 0x90, 0x7C),  // y
+    FONT_GLYPH(0x44, 0x64, 0x54, 0x4C, 0x44),  // z
+    FONT_GLYPH(0x00, 0x08, 0x36, 0x41, 0x00),  // {
+    FONT_GLYPH(0x00, 0x00, 0x77, 0x00, 0x00),  // |
+    FONT_GLYPH(0x00, 0x41, 0x36, 0x08, 0x00),  // }
+    FONT_GLYPH(0x02, 0x01, 0x02, 0x04, 0x02),  // ~
+};
+
+#undef FONT_GLYPH
+#undef FONT_ROW
+
+static_assert(sizeof(font_atlas) == 95 * CHAR_H, "font atlas covers printable ASCII");
+static_assert(CHAR_W == 6 && CHAR_H == 8, "glyph blitter assumes 6x8 cells");
+
+static inline bool fontHasGlyph(uint8_t c) {
+    return c >= FONT_FIRST && c <= FONT_LAST;
+}
+
+// Apply one 6-bit row pattern at pixel x of a canvas row: clear the bits
+// (black ink) or set them (white ink). A 6-pixel row spans at most two bytes.
+static inline void fontPutRow(uint8_t* row, int x, uint8_t bits, bool white) {
+    int b = x >> 3;
+    uint16_t v = (uint16_t)bits << (10 - (x & 7));
+    uint8_t hi = v >> 8;
+    uint8_t lo = v & 0xFF;
+    if (white) {
+        row[b] |= hi;
+        if (lo) row[b + 1] |= lo;
+    } else {
+        row[b] &= ~hi;
+        if (lo) row[b + 1] &= ~lo;
+    }
+}
+
+static void fontBlitGlyph(uint8_t* buf, int x, int y, uint8_t c, bool white) {
+    const uint8_t* rows = font_atlas[c - FONT_FIRST];
+    for (int j = 0; j < CHAR_H; j++) {
+        if (!rows[j] || y + j >= SCREEN_H) continue;
+        fontPutRow(buf + (y + j) * FB_STRIDE, x, rows[j], white);
+    }
+}
+
+// Draw n bytes of black text with the GFX cursor at (x, y), like print().
+void fbDrawText(int x, int y, const char* s, int n) {
+    uint8_t* buf = frame_canvas.getBuffer();
+    for (int i = 0; i < n; i++, x += CHAR_W) {
+        uint8_t c = (uint8_t)s[i];
+        if (c == ' ') continue;
+        if (x < 0 || x > SCREEN_W - CHAR_W) continue;
+        if (fontHasGlyph(c)) fontBlitGlyph(buf, x, y, c, false);
+        else frame_canvas.drawChar(x, y, c, GxEPD_BLACK, GxEPD_BLACK, 1);
+    }
+}
+
+// Inverted cursor cell: the cell_y..cell_y+7 block in black with the glyph
+// in white one pixel down, matching fillRect + white print.
+void fbDrawCursorCell(int x, int cell_y, char ch) {
+    if (x < 0 || x > SCREEN_W - CHAR_W) return;
+    uint8_t* buf = frame_canvas.getBuffer();
+    for (int j = 0; j < CHAR_H && cell_y + j < SCREEN_H; j++) {
+        fontPutRow(buf + (cell_y + j) * FB_STRIDE, x, 0x3F, false);
+    }
+    uint8_t c = (uint8_t)ch;
+    if (c == ' ' || c == '\0') return;
+    if (fontHasGlyph(c)) fontBlitGlyph(buf, x, cell_y + 1, c, true);
+    else frame_canvas.drawChar(x, cell_y + 1, c, GxEPD_WHITE, GxEPD_WHITE, 1);
+}
+
+// Dotted underline on the cell's descender scanline, marking a locally
+// echoed character the server has not confirmed yet.
+void fbDrawTentativeMark(int x, int cell_y) {
+    int y = cell_y + CHAR_H;
+    if (x < 0 || x > SCREEN_W - CHAR_W || y >= SCREEN_H) return;
+    fontPutRow(frame_canvas.getBuffer() + y * FB_STRIDE, x, 0x2A, false);
+}
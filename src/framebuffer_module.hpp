@@ -0,0 +1,142 @@
+#pragma once
+
+// --- Shadow Framebuffer ---
+//
+// Frames are composed in frame_canvas (1bpp, bit set = white) and compared
+// with frame_shadow, a copy of what the panel currently shows. Only the
+// changed area is sent: the dirty rows are grouped into bands, x is widened
+// to whole bytes (the controller addresses 8 pixels per byte), and the bands
+// are merged down to FB_MAX_WINDOWS partial windows. Each window costs its
+// own refresh waveform, so one bounding window per frame is the default.
+//
+// frame_canvas persists between frames: renderers only clear and redraw the
+// region they own (e.g. the command area over the notepad's top half).
+
+static constexpr int FB_STRIDE = SCREEN_W / 8;
+static constexpr int FB_MAX_BANDS = 16;
+static constexpr int FB_MAX_WINDOWS = 1;
+static constexpr int FB_MERGE_GAP_ROWS = CHAR_H;  // join bands closer than one text row
+
+struct FbRect {
+    int16_t x, y, w, h;
+};
+
+static GFXcanvas1 frame_canvas(SCREEN_W, SCREEN_H);
+static uint8_t frame_shadow[FB_STRIDE * SCREEN_H];
+static bool frame_shadow_valid = false;
+
+// Compare two frames (stride bytes per row, MSB = leftmost pixel) and write
+// up to max_rects byte-aligned rectangles covering every changed pixel.
+// Returns the number of rectangles (0 = identical).
+static int fbDiffRects(const uint8_t* prev, const uint8_t* next, int stride, int rows,
+                       FbRect* out, int max_rects) {
+    struct Band { int y0, y1, b0, b1; };
+    Band bands[FB_MAX_BANDS];
+    int count = 0;
+    if (max_rects < 1) return 0;
+
+    for (int y = 0; y < rows; y++) {
+        const uint8_t* p = prev + y * stride;
+        const uint8_t* n = next + y * stride;
+        if (memcmp(p, n, stride) == 0) continue;
+        int b0 = 0;
+        while (p[b0] == n[b0]) b0++;
+        int b1 = stride - 1;
+        while (p[b1] == n[b1]) b1--;
+
+        Band* last = count > 0 ? &bands[count - 1] : NULL;
+        if (last && (y - last->y1 <= FB_MERGE_GAP_ROWS || count == FB_MAX_BANDS)) {
+            last->y1 = y;
+            if (b0 < last->b0) last->b0 = b0;
+            if (b1 > last->b1) last->b1 = b1;
+        } else {
+            bands[count++] = {y, y, b0, b1};
+        }
+    }
+
+    // Merge the closest neighbours until the window budget is met.
+    while (count > max_rects) {
+        int best = 0;
+        for (int i = 1; i < count - 1; i++) {
+            if (bands[i + 1].y0 - bands[i].y1 < bands[best + 1].y0 - bands[best].y1) best = i;
+        }
+        Band& a = bands[best];
+        const Band& b = bands[best + 1];
+        a.y1 = b.y1;
+        if (b.b0 < a.b0) a.b0 = b.b0;
+        if (b.b1 > a.b1) a.b1 = b.b1;
+        for (int i = best + 1; i < count - 1; i++) bands[i] = bands[i + 1];
+        count--;
+    }
+
+    for (int i = 0; i < count; i++) {
+        out[i].x = bands[i].b0 * 8;
+        out[i].w = (bands[i].b1 - bands[i].b0 + 1) * 8;
+        out[i].y = bands[i].y0;
+        out[i].h = bands[i].y1 - bands[i].y0 + 1;
+    }
+    return count;
+}
+
+// Send one byte-aligned rectangle of frame_canvas to the controller and
+// refresh it. The canvas already has the controller's layout (unrotated,
+// MSB = leftmost pixel, bit set = white), so its rows go out as bytes
+// rather than through GxEPD2_BW's page buffer one drawPixel at a time.
+// This is the sequence GxEPD2_BW::nextPage runs for a full-height buffer:
+// write, refresh, then write again into the previous-frame RAM the next
+// differential update compares against.
+static void fbSend(const FbRect& r, bool full) {
+    const uint8_t* buf = frame_canvas.getBuffer();
+    if (full) {
+        display.epd2.writeImage(buf, 0, 0, SCREEN_W, SCREEN_H);
+        display.epd2.refresh(false);
+        display.epd2.writeImageAgain(buf, 0, 0, SCREEN_W, SCREEN_H);
+    } else {
+        display.epd2.writeImagePart(buf, r.x, r.y, SCREEN_W, SCREEN_H, r.x, r.y, r.w, r.h);
+        display.epd2.refresh(r.x, r.y, r.w, r.h);
+        display.epd2.writeImagePartAgain(buf, r.x, r.y, SCREEN_W, SCREEN_H, r.x, r.y, r.w, r.h);
+    }
+}
+
+static void fbCommit(const FbRect& r) {
+    const uint8_t* buf = frame_canvas.getBuffer();
+    int b0 = r.x / 8;
+    int bytes = r.w / 8;
+    for (int y = r.y; y < r.y + r.h; y++) {
+        memcpy(frame_shadow + y * FB_STRIDE + b0, buf + y * FB_STRIDE + b0, bytes);
+    }
+}
+
+// Start composing a frame with the usual text defaults.
+void fbBeginDraw() {
+    frame_canvas.setTextColor(GxEPD_BLACK);
+    frame_canvas.setFont(NULL);
+    frame_canvas.setTextWrap(false);
+}
+
+// Full refresh of the whole canvas (clears ghosting).
+void fbPushFull() {
+    FbRect all = {0, 0, SCREEN_W, SCREEN_H};
+    partial_count = 0;
+    fbSend(all, true);
+    fbCommit(all);
+    frame_shadow_valid = true;
+}
+
+// Partial refresh of whatever changed since the last push. Returns false
+// when the frame matches the panel and nothing was sent.
+bool fbPush() {
+    if (!frame_shadow_valid) {
+        fbPushFull();
+        return true;
+    }
+    FbRect rects[FB_MAX_WINDOWS];
+    int n = fbDiffRects(frame_shadow, frame_canvas.getBuffer(), FB_STRIDE, SCREEN_H,
+                        rects, FB_MAX_WINDOWS);
+    for (int i = 0; i < n; i++) {
+        partial_count++;
+        fbSend(rects[i], false);
+        fbCommit(rects[i]);
+    }
+    return n > 0;
+}
@@ -0,0 +1,320 @@
+// --- Edit Journal (append-only sidecar on SD) ---
+//
+// Local files are stored as a base file plus an edit journal. Every edit is
+// recorded in a small RAM log (a run of typing or backspacing coalesces into
+// one record). A save appends that log to "/.<name>.jnl" as one checksummed
+// batch, so the SD write and bus hold time scale with the edit, not with the
+// document. Compaction writes the whole document to "/.<name>.tmp", renames
+// it over the base and removes the journal; it runs when the journal passes
+// JOURNAL_COMPACT_BYTES, when the RAM log overflowed, when leaving the file,
+// before uploads, and at boot for journals left by a crash or power loss.
+//
+// The journal header pins the base length and CRC, so a journal left behind
+// by an interrupted compaction (base already rewritten) is detected as stale.
+// Replay applies batches in order and stops at the first torn or corrupt one.
+//
+// Journal file: "TDJ1" u32 base_len u32 base_crc, then batches of
+//   'B' u32 payload_len u32 crc32(payload) payload
+// with payload records 'I' u32 off u32 len bytes[len] and 'D' u32 off u32 len.
+// Journal state is only touched from core 1 (keyboard/loop/commands).
+
+#include <rom/crc.h>
+
+#define JOURNAL_MAGIC          "TDJ1"
+#define JOURNAL_HDR_LEN        12
+#define JOURNAL_BATCH_HDR_LEN  9
+#define JOURNAL_REC_HDR_LEN    9
+#define JOURNAL_PENDING_CAP    4096
+#define JOURNAL_COMPACT_BYTES  (64 * 1024)
+#define JOURNAL_IDLE_FLUSH_MS  3000
+
+static uint8_t jnl_pending[JOURNAL_PENDING_CAP];
+static int  jnl_pending_len = 0;
+static int  jnl_rec_start = -1;      // open record in jnl_pending, -1 = none
+static volatile bool jnl_overflow = false; // edits not journaled; next save compacts
+static bool jnl_replaying = false;
+static volatile bool jnl_write_failed = false; // storage worker lost a write
+static unsigned long jnl_last_edit_ms = 0;
+
+// Base file the journal belongs to; empty when the document has no local base.
+// jnl_file_len runs ahead of the storage worker (bytes planned, not written).
+static String   jnl_base_path = "";
+static uint32_t jnl_file_len = 0;    // bytes in the sidecar, 0 = no sidecar
+// Length/CRC of the base on SD, written into new journal headers. Owned by
+// the storage worker; set synchronously only while it is idle (loads).
+static uint32_t jnl_base_len = 0;
+static uint32_t jnl_base_crc = 0;
+
+static inline void jnlPut32(uint8_t* p, uint32_t v) { memcpy(p, &v, 4); }
+static inline uint32_t jnlGet32(const uint8_t* p) { uint32_t v; memcpy(&v, p, 4); return v; }
+
+// "/dir/name" -> "/dir/.name<ext>" (hidden from listings and uploads)
+static String journalSidecarPath(const char* path, const char* ext) {
+    const char* slash = strrchr(path, '/');
+    String dir = slash ? String(path).substring(0, slash - path + 1) : String("/");
+    String name = slash ? String(slash + 1) : String(path);
+    return dir + "." + name + ext;
+}
+
+static void journalDropPending() {
+    jnl_pending_len = 0;
+    jnl_rec_start = -1;
+}
+
+static bool journalHasEntries() {
+    return jnl_file_len > 0 || jnl_pending_len > 0 || jnl_overflow;
+}
+
+static void journalOpenRecord(char type, int off, int len) {
+    jnl_rec_start = jnl_pending_len;
+    jnl_pending[jnl_pending_len] = (uint8_t)type;
+    jnlPut32(&jnl_pending[jnl_pending_len + 1], (uint32_t)off);
+    jnlPut32(&jnl_pending[jnl_pending_len + 5], (uint32_t)len);
+    jnl_pending_len += JOURNAL_REC_HDR_LEN;
+}
+
+// Text engine hook: c was inserted at off.
+void journalNoteInsert(int off, char c) {
+    if (jnl_replaying) return;
+    jnl_last_edit_ms = millis();
+    if (jnl_overflow) return;
+    if (jnl_rec_start >= 0 && jnl_pending[jnl_rec_start] == 'I') {
+        uint8_t* rec = &jnl_pending[jnl_rec_start];
+        uint32_t rec_off = jnlGet32(rec + 1);
+        uint32_t rec_len = jnlGet32(rec + 5);
+        if ((uint32_t)off == rec_off + rec_len && jnl_pending_len < JOURNAL_PENDING_CAP) {
+            jnl_pending[jnl_pending_len++] = (uint8_t)c;
+            jnlPut32(rec + 5, rec_len + 1);
+            return;
+        }
+    }
+    if (jnl_pending_len + JOURNAL_REC_HDR_LEN + 1 > JOURNAL_PENDING_CAP) {
+        jnl_overflow = true;
+        journalDropPending();
+        return;
+    }
+    journalOpenRecord('I', off, 1);
+    jnl_pending[jnl_pending_len++] = (uint8_t)c;
+}
+
+// Text engine hook: the char at off was erased.
+void journalNoteErase(int off) {
+    if (jnl_replaying) return;
+    jnl_last_edit_ms = millis();
+    if (jnl_overflow) return;
+    if (jnl_rec_start >= 0) {
+        uint8_t* rec = &jnl_pending[jnl_rec_start];
+        uint32_t rec_off = jnlGet32(rec + 1);
+        uint32_t rec_len = jnlGet32(rec + 5);
+        if (rec[0] == 'I' && rec_len > 0 && (uint32_t)off == rec_off + rec_len - 1) {
+            // Backspace over text typed since the last save: just unrecord it.
+            jnl_pending_len--;
+            if (rec_len == 1) {
+                jnl_pending_len = jnl_rec_start;
+                jnl_rec_start = -1;
+            } else {
+                jnlPut32(rec + 5, rec_len - 1);
+            }
+            return;
+        }
+        if (rec[0] == 'D' && (uint32_t)off + 1 == rec_off) {
+            jnlPut32(rec + 1, (uint32_t)off);
+            jnlPut32(rec + 5, rec_len + 1);
+            return;
+        }
+    }
+    if (jnl_pending_len + JOURNAL_REC_HDR_LEN > JOURNAL_PENDING_CAP) {
+        jnl_overflow = true;
+        journalDropPending();
+        return;
+    }
+    journalOpenRecord('D', off, 1);
+}
+
+// Text engine hook: the document was replaced or cleared.
+void journalDetach() {
+    jnl_base_path = "";
+    jnl_file_len = 0;
+    jnl_overflow = false;
+    journalDropPending();
+}
+
+// The document now equals the base file at path (len bytes, crc).
+// Storage worker must be idle.
+static void journalAttach(const char* path, uint32_t len, uint32_t crc) {
+    String base = path;  // path may point into jnl_base_path
+    journalDetach();
+    jnl_base_path = base;
+    jnl_base_len = len;
+    jnl_base_crc = crc;
+    jnl_write_failed = false;
+}
+
+// Append one batch to path's journal, creating it with a header pinned to
+// the current base when write_header is set. Caller holds the SD bus.
+static bool journalWriteBatch(const char* path, const uint8_t* payload, int len, bool write_header) {
+    String jpath = journalSidecarPath(path, ".jnl");
+    File f = SD.open(jpath.c_str(), write_header ? FILE_WRITE : FILE_APPEND);
+    if (!f) return false;
+    bool ok = true;
+    if (write_header) {
+        uint8_t hdr[JOURNAL_HDR_LEN];
+        memcpy(hdr, JOURNAL_MAGIC, 4);
+        jnlPut32(hdr + 4, jnl_base_len);
+        jnlPut32(hdr + 8, jnl_base_crc);
+        ok = f.write(hdr, sizeof(hdr)) == sizeof(hdr);
+    }
+    uint8_t bhdr[JOURNAL_BATCH_HDR_LEN];
+    bhdr[0] = 'B';
+    jnlPut32(bhdr + 1, (uint32_t)len);
+    jnlPut32(bhdr + 5, crc32_le(0, payload, len));
+    ok = ok && f.write(bhdr, sizeof(bhdr)) == sizeof(bhdr);
+    ok = ok && f.write(payload, len) == (size_t)len;
+    f.close();
+    return ok;
+}
+
+// Write data as the new base file for path and drop its journal.
+// Caller holds the SD bus.
+static bool journalWriteBase(const char* path, const char* data, int len) {
+    String tmp = journalSidecarPath(path, ".tmp");
+    File f = SD.open(tmp.c_str(), FILE_WRITE);
+    if (!f) return false;
+    bool ok = f.write((const uint8_t*)data, len) == (size_t)len;
+    f.close();
+    if (!ok) { SD.remove(tmp.c_str()); return false; }
+    // SD.rename will not replace an existing file. A crash between these two
+    // steps leaves only the .tmp, which journalRecoverPath renames back.
+    SD.remove(path);
+    if (!SD.rename(tmp.c_str(), path)) return false;
+    SD.remove(journalSidecarPath(path, ".jnl").c_str());
+    jnl_base_len = (uint32_t)len;
+    jnl_base_crc = crc32_le(0, (const uint8_t*)data, len);
+    return true;
+}
+
+// Compact the open document into path right away. Caller holds the SD bus
+// and the storage worker is idle.
+static bool journalCompactNow(const char* path) {
+    char* flat = textFlattenAlloc();
+    if (!flat) return false;
+    bool ok = journalWriteBase(path, flat, text_len);
+    free(flat);
+    if (!ok) return false;
+    uint32_t len = jnl_base_len, crc = jnl_base_crc;
+    journalAttach(path, len, crc);
+    return true;
+}
+
+// Finish an interrupted compaction: base missing but its .tmp present.
+// Caller holds the SD bus.
+static void journalRecoverPath(const char* path) {
+    String tmp = journalSidecarPath(path, ".tmp");
+    if (!SD.exists(tmp.c_str())) return;
+    if (SD.exists(path)) SD.remove(tmp.c_str());
+    else SD.rename(tmp.c_str(), path);
+}
+
+static bool journalApplyBatch(const uint8_t* p, int len) {
+    int i = 0;
+    while (i + JOURNAL_REC_HDR_LEN <= len) {
+        char type = (char)p[i];
+        int off = (int)jnlGet32(p + i + 1);
+        int n = (int)jnlGet32(p + i + 5);
+        i += JOURNAL_REC_HDR_LEN;
+        if (off < 0 || n < 0 || off > text_len) return false;
+        if (type == 'I') {
+            if (i + n > len) return false;
+            cursor_pos = off;
+            for (int k = 0; k < n; k++) {
+                if (!textInsert((char)p[i + k])) return false;
+            }
+            i += n;
+        } else if (type == 'D') {
+            if (off + n > text_len) return false;
+            cursor_pos = off + n;
+            for (int k = 0; k < n; k++) textBackspace();
+        } else {
+            return false;
+        }
+    }
+    return i == len;
+}
+
+// Replay the journal of the just-loaded base file. Returns false when a torn
+// or corrupt tail was skipped (the caller compacts so appends stay valid).
+// Caller holds the SD bus.
+static bool journalReplay(const char* path) {
+    String jpath = journalSidecarPath(path, ".jnl");
+    File f = SD.open(jpath.c_str(), FILE_READ);
+    if (!f) return true;
+    uint32_t size = f.size();
+    uint8_t hdr[JOURNAL_HDR_LEN];
+    if (f.read(hdr, sizeof(hdr)) != sizeof(hdr) || memcmp(hdr, JOURNAL_MAGIC, 4) != 0 ||
+        jnlGet32(hdr + 4) != jnl_base_len || jnlGet32(hdr + 8) != jnl_base_crc) {
+        // Stale (base rewritten after the journal) or unreadable: discard.
+        f.close();
+        SD.remove(jpath.c_str());
+        SERIAL_LOGF("JNL: dropped stale %s\n", jpath.c_str());
+        return true;
+    }
+
+    uint32_t good = sizeof(hdr);
+    int batches = 0;
+    jnl_replaying = true;
+    for (;;) {
+        uint8_t bhdr[JOURNAL_BATCH_HDR_LEN];
+        if (f.read(bhdr, sizeof(bhdr)) != sizeof(bhdr) || bhdr[0] != 'B') break;
+        int len = (int)jnlGet32(bhdr + 1);
+        if (len <= 0 || len > JOURNAL_PENDING_CAP) break;
+        if (f.read(jnl_pending, len) != (size_t)len) break;
+        if (crc32_le(0, jnl_pending, len) != jnlGet32(bhdr + 5)) break;
+        if (!journalApplyBatch(jnl_pending, len)) break;
+        good += sizeof(bhdr) + len;
+        batches++;
+    }
+    jnl_replaying = false;
+    journalDropPending();
+    f.close();
+
+    cursor_pos = text_len;
+    jnl_file_len = good;
+    if (batches > 0) SERIAL_LOGF("JNL: replayed %d batches from %s\n", batches, jpath.c_str());
+    if (good != size) {
+        SERIAL_LOGF("JNL: torn tail in %s (%lu/%lu)\n", jpath.c_str(),
+                    (unsigned long)good, (unsigned long)size);
+        return false;
+    }
+    return true;
+}
+
+// Plan a save of the open document to a local path. Appends the RAM log to
+// the journal when it belongs to this base and is small, otherwise compacts
+// (or when compact is set). Hands back the bytes the storage worker must
+// write (caller frees) and advances the journal state as if the write
+// succeeded; a failed write sets jnl_overflow so the next save compacts.
+static char* journalPlanSave(const char* path, bool compact, bool* is_append, bool* write_header, int* len) {
+    bool same_base = jnl_base_path.length() > 0 && jnl_base_path == path;
+    uint32_t batch = JOURNAL_BATCH_HDR_LEN + jnl_pending_len;
+    if (!compact && same_base && !jnl_overflow && jnl_pending_len > 0 &&
+        jnl_file_len + JOURNAL_HDR_LEN + batch <= JOURNAL_COMPACT_BYTES) {
+        char* payload = (char*)malloc(jnl_pending_len);
+        if (!payload) return nullptr;
+        memcpy(payload, jnl_pending, jnl_pending_len);
+        *is_append = true;
+        *write_header = jnl_file_len == 0;
+        *len = jnl_pending_len;
+        jnl_file_len += (*write_header ? JOURNAL_HDR_LEN : 0) + batch;
+        journalDropPending();
+        return payload;
+    }
+
+    char* flat = textFlattenAlloc();
+    if (!flat) return nullptr;
+    *is_append = false;
+    *write_header = false;
+    *len = text_len;
+    journalDetach();
+    jnl_base_path = path;
+    return flat;
+}
@@ -4,42 +4,15 @@ void cursorLeft()  { if (cursor_pos > 0) cursor_pos--; }
 void cursorRight() { if (cursor_pos < text_len) cursor_pos++; }
 
 void cursorUp() {
-    LayoutInfo info = computeLayoutFrom(text_buf, text_len, cursor_pos);
+    LayoutInfo info = textComputeLayout(cursor_pos);
     if (info.cursor_line == 0) return;
-    int target_line = info.cursor_line - 1;
-    int target_col  = info.cursor_col;
-    int line = 0, col = 0;
-    for (int i = 0; i <= text_len; i++) {
-        if (line == target_line && col == target_col) { cursor_pos = i; return; }
-        if (i >= text_len) break;
-        if (text_buf[i] == '\n') {
-            if (line == target_line) { cursor_pos = i; return; }
-            line++; col = 0;
-        } else {
-            col++;
-            if (col >= COLS_PER_LINE) { line++; col = 0; }
-        }
-    }
+    cursor_pos = textOffsetAt(info.cursor_line - 1, info.cursor_col);
 }
 
 void cursorDown() {
-    LayoutInfo info = computeLayoutFrom(text_buf, text_len, cursor_pos);
+    LayoutInfo info = textComputeLayout(cursor_pos);
     if (info.cursor_line >= info.total_lines - 1) return;
-    int target_line = info.cursor_line + 1;
-    int target_col  = info.cursor_col;
-    int line = 0, col = 0;
-    for (int i = 0; i <= text_len; i++) {
-        if (line == target_line && col == target_col) { cursor_pos = i; return; }
-        if (i >= text_len) break;
-        if (text_buf[i] == '\n') {
-            if (line == target_line) { cursor_pos = i; return; }
-            line++; col = 0;
-        } else {
-            col++;
-            if (col >= COLS_PER_LINE) { line++; col = 0; }
-        }
-    }
-    cursor_pos = text_len;
+    cursor_pos = textOffsetAt(info.cursor_line + 1, info.cursor_col);
 }
 
 // --- Notepad Key Handler ---
@@ -60,15 +33,9 @@ bool handleNotepadKeyPress(int event_code) {
     if (IS_MIC(row, col_rev))    {
         if (sym_mode) {
             sym_mode = false;
-            if (text_len < MAX_TEXT_LEN) {
-                memmove(&text_buf[cursor_pos + 1], &text_buf[cursor_pos], text_len - cursor_pos);
-                text_buf[cursor_pos] = '0';
-                text_len++; cursor_pos++;
-                text_buf[text_len] = '\0';
-                file_modified = true;
-                return true;
-            }
-            return false;
+            if (!textInsert('0')) return false;
+            file_modified = true;
+            return true;
         }
         mic_last_press = millis();
         return false;
@@ -83,24 +50,13 @@ bool handleNotepadKeyPress(int event_code) {
     if (c == 0) return false;
 
     if (c == '\b') {
-        if (cursor_pos > 0) {
-            memmove(&text_buf[cursor_pos - 1], &text_buf[cursor_pos], text_len - cursor_pos);
-            text_len--;
-            cursor_pos--;
-            text_buf[text_len] = '\0';
-            file_modified = true;
-            return true;
-        }
-        return false;
+        if (!textBackspace()) return false;
+        file_modified = true;
+        return true;
     }
 
     if (c == '\n' || (c >= ' ' && c <= '~')) {
-        if (text_len < MAX_TEXT_LEN) {
-            memmove(&text_buf[cursor_pos + 1], &text_buf[cursor_pos], text_len - cursor_pos);
-            text_buf[cursor_pos] = c;
-            text_len++;
-            cursor_pos++;
-            text_buf[text_len] = '\0';
+        if (textInsert(c)) {
             file_modified = true;
             if (shift_held) shift_held = false;
             return true;
@@ -112,6 +68,13 @@ bool handleNotepadKeyPress(int event_code) {
 
 // --- Terminal Key Handler ---
 
+// Local line edit takes the key when it is active; otherwise it goes to the
+// channel. Returns true when the screen changed locally.
+static bool terminalKey(char c) {
+    if (termLineKey(c)) return true;
+    return sshSendKey(c);
+}
+
 bool handleTerminalKeyPress(int event_code) {
     int key_num = (event_code & 0x7F);
     int idx = key_num - 1;
@@ -125,36 +88,45 @@ bool handleTerminalKeyPress(int event_code) {
     if (IS_SYM(row, col_rev))    { sym_mode = true; return true; }
     if (IS_ALT(row, col_rev))    { alt_mode = !alt_mode; return true; }
     if (IS_MIC(row, col_rev))    {
-        if (sym_mode) { sym_mode = false; sshSendKey('0'); return false; }
+        if (sym_mode) { sym_mode = false; return terminalKey('0'); }
+        if (alt_mode) { alt_mode = false; return termSessionCycle(); }  // next session
         mic_last_press = millis();
         return false;
     }
     if (IS_DEAD(row, col_rev))   { return false; }
 
+    // Typing while scrolled back returns the view to the live screen.
+    termLock();
+    bool was_scrolled_back = termViewLive();
+    termUnlock();
+    if (was_scrolled_back) requestRender(RENDER_TERMINAL);
+
     // Alt = Ctrl modifier
     if (alt_mode) {
         char base = keymap_lower[row][col_rev];
-        if (base == ' ') { sshSendKey(0x1B); alt_mode = false; return true; }
-        if (base == '\n') { sshSendKey('\t'); alt_mode = false; return true; }
-        if (base == '\b') { sshSendKey(0x7F); alt_mode = false; return false; }
+        if (base == ' ') { terminalKey(0x1B); alt_mode = false; return true; }
+        if (base == '\n') { terminalKey('\t'); alt_mode = false; return true; }
+        if (base == '\b') { alt_mode = false; return terminalKey(0x7F); }
         if (base >= 'a' && base <= 'z') {
-            sshSendKey(base - 'a' + 1);
+            bool shown = terminalKey(base - 'a' + 1);
             alt_mode = false;
             if (base == 'c') {
                 unsigned long now = millis();
                 if (terminal_last_ctrl_c_ms > 0 && (now - terminal_last_ctrl_c_ms) <= 1500) {
                     terminal_last_ctrl_c_ms = 0;
+                    termLock();
                     terminalClear();
+                    termUnlock();
                     connect_status_count = 0;
                     partial_count = 100;
-                    term_render_requested = true;
+                    requestRender(RENDER_TERMINAL);
                 } else {
                     terminal_last_ctrl_c_ms = now;
                 }
             } else {
                 terminal_last_ctrl_c_ms = 0;
             }
-            return false;
+            return shown;
         }
         return false;
     }
@@ -166,13 +138,12 @@ bool handleTerminalKeyPress(int event_code) {
 
     if (c == 0) return false;
 
-    if (c == '\b') { sshSendKey(0x7F); return false; }
-    if (c == '\n') { sshSendKey('\r'); return false; }
+    if (c == '\b') return terminalKey(0x7F);
+    if (c == '\n') return terminalKey('\r');
 
     if (c >= ' ' && c <= '~') {
-        sshSendKey(c);
         if (shift_held) shift_held = false;
-        return false;
+        return terminalKey(c);  // true when drawn locally
     }
 
     return false;
@@ -230,3 +201,146 @@ bool handleBluetoothKeyPress(int event_code) {
     }
     return false;
 }
+
+// --- Key Event Queue ---
+//
+// The TCA8418 INT line (BOARD_KEYBOARD_INT) wakes a reader task that drains
+// the keypad FIFO into key_queue, so I2C is only touched when keys are
+// pending and events are captured even while loop() is busy (SD, commands,
+// a long state_mutex hold by the SSH parser). loop() is the single consumer
+// and applies events in order; an event leaves the queue only once handled.
+
+struct KeyEvent {
+    uint8_t code;
+    uint32_t us;   // latNowUs() when read from the keypad
+};
+
+static constexpr int KEY_QUEUE_LEN = 64;  // power of two
+static constexpr uint32_t KEYPAD_STALL_RETRY_MS = 5;    // queue full: recheck for space
+static constexpr uint32_t KEYPAD_IDLE_CHECK_MS = 250;   // missed-edge safety net (GPIO only)
+static constexpr uint8_t KEYPAD_INT_K_INT = 0x01;     // INT_STAT: key event pending
+static constexpr uint8_t KEYPAD_INT_OVR_FLOW = 0x08;  // INT_STAT: FIFO overflowed
+
+static TaskHandle_t keypad_task_handle = NULL;
+static TaskHandle_t loop_task_handle = NULL;
+
+static KeyEvent key_queue[KEY_QUEUE_LEN];
+static volatile uint32_t key_queue_head = 0;  // advanced by the reader task
+static volatile uint32_t key_queue_tail = 0;  // advanced by loop()
+static bool key_queue_stalled = false;        // reader left events in the FIFO
+
+// Reads and clears the TCA8418 FIFO overflow flag (events lost in hardware).
+static bool keypadTakeOverflow() {
+    uint8_t stat = keypad.readRegister(TCA8418_REG_INT_STAT);
+    if (!(stat & KEYPAD_INT_OVR_FLOW)) return false;
+    keypad.writeRegister(TCA8418_REG_INT_STAT, KEYPAD_INT_OVR_FLOW);  // write 1 to clear
+    return true;
+}
+
+// Move pending press events from the keypad FIFO into key_queue. When the
+// queue is full the rest stay in the 10-deep hardware FIFO; anything lost
+// past that shows up as a FIFO overflow and is counted as dropped.
+// Returns true if any event was queued.
+static bool keyQueueFill() {
+    if (key_queue_stalled) {
+        if (key_queue_head - key_queue_tail >= KEY_QUEUE_LEN) return false;
+        if (keypadTakeOverflow()) perf_key_drop_count++;
+        key_queue_stalled = false;
+    }
+    // Clear K_INT before draining so an event that lands mid-drain raises
+    // INT again instead of being acknowledged unread.
+    keypad.writeRegister(TCA8418_REG_INT_STAT, KEYPAD_INT_K_INT);
+    bool queued = false;
+    while (keypad.available() > 0) {
+        uint32_t depth = key_queue_head - key_queue_tail;
+        if (depth >= KEY_QUEUE_LEN) {
+            key_queue_stalled = true;
+            return queued;
+        }
+        int ev = keypad.getEvent();
+        if (!(ev & 0x80)) continue;  // skip release events
+        KeyEvent& slot = key_queue[key_queue_head & (KEY_QUEUE_LEN - 1)];
+        slot.code = (uint8_t)ev;
+        slot.us = latNowUs();
+        key_queue_head = key_queue_head + 1;
+        queued = true;
+        if (depth + 1 > perf_key_queue_hw) perf_key_queue_hw = depth + 1;
+    }
+    return queued;
+}
+
+static void IRAM_ATTR keypadIsr() {
+    BaseType_t woken = pdFALSE;
+    if (keypad_task_handle) vTaskNotifyGiveFromISR(keypad_task_handle, &woken);
+    portYIELD_FROM_ISR(woken);
+}
+
+static void keypadReaderTask(void* param) {
+    for (;;) {
+        uint32_t wait_ms = key_queue_stalled ? KEYPAD_STALL_RETRY_MS : KEYPAD_IDLE_CHECK_MS;
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(wait_ms));
+        // INT is active low and held until K_INT is cleared.
+        if (!key_queue_stalled && digitalRead(BOARD_KEYBOARD_INT) == HIGH) continue;
+        if (keyQueueFill() && loop_task_handle) xTaskNotifyGive(loop_task_handle);
+    }
+}
+
+// Called from setup() (the loop task) once the keypad is configured.
+void keypadInputStart() {
+    loop_task_handle = xTaskGetCurrentTaskHandle();
+    keypad.enableInterrupts();
+    keypad.writeRegister(TCA8418_REG_INT_STAT, KEYPAD_INT_K_INT | KEYPAD_INT_OVR_FLOW);
+    pinMode(BOARD_KEYBOARD_INT, INPUT_PULLUP);
+    xTaskCreatePinnedToCore(keypadReaderTask, "keypad", 3072, NULL, 2, &keypad_task_handle, 1);
+    attachInterrupt(digitalPinToInterrupt(BOARD_KEYBOARD_INT), keypadIsr, FALLING);
+    xTaskNotifyGive(keypad_task_handle);  // pick up anything pressed during boot
+}
+
+// Sleep loop() until a key is queued or timeout_ms passes. Returns at once
+// while events are still waiting for the state lock.
+void keyQueueWait(uint32_t timeout_ms) {
+    if (key_queue_tail != key_queue_head) return;
+    ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(timeout_ms));
+}
+
+// Apply queued key events in order. Stops at the first event whose
+// state_mutex wait times out, or, in the terminal, while the SSH send queue
+// has no room for it or a session switch is pending; it is retried on the
+// next loop() pass.
+static void keyQueueDispatch() {
+    while (key_queue_tail != key_queue_head) {
+        if (term_session_switch_to >= 0) return;   // later keys go to the new session
+        KeyEvent ev = key_queue[key_queue_tail & (KEY_QUEUE_LEN - 1)];
+        if (app_mode == MODE_TERMINAL && !sshTxWaitRoom(SSH_TX_KEY_ROOM, 25)) return;
+        if (xSemaphoreTake(state_mutex, pdMS_TO_TICKS(25)) != pdTRUE) return;
+        uint32_t blocked_ms = (micros() - ev.us) / 1000U;
+        if (blocked_ms > perf_key_block_max_ms) perf_key_block_max_ms = blocked_ms;
+
+        bool needs_render = false;
+        AppMode mode = app_mode;
+        if (mode == MODE_NOTEPAD) {
+            needs_render = handleNotepadKeyPress(ev.code);
+        } else if (mode == MODE_TERMINAL) {
+            needs_render = handleTerminalKeyPress(ev.code);
+        } else if (mode == MODE_BT) {
+            needs_render = handleBluetoothKeyPress(ev.code);
+        } else if (mode == MODE_COMMAND) {
+            needs_render = handleCommandKeyPress(ev.code);
+        }
+        xSemaphoreGive(state_mutex);
+        key_queue_tail = key_queue_tail + 1;
+        latKeyHandled(mode, ev.us, needs_render);
+
+        if (needs_render) {
+            // After command execution, mode may have changed
+            AppMode cur = app_mode;
+            if (cur == MODE_NOTEPAD) {
+                requestRender(RENDER_EDITOR | RENDER_TYPING);
+            } else if (cur == MODE_TERMINAL) {
+                requestRender(RENDER_TERMINAL | RENDER_TYPING);
+            } else if (cur == MODE_COMMAND || cur == MODE_BT) {
+                requestRender(RENDER_EDITOR | RENDER_TYPING);
+            }
+        }
+    }
+}
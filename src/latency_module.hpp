@@ -0,0 +1,183 @@
+#pragma once
+
+// --- Latency Histograms ---
+//
+// Log2-bucketed latency histograms (microseconds) for the input-to-panel
+// pipeline. Bucket i counts samples in [2^i, 2^(i+1)) us; bucket 0 also
+// takes 0 and the last bucket is open-ended. Dumped with the agent LAT
+// command; scripts/latency_report.py turns a dump into percentiles.
+//
+// Key stages are measured from the moment the key was read off the keypad:
+//   handled   key handler returned (state updated)
+//   snapshot  display took its snapshot and started the frame
+//   spi_done  frame data sent; panel started its refresh (first busy wait)
+//   panel     panel refresh finished
+// ssh.panel measures the first byte of an SSH read burst to panel done.
+// ssh.echo measures a key written to the channel to the next SSH read
+// burst (network round trip plus receive wakeup). ssh.rx_wait records each
+// receive-task sleep: n/sum gives the idle wakeup rate.
+
+static constexpr int LAT_BUCKETS = 22;   // up to 2^21 us (~2.1 s), then open-ended
+
+struct LatencyHist {
+    uint32_t count;
+    uint32_t max_us;
+    uint64_t sum_us;
+    uint32_t bucket[LAT_BUCKETS];
+};
+
+enum LatMode : uint8_t {
+    LAT_MODE_NOTEPAD,
+    LAT_MODE_TERMINAL,
+    LAT_MODE_COMMAND,
+    LAT_MODE_COUNT,
+    LAT_MODE_NONE = 0xFF,
+};
+
+enum LatStage : uint8_t {
+    LAT_KEY_HANDLED,
+    LAT_KEY_SNAPSHOT,
+    LAT_KEY_SPI_DONE,
+    LAT_KEY_PANEL,
+    LAT_STAGE_COUNT,
+};
+
+static const char* const lat_mode_names[LAT_MODE_COUNT] = { "notepad", "terminal", "command" };
+static const char* const lat_stage_names[LAT_STAGE_COUNT] = { "handled", "snapshot", "spi_done", "panel" };
+
+static LatencyHist lat_key[LAT_MODE_COUNT][LAT_STAGE_COUNT];
+static LatencyHist lat_ssh_panel;
+static LatencyHist lat_ssh_echo;
+static LatencyHist lat_ssh_rx_wait;
+static LatencyHist lat_frame_render;   // every frame, start to panel done
+
+// Oldest key / SSH burst not yet on the panel (0 = none). Set by producers,
+// taken by the display task when a frame starts.
+static volatile uint32_t lat_pending_key_us = 0;
+static volatile uint8_t  lat_pending_key_mode = LAT_MODE_NONE;
+static volatile uint32_t lat_pending_output_us = 0;
+static volatile uint32_t lat_pending_echo_us = 0;   // oldest key sent, not yet answered
+
+// Set from the e-paper busy callback during the frame in flight.
+static volatile bool     lat_frame_active = false;
+static volatile uint32_t lat_frame_spi_done_us = 0;
+
+static void latRecord(LatencyHist& h, uint32_t us) {
+    int b = us ? 31 - __builtin_clz(us) : 0;
+    if (b >= LAT_BUCKETS) b = LAT_BUCKETS - 1;
+    h.bucket[b]++;
+    h.count++;
+    h.sum_us += us;
+    if (us > h.max_us) h.max_us = us;
+}
+
+static uint8_t latModeFor(AppMode mode) {
+    if (mode == MODE_NOTEPAD) return LAT_MODE_NOTEPAD;
+    if (mode == MODE_TERMINAL) return LAT_MODE_TERMINAL;
+    if (mode == MODE_COMMAND) return LAT_MODE_COMMAND;
+    return LAT_MODE_NONE;
+}
+
+static uint32_t latNowUs() { return micros() | 1U; }  // 0 means "none"
+
+// Key handler finished for a key read at key_us.
+static void latKeyHandled(AppMode mode, uint32_t key_us, bool needs_render) {
+    uint8_t m = latModeFor(mode);
+    if (m == LAT_MODE_NONE) return;
+    latRecord(lat_key[m][LAT_KEY_HANDLED], micros() - key_us);
+    if (needs_render && lat_pending_key_us == 0) {
+        lat_pending_key_mode = m;
+        lat_pending_key_us = key_us;
+    }
+}
+
+static void latOutputArrived(uint32_t first_us) {
+    if (lat_pending_output_us == 0) lat_pending_output_us = first_us;
+}
+
+static void latKeySent() {
+    if (lat_pending_echo_us == 0) lat_pending_echo_us = latNowUs();
+}
+
+static void latEchoArrived(uint32_t now_us) {
+    uint32_t sent = lat_pending_echo_us;
+    if (sent == 0) return;
+    lat_pending_echo_us = 0;
+    latRecord(lat_ssh_echo, now_us - sent);
+}
+
+// Per-frame capture, filled by latFrameBegin and closed by latFrameEnd.
+struct LatFrame {
+    uint32_t start_us;
+    uint32_t key_us;
+    uint32_t output_us;
+    uint8_t key_mode;
+};
+
+static void latFrameBegin(LatFrame& f, bool terminal) {
+    f.start_us = micros();
+    f.key_us = lat_pending_key_us;
+    f.key_mode = lat_pending_key_mode;
+    lat_pending_key_us = 0;
+    f.output_us = 0;
+    if (terminal) {
+        f.output_us = lat_pending_output_us;
+        lat_pending_output_us = 0;
+    }
+    if (f.key_us && f.key_mode < LAT_MODE_COUNT) {
+        latRecord(lat_key[f.key_mode][LAT_KEY_SNAPSHOT], f.start_us - f.key_us);
+    }
+    lat_frame_spi_done_us = 0;
+    lat_frame_active = true;
+}
+
+static void latFrameEnd(const LatFrame& f) {
+    lat_frame_active = false;
+    uint32_t done = micros();
+    latRecord(lat_frame_render, done - f.start_us);
+    if (f.key_us && f.key_mode < LAT_MODE_COUNT) {
+        uint32_t spi = lat_frame_spi_done_us;
+        if (spi) latRecord(lat_key[f.key_mode][LAT_KEY_SPI_DONE], spi - f.key_us);
+        latRecord(lat_key[f.key_mode][LAT_KEY_PANEL], done - f.key_us);
+    }
+    if (f.output_us) latRecord(lat_ssh_panel, done - f.output_us);
+}
+
+// GxEPD2 busy callback: the first busy wait of a frame follows the data
+// transfer, so it marks the SPI-done point.
+static void latBusyCallback(const void*) {
+    if (lat_frame_active && lat_frame_spi_done_us == 0) lat_frame_spi_done_us = latNowUs();
+}
+
+static void latResetAll() {
+    memset(lat_key, 0, sizeof(lat_key));
+    memset(&lat_ssh_panel, 0, sizeof(lat_ssh_panel));
+    memset(&lat_ssh_echo, 0, sizeof(lat_ssh_echo));
+    memset(&lat_ssh_rx_wait, 0, sizeof(lat_ssh_rx_wait));
+    memset(&lat_frame_render, 0, sizeof(lat_frame_render));
+}
+
+static void latPrintHist(const char* name, const LatencyHist& h) {
+    Serial.printf("LAT %s n=%lu sum_us=%llu max_us=%lu b=", name,
+                  (unsigned long)h.count, (unsigned long long)h.sum_us, (unsigned long)h.max_us);
+    for (int i = 0; i < LAT_BUCKETS; i++) {
+        Serial.printf(i ? ",%lu" : "%lu", (unsigned long)h.bucket[i]);
+    }
+    Serial.print("\n");
+}
+
+// One line per histogram, closed by "LAT END".
+static void latDumpAll() {
+    char name[32];
+    for (int m = 0; m < LAT_MODE_COUNT; m++) {
+        for (int s = 0; s < LAT_STAGE_COUNT; s++) {
+            snprintf(name, sizeof(name), "%s.key_%s", lat_mode_names[m], lat_stage_names[s]);
+            latPrintHist(name, lat_key[m][s]);
+        }
+    }
+    latPrintHist("ssh.panel", lat_ssh_panel);
+    latPrintHist("ssh.echo", lat_ssh_echo);
+    latPrintHist("ssh.rx_wait", lat_ssh_rx_wait);
+    latPrintHist("frame.render", lat_frame_render);
+    Serial.println("LAT END");
+}
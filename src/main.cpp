@@ -10,6 +10,8 @@
 #include <driver/gpio.h>
 #include <esp_netif.h>
 #include <lwip/dns.h>
+#include <esp_vfs_eventfd.h>
+#include <sys/select.h>
 #include <SD.h>
 #include <FS.h>
 #include <WireGuard-ESP32.h>
@@ -44,6 +46,7 @@ static char config_ssh_vpn_host[64] = "";
 static int  config_ssh_port       = 22;
 static char config_ssh_user[64]   = "";
 static char config_ssh_pass[64]   = "";
+static int  config_ssh_tx_ms      = 10;   // key batching window, 0 = write each key at once
 
 // --- Bluetooth Config (loaded from SD /CONFIG) ---
 static bool     config_bt_enabled = false;
@@ -71,11 +74,31 @@ static char config_files_url[128] = "";
 // Forward declarations
 void connectMsg(const char* fmt, ...);
 void powerOff();
+void journalNoteInsert(int off, char c);
+void journalNoteErase(int off);
+void journalDetach();
 static int partial_count = 0;
 static volatile uint32_t perf_window_start_ms = 0;
 static volatile uint32_t perf_heap_min5_kb = 0;
 static volatile uint32_t perf_render_max5_ms = 0;
 static volatile uint32_t perf_loop_max5_ms = 0;
+static volatile uint32_t perf_frame_wait_last_ms = 0;
+static volatile uint32_t perf_frame_wait_max5_ms = 0;
+static volatile uint32_t perf_frame_render_last_ms = 0;
+// Key event queue stats since boot: worst time from keypad read to handler,
+// deepest queue, and events lost to a TCA8418 FIFO overflow.
+static volatile uint32_t perf_key_block_max_ms = 0;
+static volatile uint32_t perf_key_queue_hw = 0;
+static volatile uint32_t perf_key_drop_count = 0;
+// Touch pipeline: INT edge to sample read, sample rate, and BT motion
+// reports (rate, worst time from first coalesced sample to report).
+static volatile uint32_t perf_touch_lat_max_us = 0;
+static volatile uint32_t perf_touch_samples = 0;
+static volatile uint32_t perf_touch_rate_hz = 0;
+static volatile uint32_t perf_touch_drop_count = 0;  // edges lost to a full sample FIFO
+static volatile uint32_t perf_bt_move_reports = 0;
+static volatile uint32_t perf_bt_move_rate_hz = 0;
+static volatile uint32_t perf_bt_move_lat_max_ms = 0;
 static constexpr uint32_t PERF_WINDOW_MS = 5000U;
 static void perfRecordRenderMs(uint32_t render_ms);
 static void perfLoopTick();
@@ -111,8 +134,7 @@ static int16_t touch_last_x = 0;
 static int16_t touch_last_y = 0;
 static unsigned long touch_start_ms = 0;
 static bool touch_did_scroll = false;
-static unsigned long last_touch_poll = 0;
-static constexpr unsigned long TOUCH_POLL_INTERVAL_MS = 90;
+static constexpr uint32_t LOOP_IDLE_WAIT_MS = 10;  // loop() sleep between passes unless a key arrives
 static constexpr int16_t TOUCH_SCROLL_THRESHOLD = 16; // 2 text lines worth of pixels
 static constexpr unsigned long TOUCH_TAP_MAX_MS = 300;
 static constexpr int16_t TOUCH_TAP_DEADZONE_X = SCREEN_W / 8;
@@ -187,16 +209,43 @@ static int mount_list_count = 0;
 static bool mountActive() { return active_mount.length() > 0 && config_files_url[0] != '\0'; }
 
 static SemaphoreHandle_t state_mutex;
+
+// Terminal grid, scrollback and parser state. The parser holds it for one
+// slice of output at a time (term_rx_module). Take it after state_mutex,
+// never the other way round.
+static SemaphoreHandle_t term_mutex;
+
+static inline void termLock() { xSemaphoreTake(term_mutex, portMAX_DELAY); }
+static inline void termUnlock() { xSemaphoreGive(term_mutex); }
+
+// --- Render Requests ---
+// Producers OR dirty hints into the display task's notification value; the
+// display task sleeps until one arrives. Source bits (typing/output) only
+// steer frame coalescing.
+enum RenderHint : uint32_t {
+    RENDER_EDITOR   = 1U << 0,  // notepad / command / trackpad screen content
+    RENDER_TERMINAL = 1U << 1,  // terminal grid or connect screen
+    RENDER_STATUS   = 1U << 2,  // status bar only (battery, radio state)
+    RENDER_SCROLL   = 1U << 3,  // viewport moved: redraw the whole text area
+    RENDER_TYPING   = 1U << 4,  // caused by a keystroke
+    RENDER_OUTPUT   = 1U << 5,  // caused by SSH output
+};
+static TaskHandle_t display_task_handle = NULL;
+static volatile uint32_t render_request_first_ms = 0;  // oldest unserved request, 0 = none
+
+static void requestRender(uint32_t hints) {
+    if (render_request_first_ms == 0) render_request_first_ms = millis() | 1U;
+    if (display_task_handle) xTaskNotify(display_task_handle, hints, eSetBits);
+}
 // Protects libssh channel I/O across cores (receive task vs input writers).
 static SemaphoreHandle_t ssh_io_mutex;
-static volatile bool render_requested = false;
 static volatile bool poweroff_requested = false;
 static unsigned long boot_pressed_since = 0;
 static bool boot_sleep_latched = false;
 static constexpr unsigned long BOOT_SLEEP_HOLD_MS = 0;
 
-// Editor state — written by core 1 (keyboard), read by core 0 (display)
-static char text_buf[MAX_TEXT_LEN + 1];
+// Editor state — written by core 1 (keyboard), read by core 0 (display).
+// The document itself is a PSRAM piece table in text_buffer_module.hpp.
 static int  text_len    = 0;
 static int  cursor_pos  = 0;
 static int  scroll_line = 0;
@@ -205,11 +254,16 @@ static bool sym_mode    = false;
 static bool alt_mode    = false;   // Ctrl modifier in terminal, unused in notepad
 static unsigned long terminal_last_ctrl_c_ms = 0;
 
-// Display task snapshot — private to core 0
-static char snap_buf[MAX_TEXT_LEN + 1];
+// Display task snapshot — private to core 0. Holds only the visible window:
+// snap_buf starts at visual line snap_scroll, snap_line_off[r] is the offset
+// of screen row r within it, and snap_cursor is relative to snap_buf.
+#define SNAP_BUF_LEN (ROWS_PER_SCREEN * (COLS_PER_LINE + 1))
+static char snap_buf[SNAP_BUF_LEN + 1];
+static int  snap_line_off[ROWS_PER_SCREEN + 1];
 static int  snap_len       = 0;
 static int  snap_cursor    = 0;
 static int  snap_scroll    = 0;
+static int  snap_total_lines = 1;
 static bool snap_shift     = false;
 static bool snap_sym       = false;
 
@@ -221,56 +275,7 @@ enum TouchTapArrow {
     TOUCH_TAP_ARROW_RIGHT,
 };
 
-// --- Terminal State (shared, protected by state_mutex) ---
-
-static char term_buf[TERM_ROWS][TERM_COLS + 1];
-static int  term_line_count = 1;
-static int  term_scroll     = 0;
-static int  term_cursor_row = 0;
-static int  term_cursor_col = 0;
-static volatile bool term_render_requested = false;
-
-// Terminal snapshot — private to core 0
-static char term_snap_buf[TERM_ROWS][TERM_COLS + 1];
-static int  term_snap_lines  = 1;
-static int  term_snap_scroll = 0;
-static int  term_snap_crow   = 0;
-static int  term_snap_ccol   = 0;
-
-// ANSI escape parser state
-static bool in_escape  = false;
-static bool in_bracket = false;
-#define MAX_CSI_PARAMS 8
-static int  csi_params[MAX_CSI_PARAMS];
-static int  csi_param_count = 0;
-static bool csi_parsing_num = false;
-static bool csi_private = false;      // '?' seen in CSI params
-// Mouse reporting modes requested by remote terminal app (DECSET private modes).
-static uint8_t term_mouse_tracking_mode_mask = 0; // ?1000/?1002/?1003
-static bool term_mouse_sgr_mode = false;          // ?1006
-
-// Scroll region (0-based screen rows)
-static int scroll_region_top = 0;
-static int scroll_region_bot = ROWS_PER_SCREEN - 1;
-static bool scroll_region_set = false;  // explicitly set by CSI r
-
-// Alternate screen buffer
-static char term_alt_buf[TERM_ROWS][TERM_COLS + 1];
-static bool term_alt_active = false;
-static int saved_main_cursor_row = 0, saved_main_cursor_col = 0;
-static int saved_main_line_count = 0, saved_main_scroll = 0;
-
-// Cursor save/restore (ESC 7/8, CSI s/u)
-static int saved_cursor_row = 0, saved_cursor_col = 0;
-
-// Cursor visibility
-static bool cursor_visible = true;
-static bool term_snap_cursor_visible = true;
-static bool term_wrap_pending = false; // delayed wrap after writing at last column
-
-// UTF-8 parsing state
-static int utf8_remaining = 0;
-static uint32_t utf8_codepoint = 0;
+#include "term_state_module.hpp"
 
 #if TDECK_AGENT_DEBUG
 // Debug trace ring for SSH terminal parser input.
@@ -336,10 +341,10 @@ void terminalDebugTraceDump(int max_bytes) {
 
 void terminalDebugStateDump() {
     SERIAL_LOGF(
-        "AGENT OK TERMDBG row=%d col=%d scroll=%d lines=%d wrap=%d esc=%d csi=%d priv=%d utf8_rem=%d utf8_cp=%lu alt=%d sr_top=%d sr_bot=%d sr_set=%d\n",
+        "AGENT OK TERMDBG row=%d col=%d scroll=%d lines=%d wrap=%d vt=%d params=%d priv=%d utf8_rem=%d utf8_cp=%lu alt=%d sr_top=%d sr_bot=%d sr_set=%d\n",
         term_cursor_row, term_cursor_col, term_scroll, term_line_count,
         term_wrap_pending ? 1 : 0,
-        in_escape ? 1 : 0, in_bracket ? 1 : 0, csi_private ? 1 : 0,
+        vt_state, csi_param_count, csi_private ? 1 : 0,
         utf8_remaining, (unsigned long)utf8_codepoint,
         term_alt_active ? 1 : 0, scroll_region_top, scroll_region_bot, scroll_region_set ? 1 : 0
     );
@@ -360,6 +365,28 @@ static ssh_channel  ssh_chan     = NULL;
 static volatile bool ssh_connected = false;
 static TaskHandle_t ssh_recv_task_handle = NULL;
 static char ssh_last_host[64] = "";
+static char ssh_target_host[64] = "";   // `ssh <host>`; empty = config host
+
+// Terminal sessions (term_session_module). The SSH globals above, the
+// terminal state and term_rx[term_session_active] belong to the session on
+// screen. The others are parked in term_sessions[] and keep receiving and
+// parsing in the background; a switch swaps them under ssh_io_mutex and
+// term_mutex, so either lock is enough to read a consistent view.
+static constexpr int TERM_SESSIONS = 3;
+struct TermState;
+struct TermSession {
+    ssh_session sess;               // parked connection, NULL while on screen
+    ssh_channel chan;
+    volatile bool connected;
+    char last_host[64];
+    char target_host[64];
+    TermState* term;                // parked terminal state (PSRAM)
+    char (*main_store)[TERM_COLS + 1];   // PSRAM rows for the parked grids
+    char (*alt_store)[TERM_COLS + 1];
+    volatile bool unseen;           // output arrived while in the background
+};
+static TermSession term_sessions[TERM_SESSIONS];
+static volatile int term_session_active = 0;
 
 // --- WiFi State ---
 
@@ -377,29 +404,7 @@ struct LayoutInfo {
     int cursor_col;
 };
 
-LayoutInfo computeLayoutFrom(const char* buf, int len, int cpos) {
-    LayoutInfo info = {0, 0, 0};
-    int line = 0, col = 0;
-
-    for (int i = 0; i < len; i++) {
-        if (i == cpos) {
-            info.cursor_line = line;
-            info.cursor_col  = col;
-        }
-        if (buf[i] == '\n') {
-            line++; col = 0;
-        } else {
-            col++;
-            if (col >= COLS_PER_LINE) { line++; col = 0; }
-        }
-    }
-    if (cpos == len) {
-        info.cursor_line = line;
-        info.cursor_col  = col;
-    }
-    info.total_lines = line + 1;
-    return info;
-}
+#include "text_buffer_module.hpp"
 
 static void perfRecordRenderMs(uint32_t render_ms) {
     uint32_t now = millis();
@@ -409,11 +414,22 @@ static void perfRecordRenderMs(uint32_t render_ms) {
     }
 }
 
+// Per-frame timings: request queued -> frame start, frame start -> done.
+static void perfRecordFrame(uint32_t wait_ms, uint32_t render_ms) {
+    perf_frame_wait_last_ms = wait_ms;
+    perf_frame_render_last_ms = render_ms;
+    perfRecordRenderMs(render_ms);
+    if (wait_ms > perf_frame_wait_max5_ms) {
+        perf_frame_wait_max5_ms = wait_ms;
+    }
+}
+
 static void perfMaybeRollWindow(uint32_t now_ms) {
     uint32_t start_ms = perf_window_start_ms;
     if (start_ms == 0 || now_ms - start_ms >= PERF_WINDOW_MS) {
         perf_window_start_ms = now_ms;
         perf_render_max5_ms = 0;
+        perf_frame_wait_max5_ms = 0;
         perf_loop_max5_ms = 0;
         perf_heap_min5_kb = ESP.getFreeHeap() / 1024U;
     }
@@ -454,642 +470,29 @@ static void buildPerfStatusCompact(char* out, size_t out_len) {
              (unsigned long)perf_loop_max5_ms);
 }
 
-// --- Terminal Buffer Operations ---
-
-static uint8_t termMouseTrackingModeBit(int mode) {
-    switch (mode) {
-        case 1000: return 0x01; // button-event tracking
-        case 1002: return 0x02; // button-motion tracking
-        case 1003: return 0x04; // any-motion tracking
-        default:   return 0x00;
-    }
-}
-
-void terminalClear() {
-    for (int i = 0; i < TERM_ROWS; i++) {
-        memset(term_buf[i], ' ', TERM_COLS);
-        term_buf[i][TERM_COLS] = '\0';
-    }
-    term_line_count = 1;
-    term_scroll     = 0;
-    term_cursor_row = 0;
-    term_cursor_col = 0;
-    in_escape  = false;
-    in_bracket = false;
-    csi_param_count = 0;
-    csi_parsing_num = false;
-    csi_private = false;
-    term_mouse_tracking_mode_mask = 0;
-    term_mouse_sgr_mode = false;
-    scroll_region_top = 0;
-    scroll_region_bot = ROWS_PER_SCREEN - 1;
-    scroll_region_set = false;
-    term_alt_active = false;
-    cursor_visible = true;
-    term_wrap_pending = false;
-    utf8_remaining = 0;
-    utf8_codepoint = 0;
-    saved_cursor_row = 0;
-    saved_cursor_col = 0;
-}
-
-void terminalScrollRegionUp(int top, int bot) {
-    if (top < 0) top = 0;
-    if (bot >= TERM_ROWS) bot = TERM_ROWS - 1;
-    for (int i = top; i < bot; i++) {
-        memcpy(term_buf[i], term_buf[i + 1], TERM_COLS + 1);
-    }
-    memset(term_buf[bot], ' ', TERM_COLS);
-    term_buf[bot][TERM_COLS] = '\0';
-}
-
-void terminalScrollRegionDown(int top, int bot) {
-    if (top < 0) top = 0;
-    if (bot >= TERM_ROWS) bot = TERM_ROWS - 1;
-    for (int i = bot; i > top; i--) {
-        memcpy(term_buf[i], term_buf[i - 1], TERM_COLS + 1);
-    }
-    memset(term_buf[top], ' ', TERM_COLS);
-    term_buf[top][TERM_COLS] = '\0';
-}
-
-// Map Unicode codepoint to printable ASCII (box drawing, symbols)
-char unicodeToAscii(uint32_t cp) {
-    // Box drawing: U+2500-U+257F
-    if (cp >= 0x2500 && cp <= 0x257F) {
-        // Horizontal lines
-        if (cp == 0x2500 || cp == 0x2501 || cp == 0x2504 || cp == 0x2505 ||
-            cp == 0x2508 || cp == 0x2509 || cp == 0x254C || cp == 0x254D ||
-            cp == 0x2550) return '-';
-        // Vertical lines
-        if (cp == 0x2502 || cp == 0x2503 || cp == 0x2506 || cp == 0x2507 ||
-            cp == 0x250A || cp == 0x250B || cp == 0x254E || cp == 0x254F ||
-            cp == 0x2551) return '|';
-        // Everything else (corners, tees, crosses)
-        return '+';
-    }
-    // Block elements: U+2580-U+259F
-    if (cp >= 0x2580 && cp <= 0x259F) return '#';
-    // Common symbols
-    if (cp == 0x2713 || cp == 0x2714) return '*';  // checkmarks
-    if (cp == 0x2022 || cp == 0x25CF) return '*';  // bullets
-    if (cp == 0x25CB || cp == 0x25A0 || cp == 0x25A1) return '*';  // circles/squares
-    if (cp == 0x2192) return '>';  // right arrow
-    if (cp == 0x2190) return '<';  // left arrow
-    if (cp == 0x2191) return '^';  // up arrow
-    if (cp == 0x2193) return 'v';  // down arrow
-    if (cp == 0x2026) return '.';  // ellipsis
-    if (cp == 0x2014 || cp == 0x2013) return '-';  // em/en dash
-    if (cp == 0x2018 || cp == 0x2019) return '\''; // smart quotes
-    if (cp == 0x201C || cp == 0x201D) return '"';   // smart double quotes
-    return 0;  // unknown - skip
-}
-
-void enterAltScreen() {
-    if (term_alt_active) return;
-    // Save main buffer state
-    for (int i = 0; i < TERM_ROWS; i++)
-        memcpy(term_alt_buf[i], term_buf[i], TERM_COLS + 1);
-    saved_main_cursor_row = term_cursor_row;
-    saved_main_cursor_col = term_cursor_col;
-    saved_main_line_count = term_line_count;
-    saved_main_scroll = term_scroll;
-    // Clear screen for alt buffer
-    for (int i = 0; i < TERM_ROWS; i++) {
-        memset(term_buf[i], ' ', TERM_COLS);
-        term_buf[i][TERM_COLS] = '\0';
-    }
-    term_cursor_row = 0;
-    term_cursor_col = 0;
-    term_line_count = 1;
-    term_scroll = 0;
-    term_wrap_pending = false;
-    scroll_region_top = 0;
-    scroll_region_bot = ROWS_PER_SCREEN - 1;
-    scroll_region_set = false;
-    term_alt_active = true;
-}
-
-void leaveAltScreen() {
-    if (!term_alt_active) return;
-    // Restore main buffer
-    for (int i = 0; i < TERM_ROWS; i++)
-        memcpy(term_buf[i], term_alt_buf[i], TERM_COLS + 1);
-    term_cursor_row = saved_main_cursor_row;
-    term_cursor_col = saved_main_cursor_col;
-    term_line_count = saved_main_line_count;
-    term_scroll = saved_main_scroll;
-    term_wrap_pending = false;
-    scroll_region_top = 0;
-    scroll_region_bot = ROWS_PER_SCREEN - 1;
-    scroll_region_set = false;
-    term_alt_active = false;
-}
-
-void handleCSI(char final_char) {
-    int p0 = (csi_param_count > 0) ? csi_params[0] : 0;
-    int p1 = (csi_param_count > 1) ? csi_params[1] : 0;
-    int max_row = term_alt_active ? ROWS_PER_SCREEN : TERM_ROWS;
-
-    // Formatting-only CSI (SGR) should not consume delayed-wrap state.
-    if (final_char != 'm') term_wrap_pending = false;
-
-    // Handle private mode sequences (CSI ? ...)
-    if (csi_private) {
-        if (final_char == 'h') {
-            // Set mode
-            for (int pi = 0; pi < csi_param_count; pi++) {
-                switch (csi_params[pi]) {
-                    case 1049: // Alt screen + save cursor
-                        saved_cursor_row = term_cursor_row;
-                        saved_cursor_col = term_cursor_col;
-                        enterAltScreen();
-                        break;
-                    case 47:   // Alt screen (no cursor save)
-                    case 1047:
-                        enterAltScreen();
-                        break;
-                    case 25:   // Show cursor
-                        cursor_visible = true;
-                        break;
-                    case 1000:
-                    case 1002:
-                    case 1003:
-                        term_mouse_tracking_mode_mask |= termMouseTrackingModeBit(csi_params[pi]);
-                        break;
-                    case 1006:
-                        term_mouse_sgr_mode = true;
-                        break;
-                }
-            }
-        } else if (final_char == 'l') {
-            // Reset mode
-            for (int pi = 0; pi < csi_param_count; pi++) {
-                switch (csi_params[pi]) {
-                    case 1049: // Leave alt screen + restore cursor
-                        leaveAltScreen();
-                        term_cursor_row = saved_cursor_row;
-                        term_cursor_col = saved_cursor_col;
-                        break;
-                    case 47:
-                    case 1047:
-                        leaveAltScreen();
-                        break;
-                    case 25:   // Hide cursor
-                        cursor_visible = false;
-                        break;
-                    case 1000:
-                    case 1002:
-                    case 1003:
-                        term_mouse_tracking_mode_mask &= (uint8_t)~termMouseTrackingModeBit(csi_params[pi]);
-                        break;
-                    case 1006:
-                        term_mouse_sgr_mode = false;
-                        break;
-                }
-            }
-        }
-        return;
-    }
-
-    switch (final_char) {
-        case 'A': // Cursor Up
-            term_cursor_row -= (p0 > 0) ? p0 : 1;
-            if (term_cursor_row < 0) term_cursor_row = 0;
-            break;
-        case 'B': // Cursor Down
-            term_cursor_row += (p0 > 0) ? p0 : 1;
-            if (term_cursor_row >= max_row) term_cursor_row = max_row - 1;
-            break;
-        case 'C': // Cursor Right
-            term_cursor_col += (p0 > 0) ? p0 : 1;
-            if (term_cursor_col >= TERM_COLS) term_cursor_col = TERM_COLS - 1;
-            break;
-        case 'D': // Cursor Left
-            term_cursor_col -= (p0 > 0) ? p0 : 1;
-            if (term_cursor_col < 0) term_cursor_col = 0;
-            break;
-        case 'E': // Cursor Next Line
-            term_cursor_col = 0;
-            term_cursor_row += (p0 > 0) ? p0 : 1;
-            if (term_cursor_row >= max_row) term_cursor_row = max_row - 1;
-            break;
-        case 'F': // Cursor Previous Line
-            term_cursor_col = 0;
-            term_cursor_row -= (p0 > 0) ? p0 : 1;
-            if (term_cursor_row < 0) term_cursor_row = 0;
-            break;
-        case 'H': // Cursor Position (row;col) — 1-based
-        case 'f': // Same as H
-            term_cursor_row = (p0 > 0) ? p0 - 1 : 0;
-            term_cursor_col = (p1 > 0) ? p1 - 1 : 0;
-            if (term_cursor_row >= max_row) term_cursor_row = max_row - 1;
-            if (term_cursor_col >= TERM_COLS) term_cursor_col = TERM_COLS - 1;
-            if (term_cursor_row >= term_line_count) term_line_count = term_cursor_row + 1;
-            break;
-        case 'J': // Erase in Display
-            if (p0 == 0) {
-                memset(&term_buf[term_cursor_row][term_cursor_col], ' ',
-                       TERM_COLS - term_cursor_col);
-                for (int r = term_cursor_row + 1; r < max_row; r++) {
-                    memset(term_buf[r], ' ', TERM_COLS);
-                }
-            } else if (p0 == 1) {
-                for (int r = 0; r < term_cursor_row; r++) {
-                    memset(term_buf[r], ' ', TERM_COLS);
-                }
-                memset(term_buf[term_cursor_row], ' ', term_cursor_col + 1);
-            } else if (p0 == 2 || p0 == 3) {
-                for (int r = 0; r < max_row; r++) {
-                    memset(term_buf[r], ' ', TERM_COLS);
-                }
-                term_cursor_row = 0;
-                term_cursor_col = 0;
-                term_line_count = 1;
-                term_scroll = 0;
-            }
-            break;
-        case 'K': // Erase in Line
-            if (p0 == 0) {
-                memset(&term_buf[term_cursor_row][term_cursor_col], ' ',
-                       TERM_COLS - term_cursor_col);
-            } else if (p0 == 1) {
-                memset(term_buf[term_cursor_row], ' ', term_cursor_col + 1);
-            } else if (p0 == 2) {
-                memset(term_buf[term_cursor_row], ' ', TERM_COLS);
-            }
-            break;
-        case 'G': // Cursor Horizontal Absolute
-            term_cursor_col = (p0 > 0) ? p0 - 1 : 0;
-            if (term_cursor_col >= TERM_COLS) term_cursor_col = TERM_COLS - 1;
-            break;
-        case 'd': // Cursor Vertical Absolute
-            term_cursor_row = (p0 > 0) ? p0 - 1 : 0;
-            if (term_cursor_row >= max_row) term_cursor_row = max_row - 1;
-            if (term_cursor_row >= term_line_count) term_line_count = term_cursor_row + 1;
-            break;
-        case 'P': { // Delete Characters
-            int n = (p0 > 0) ? p0 : 1;
-            int r = term_cursor_row;
-            int c = term_cursor_col;
-            if (c + n > TERM_COLS) n = TERM_COLS - c;
-            memmove(&term_buf[r][c], &term_buf[r][c + n], TERM_COLS - c - n);
-            memset(&term_buf[r][TERM_COLS - n], ' ', n);
-            break;
-        }
-        case '@': { // Insert Characters
-            int n = (p0 > 0) ? p0 : 1;
-            int r = term_cursor_row;
-            int c = term_cursor_col;
-            if (c + n > TERM_COLS) n = TERM_COLS - c;
-            memmove(&term_buf[r][c + n], &term_buf[r][c], TERM_COLS - c - n);
-            memset(&term_buf[r][c], ' ', n);
-            break;
-        }
-        case 'X': { // Erase Characters (overwrite with spaces, don't move cursor)
-            int n = (p0 > 0) ? p0 : 1;
-            int c = term_cursor_col;
-            if (c + n > TERM_COLS) n = TERM_COLS - c;
-            memset(&term_buf[term_cursor_row][c], ' ', n);
-            break;
-        }
-        case 'L': { // Insert Lines (within scroll region)
-            int n = (p0 > 0) ? p0 : 1;
-            int bot = (term_alt_active || scroll_region_set) ? scroll_region_bot : max_row - 1;
-            for (int j = bot; j >= term_cursor_row + n; j--) {
-                memcpy(term_buf[j], term_buf[j - n], TERM_COLS + 1);
-            }
-            for (int j = term_cursor_row; j < term_cursor_row + n && j <= bot; j++) {
-                memset(term_buf[j], ' ', TERM_COLS);
-                term_buf[j][TERM_COLS] = '\0';
-            }
-            break;
-        }
-        case 'M': { // Delete Lines (within scroll region)
-            int n = (p0 > 0) ? p0 : 1;
-            int bot = (term_alt_active || scroll_region_set) ? scroll_region_bot : max_row - 1;
-            for (int j = term_cursor_row; j + n <= bot; j++) {
-                memcpy(term_buf[j], term_buf[j + n], TERM_COLS + 1);
-            }
-            for (int j = bot - n + 1; j <= bot; j++) {
-                if (j >= 0) {
-                    memset(term_buf[j], ' ', TERM_COLS);
-                    term_buf[j][TERM_COLS] = '\0';
-                }
-            }
-            break;
-        }
-        case 'S': { // Scroll Up (within scroll region)
-            int n = (p0 > 0) ? p0 : 1;
-            for (int j = 0; j < n; j++)
-                terminalScrollRegionUp(scroll_region_top, scroll_region_bot);
-            break;
-        }
-        case 'T': { // Scroll Down (within scroll region)
-            int n = (p0 > 0) ? p0 : 1;
-            for (int j = 0; j < n; j++)
-                terminalScrollRegionDown(scroll_region_top, scroll_region_bot);
-            break;
-        }
-        case 'r': { // Set Scroll Region (top;bottom, 1-based)
-            if (p0 == 0 && p1 == 0) {
-                // Reset scroll region
-                scroll_region_top = 0;
-                scroll_region_bot = ROWS_PER_SCREEN - 1;
-                scroll_region_set = false;
-            } else {
-                scroll_region_top = (p0 > 0) ? p0 - 1 : 0;
-                scroll_region_bot = (p1 > 0) ? p1 - 1 : ROWS_PER_SCREEN - 1;
-                if (scroll_region_top < 0) scroll_region_top = 0;
-                if (scroll_region_bot >= ROWS_PER_SCREEN) scroll_region_bot = ROWS_PER_SCREEN - 1;
-                if (scroll_region_top >= scroll_region_bot) {
-                    scroll_region_top = 0;
-                    scroll_region_bot = ROWS_PER_SCREEN - 1;
-                }
-                scroll_region_set = true;
-            }
-            term_cursor_row = 0;
-            term_cursor_col = 0;
-            break;
-        }
-        case 's': // Save cursor position
-            saved_cursor_row = term_cursor_row;
-            saved_cursor_col = term_cursor_col;
-            break;
-        case 'u': // Restore cursor position
-            term_cursor_row = saved_cursor_row;
-            term_cursor_col = saved_cursor_col;
-            break;
-        case 'h': // Set mode (non-private)
-        case 'l': // Reset mode (non-private)
-            break;  // ignore standard modes
-        default:
-            break;
-    }
-}
-
-// Handle cursor moving past bottom of scroll region or screen
-void terminalCursorDown() {
-    if (term_alt_active || scroll_region_set) {
-        // Screen-bounded mode: scroll region
-        if (term_cursor_row == scroll_region_bot) {
-            terminalScrollRegionUp(scroll_region_top, scroll_region_bot);
-        } else if (term_cursor_row < scroll_region_bot) {
-            term_cursor_row++;
-        }
-    } else {
-        // Main screen: scrollback mode
-        term_cursor_row++;
-        if (term_cursor_row >= TERM_ROWS) {
-            terminalScrollRegionUp(0, TERM_ROWS - 1);
-            term_cursor_row = TERM_ROWS - 1;
-        }
-        if (term_cursor_row >= term_line_count) {
-            term_line_count = term_cursor_row + 1;
-        }
-    }
-}
-
-void terminalPutChar(char ch) {
-    if (term_wrap_pending) {
-        term_cursor_col = 0;
-        terminalCursorDown();
-        term_wrap_pending = false;
-    }
-
-    term_buf[term_cursor_row][term_cursor_col] = ch;
-    if (term_cursor_col >= TERM_COLS - 1) {
-        term_wrap_pending = true;
-    } else {
-        term_cursor_col++;
-    }
-}
-
-void terminalAppendOutput(const char* data, int len) {
-    for (int i = 0; i < len; i++) {
-        unsigned char c = (unsigned char)data[i];
-        terminalDebugTraceRecord(c);
-
-        // UTF-8 multi-byte sequence continuation
-        if (utf8_remaining > 0) {
-            if ((c & 0xC0) == 0x80) {
-                utf8_codepoint = (utf8_codepoint << 6) | (c & 0x3F);
-                utf8_remaining--;
-                if (utf8_remaining == 0) {
-                    char mapped = unicodeToAscii(utf8_codepoint);
-                    if (mapped) terminalPutChar(mapped);
-                    // else skip unknown/zero-width characters
-                }
-            } else {
-                // Invalid continuation - reset and reprocess
-                utf8_remaining = 0;
-                i--; // reprocess this byte
-            }
-            continue;
-        }
-
-        // ANSI escape sequence handling
-        if (in_escape) {
-            if (!in_bracket) {
-                if (c == '[') {
-                    in_bracket = true;
-                    csi_param_count = 0;
-                    csi_parsing_num = false;
-                    csi_private = false;
-                    memset(csi_params, 0, sizeof(csi_params));
-                    continue;
-                }
-                if (c == ']') {
-                    // OSC sequence — skip until ST (ESC \ or BEL)
-                    in_escape = false;
-                    in_bracket = false;
-                    while (i + 1 < len) {
-                        i++;
-                        if ((unsigned char)data[i] == 0x07) break;
-                        if ((unsigned char)data[i] == 0x1B && i + 1 < len && data[i+1] == '\\') {
-                            i++;
-                            break;
-                        }
-                    }
-                    continue;
-                }
-                // Single char after ESC
-                in_escape = false;
-                switch (c) {
-                    case 'M': // Reverse Index — cursor up, scroll region down if at top
-                        term_wrap_pending = false;
-                        if (term_cursor_row == scroll_region_top) {
-                            terminalScrollRegionDown(scroll_region_top, scroll_region_bot);
-                        } else if (term_cursor_row > 0) {
-                            term_cursor_row--;
-                        }
-                        break;
-                    case 'D': // Index — cursor down, scroll region up if at bottom
-                        term_wrap_pending = false;
-                        if (term_cursor_row == scroll_region_bot) {
-                            terminalScrollRegionUp(scroll_region_top, scroll_region_bot);
-                        } else {
-                            terminalCursorDown();
-                        }
-                        break;
-                    case 'E': // Next Line — cursor to start of next line
-                        term_wrap_pending = false;
-                        term_cursor_col = 0;
-                        terminalCursorDown();
-                        break;
-                    case '7': // Save cursor
-                        saved_cursor_row = term_cursor_row;
-                        saved_cursor_col = term_cursor_col;
-                        break;
-                    case '8': // Restore cursor
-                        term_wrap_pending = false;
-                        term_cursor_row = saved_cursor_row;
-                        term_cursor_col = saved_cursor_col;
-                        break;
-                    case 'c': // Full reset
-                        term_wrap_pending = false;
-                        terminalClear();
-                        break;
-                    case '(': case ')': case '*': case '+':
-                        // Character set designation — skip next byte
-                        if (i + 1 < len) i++;
-                        break;
-                    default:
-                        break; // ignore unknown ESC sequences
-                }
-                continue;
-            }
-            // Inside ESC[ ... collecting parameters
-            if (c >= '0' && c <= '9') {
-                if (!csi_parsing_num) {
-                    if (csi_param_count < MAX_CSI_PARAMS) {
-                        csi_params[csi_param_count] = 0;
-                        csi_parsing_num = true;
-                    }
-                }
-                if (csi_param_count < MAX_CSI_PARAMS) {
-                    csi_params[csi_param_count] = csi_params[csi_param_count] * 10 + (c - '0');
-                }
-                continue;
-            }
-            if (c == ';') {
-                if (csi_parsing_num) {
-                    csi_param_count++;
-                    csi_parsing_num = false;
-                } else {
-                    if (csi_param_count < MAX_CSI_PARAMS) {
-                        csi_params[csi_param_count] = 0;
-                    }
-                    csi_param_count++;
-                }
-                continue;
-            }
-            if (c == '?') {
-                csi_private = true;
-                continue;
-            }
-            if (c == '>' || c == '!' || c == ' ') {
-                // Other prefixes/intermediates — continue collecting
-                continue;
-            }
-            // Final character — execute CSI sequence
-            if ((c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z') || c == '@' || c == '`') {
-                if (csi_parsing_num && csi_param_count < MAX_CSI_PARAMS) {
-                    csi_param_count++;
-                }
-                handleCSI((char)c);
-                in_escape  = false;
-                in_bracket = false;
-            }
-            continue;
-        }
-
-        if (c == 0x1B) { // ESC
-            in_escape  = true;
-            in_bracket = false;
-            continue;
-        }
-
-        // UTF-8 start bytes
-        if ((c & 0xE0) == 0xC0) { // 2-byte sequence
-            utf8_codepoint = c & 0x1F;
-            utf8_remaining = 1;
-            continue;
-        }
-        if ((c & 0xF0) == 0xE0) { // 3-byte sequence
-            utf8_codepoint = c & 0x0F;
-            utf8_remaining = 2;
-            continue;
-        }
-        if ((c & 0xF8) == 0xF0) { // 4-byte sequence
-            utf8_codepoint = c & 0x07;
-            utf8_remaining = 3;
-            continue;
-        }
-
-        if (c == '\n') {
-            term_wrap_pending = false;
-            term_cursor_col = 0;
-            terminalCursorDown();
-            continue;
-        }
-
-        if (c == '\r') {
-            term_wrap_pending = false;
-            term_cursor_col = 0;
-            continue;
-        }
-
-        if (c == '\b' || c == 0x7F) {
-            if (term_wrap_pending) term_wrap_pending = false;
-            if (term_cursor_col > 0) {
-                term_cursor_col--;
-                term_buf[term_cursor_row][term_cursor_col] = ' ';
-            }
-            continue;
-        }
-
-        if (c == '\t') {
-            if (term_wrap_pending) term_wrap_pending = false;
-            int next_tab = (term_cursor_col + 8) & ~7;
-            if (next_tab > TERM_COLS) next_tab = TERM_COLS;
-            while (term_cursor_col < next_tab) {
-                term_buf[term_cursor_row][term_cursor_col] = ' ';
-                term_cursor_col++;
-            }
-            if (term_cursor_col >= TERM_COLS) {
-                term_cursor_col = 0;
-                terminalCursorDown();
-            }
-            continue;
-        }
-
-        // Printable ASCII characters
-        if (c >= ' ' && c <= '~') {
-            terminalPutChar((char)c);
-            continue;
-        }
-        // Non-printable / stray continuation bytes: ignore
-    }
-
-    // Auto-scroll to keep cursor visible
-    if (term_cursor_row >= term_scroll + ROWS_PER_SCREEN) {
-        term_scroll = term_cursor_row - ROWS_PER_SCREEN + 1;
-    }
-    if (term_cursor_row < term_scroll) {
-        term_scroll = term_cursor_row;
-    }
-}
+#include "latency_module.hpp"
+#include "scrollback_module.hpp"
+#include "term_predict_module.hpp"
+#include "term_emu_module.hpp"
 
 // --- SD Card ---
 
+// sd_mutex serialises SD users (loop, storage worker, transfers); sd_busy
+// then holds the display task off the shared SPI bus.
+static SemaphoreHandle_t sd_mutex = NULL;
+
 void sdAcquire() {
+    if (sd_mutex) xSemaphoreTake(sd_mutex, portMAX_DELAY);
     sd_busy = true;
     while (!display_idle) vTaskDelay(1);
 }
-void sdRelease() { sd_busy = false; }
+void sdRelease() {
+    sd_busy = false;
+    if (sd_mutex) xSemaphoreGive(sd_mutex);
+}
 
 void sdInit() {
+    if (!sd_mutex) sd_mutex = xSemaphoreCreateMutex();
     if (SD.begin(BOARD_SD_CS, SPI, 4000000)) {
         sd_mounted = true;
         SERIAL_LOGF("SD: mounted, size=%lluMB\n", SD.cardSize() / (1024 * 1024));
@@ -1201,6 +604,7 @@ void sdLoadConfig() {
                     strncpy(config_ssh_vpn_host, line.c_str(), 63);
                     config_ssh_vpn_host[63] = '\0';
                     break;
+                case 5: config_ssh_tx_ms = line.toInt(); break;
             }
             field++;
         } else if (section == SEC_VPN) {
@@ -1362,6 +766,7 @@ static int  cmd_picker_top = 0;
 
 // Implemented in cli_module.hpp.
 bool wifiPickerConnectSelectedNetwork(const char* ssid, bool open_network, bool known_network);
+bool handleCommandKeyPress(int event_code);
 
 int listDirectory(const char* path);
 bool loadFromFile(const char* path);
@@ -1805,36 +1210,47 @@ int listDirectory(const char* path) {
     return file_list_count;
 }
 
+#include "journal_module.hpp"
+
+#include "storage_module.hpp"
+
+// Queue a save; the storage worker reports the outcome in the result area.
 bool saveToFile(const char* path) {
-    sdAcquire();
-    File f = SD.open(path, FILE_WRITE);
-    if (!f) { sdRelease(); return false; }
-    f.write((const uint8_t*)text_buf, text_len);
-    f.close();
-    sdRelease();
-    file_modified = false;
-    return true;
+    return storageRequestSave(path, false, true, true);
 }
 
 bool loadFromFile(const char* path) {
+    storageWaitIdle();
     sdAcquire();
+    journalRecoverPath(path);
     File f = SD.open(path, FILE_READ);
     if (!f) { sdRelease(); return false; }
+    // Stream the file into PSRAM in chunks; nothing is truncated.
     size_t sz = f.size();
-    if (sz > MAX_TEXT_LEN) sz = MAX_TEXT_LEN;
-    text_len = f.read((uint8_t*)text_buf, sz);
-    text_buf[text_len] = '\0';
-    cursor_pos = text_len;
-    scroll_line = 0;
+    char* data = (char*)textAlloc(sz + 1);
+    if (!data) { f.close(); sdRelease(); return false; }
+    size_t got = 0;
+    uint32_t crc = 0;
+    while (got < sz) {
+        size_t chunk = sz - got > 4096 ? 4096 : sz - got;
+        int n = f.read((uint8_t*)data + got, chunk);
+        if (n <= 0) break;
+        crc = crc32_le(crc, (const uint8_t*)data + got, n);
+        got += n;
+    }
     f.close();
+    if (!textAdoptOriginal(data, (int)got)) { sdRelease(); return false; }
+    journalAttach(path, (uint32_t)got, crc);
+    if (!journalReplay(path)) journalCompactNow(path);
     sdRelease();
+    scroll_line = 0;
     file_modified = false;
     return true;
 }
 
 void autoSaveDirty() {
-    if (!file_modified || text_len == 0) return;
     if (file_is_remote && mountActive()) {
+        if (!file_modified || text_len == 0) return;
         const char* s = current_file.c_str();
         const char* sl = strrchr(s, '/');
         const char* fname = sl ? sl + 1 : s;
@@ -1842,16 +1258,28 @@ void autoSaveDirty() {
         saveRemoteFile(fname);
         return;
     }
+    // Leaving a local file: fold its journal so the base file is complete.
+    if (!file_modified || text_len == 0) {
+        journalFoldCurrent();
+        return;
+    }
     if (current_file.length() == 0) current_file = "/UNSAVED";
-    saveToFile(current_file.c_str());
+    storageRequestSave(current_file.c_str(), true, false, true);
 }
 
+#include "term_rx_module.hpp"
 #include "time_sync_module.hpp"
 #include "network_module.hpp"
+#include "ssh_tx_module.hpp"
+#include "ssh_mux_module.hpp"
+#include "term_line_module.hpp"
+#include "term_session_module.hpp"
 #include "gnss_module.hpp"
 #include "modem_module.hpp"
 #include "meshtastic_module.hpp"
 #include "bluetooth_module.hpp"
+#include "framebuffer_module.hpp"
+#include "font_module.hpp"
 #include "screen_module.hpp"
 #include "keyboard_module.hpp"
 #include "cli_module.hpp"
@@ -1895,6 +1323,10 @@ static void terminalSendMouseWheel(bool wheel_up) {
 }
 
 static void terminalSendArrowKey(TouchTapArrow arrow) {
+    if (termLineArrow(arrow)) {
+        requestRender(RENDER_TERMINAL | RENDER_TYPING);
+        return;
+    }
     switch (arrow) {
         case TOUCH_TAP_ARROW_UP:    sshSendString("\x1b[A", 3); break;
         case TOUCH_TAP_ARROW_DOWN:  sshSendString("\x1b[B", 3); break;
@@ -1920,13 +1352,177 @@ static int8_t btClampMouseDelta(int value) {
     return (int8_t)value;
 }
 
-static void btTrackpadSendMove(int16_t raw_dx, int16_t raw_dy) {
+// --- Touch Sampling ---
+//
+// The CST226 pulls BOARD_TOUCH_INT low for every report while a finger is
+// down. touchTask reads each report at that native rate and sleeps while
+// the panel is idle. In BT mode it sums finger motion and sends one
+// btMouseMove per BLE connection interval. Samples for scroll and tap
+// gestures go through a small FIFO, so a press and release both reach
+// loop() even when it stalls between them; plain motion replaces the
+// queued motion sample, keeping only the latest position.
+
+struct TouchSample {
+    int16_t x;
+    int16_t y;
+    int8_t result;      // cst226ReadTouch(): 1=touched, 0=released, -1=I2C error
+    uint32_t ms;
+};
+
+static constexpr int TOUCH_FIFO_LEN = 16;
+
+static TaskHandle_t touch_task_handle = NULL;
+static portMUX_TYPE touch_sample_mux = portMUX_INITIALIZER_UNLOCKED;
+static TouchSample touch_fifo[TOUCH_FIFO_LEN];
+static int touch_fifo_head = 0;            // oldest queued sample
+static int touch_fifo_count = 0;
+static bool touch_fifo_motion_tail = false; // newest queued sample is plain motion
+static volatile uint32_t touch_isr_us = 0;
+
+// Motion not yet reported to the BLE host, in raw panel units.
+static int32_t bt_motion_acc_x = 0;
+static int32_t bt_motion_acc_y = 0;
+static uint32_t bt_motion_first_ms = 0;   // oldest unreported sample, 0 = none
+static uint32_t bt_motion_last_report_ms = 0;
+
+static void IRAM_ATTR touchIsr() {
+    touch_isr_us = micros();
+    BaseType_t woken = pdFALSE;
+    if (touch_task_handle) vTaskNotifyGiveFromISR(touch_task_handle, &woken);
+    portYIELD_FROM_ISR(woken);
+}
+
+// touchTask: queue a sample for loop(). motion marks a touched sample that
+// follows another touched one; it overwrites a queued motion sample that
+// loop() has not taken yet.
+static void touchQueueSample(const TouchSample& s, bool motion) {
+    portENTER_CRITICAL(&touch_sample_mux);
+    if (motion && touch_fifo_motion_tail) {
+        touch_fifo[(touch_fifo_head + touch_fifo_count - 1) % TOUCH_FIFO_LEN] = s;
+    } else if (touch_fifo_count < TOUCH_FIFO_LEN) {
+        touch_fifo[(touch_fifo_head + touch_fifo_count) % TOUCH_FIFO_LEN] = s;
+        touch_fifo_count++;
+        touch_fifo_motion_tail = motion;
+    } else {
+        perf_touch_drop_count++;
+    }
+    portEXIT_CRITICAL(&touch_sample_mux);
+}
+
+// loop(): take every queued sample, oldest first. Returns the count.
+static int touchTakeSamples(TouchSample* out) {
+    portENTER_CRITICAL(&touch_sample_mux);
+    int n = touch_fifo_count;
+    for (int i = 0; i < n; i++) out[i] = touch_fifo[(touch_fifo_head + i) % TOUCH_FIFO_LEN];
+    touch_fifo_head = (touch_fifo_head + n) % TOUCH_FIFO_LEN;
+    touch_fifo_count = 0;
+    touch_fifo_motion_tail = false;
+    portEXIT_CRITICAL(&touch_sample_mux);
+    return n;
+}
+
+// Send the accumulated motion once a connection interval has passed since
+// the previous report. Sub-step remainders carry over to the next report.
+static void btTrackpadFlushMotion(uint32_t now) {
+    if (bt_motion_first_ms == 0) return;
+    if (now - bt_motion_last_report_ms < btConnIntervalMs()) return;
+    int sx = bt_motion_acc_x / BT_TOUCH_MOVE_DIVISOR;
+    int sy = bt_motion_acc_y / BT_TOUCH_MOVE_DIVISOR;
+    if (sx == 0 && sy == 0) {
+        bt_motion_first_ms = 0;  // below one step; wait for more motion
+        return;
+    }
+    int8_t cx = btClampMouseDelta(sx);
+    int8_t cy = btClampMouseDelta(sy);
+    btMouseMove(cx, cy, 0);
+    bt_motion_acc_x -= cx * BT_TOUCH_MOVE_DIVISOR;
+    bt_motion_acc_y -= cy * BT_TOUCH_MOVE_DIVISOR;
+    uint32_t lat_ms = now - bt_motion_first_ms;
+    if (lat_ms > perf_bt_move_lat_max_ms) perf_bt_move_lat_max_ms = lat_ms;
+    perf_bt_move_reports++;
+    bt_motion_last_report_ms = now;
+    bool done = bt_motion_acc_x / BT_TOUCH_MOVE_DIVISOR == 0 &&
+                bt_motion_acc_y / BT_TOUCH_MOVE_DIVISOR == 0;
+    bt_motion_first_ms = done ? 0 : now;
+}
+
+static void btTrackpadAddMotion(int16_t raw_dx, int16_t raw_dy, uint32_t now) {
     if (raw_dx == 0 && raw_dy == 0) return;
-    int sx = raw_dx / BT_TOUCH_MOVE_DIVISOR;
-    int sy = raw_dy / BT_TOUCH_MOVE_DIVISOR;
-    if (sx == 0 && raw_dx != 0) sx = raw_dx > 0 ? 1 : -1;
-    if (sy == 0 && raw_dy != 0) sy = raw_dy > 0 ? 1 : -1;
-    btMouseMove(btClampMouseDelta(sx), btClampMouseDelta(sy), 0);
+    bt_motion_acc_x += raw_dx;
+    bt_motion_acc_y += raw_dy;
+    if (bt_motion_first_ms == 0) bt_motion_first_ms = now ? now : 1;
+    btTrackpadFlushMotion(now);
+}
+
+// Samples and BT reports per second over the last active one-second window.
+static void perfTouchRollRates(uint32_t now) {
+    static uint32_t window_ms = 0;
+    static uint32_t window_samples = 0;
+    static uint32_t window_reports = 0;
+    if (now - window_ms < 1000) return;
+    if (window_ms != 0 && now - window_ms < 2000) {
+        uint32_t span = now - window_ms;
+        perf_touch_rate_hz = (perf_touch_samples - window_samples) * 1000U / span;
+        perf_bt_move_rate_hz = (perf_bt_move_reports - window_reports) * 1000U / span;
+    }
+    window_ms = now;
+    window_samples = perf_touch_samples;
+    window_reports = perf_bt_move_reports;
+}
+
+static void touchTask(void* param) {
+    static constexpr uint32_t TOUCH_RELEASE_CHECK_MS = 60;  // finger down, INT quiet: poll for lift
+    bool down = false;
+    int16_t last_x = 0;
+    int16_t last_y = 0;
+    uint32_t last_read_ms = 0;
+    for (;;) {
+        TickType_t wait = down ? pdMS_TO_TICKS(TOUCH_RELEASE_CHECK_MS) : portMAX_DELAY;
+        if (bt_motion_first_ms != 0) {
+            uint32_t since = millis() - bt_motion_last_report_ms;
+            uint32_t interval = btConnIntervalMs();
+            TickType_t due = pdMS_TO_TICKS(since >= interval ? 1 : interval - since);
+            if (due < wait) wait = due;
+        }
+        bool edge = ulTaskNotifyTake(pdTRUE, wait) > 0;
+        uint32_t now = millis();
+        if (edge || (down && now - last_read_ms >= TOUCH_RELEASE_CHECK_MS)) {
+            uint32_t edge_us = touch_isr_us;
+            int16_t x = last_x;
+            int16_t y = last_y;
+            int result = cst226ReadTouch(&x, &y);
+            last_read_ms = now;
+            if (edge) {
+                uint32_t lat_us = micros() - edge_us;
+                if (lat_us > perf_touch_lat_max_us) perf_touch_lat_max_us = lat_us;
+            }
+            perf_touch_samples++;
+            perfTouchRollRates(now);
+
+            bool touched = result == 1;
+            TouchSample sample = { x, y, (int8_t)result, now };
+            touchQueueSample(sample, touched && down);
+            if (touched && down && app_mode == MODE_BT) {
+                btTrackpadAddMotion(x - last_x, y - last_y, now);
+            }
+            if (!touched) {
+                bt_motion_acc_x = 0;
+                bt_motion_acc_y = 0;
+                bt_motion_first_ms = 0;
+            }
+            down = touched;
+            last_x = x;
+            last_y = y;
+            if (loop_task_handle) xTaskNotifyGive(loop_task_handle);
+        }
+        btTrackpadFlushMotion(now);
+    }
+}
+
+void touchInputStart() {
+    if (!touch_available) return;
+    xTaskCreatePinnedToCore(touchTask, "touch", 3072, NULL, 2, &touch_task_handle, 1);
+    attachInterrupt(digitalPinToInterrupt(BOARD_TOUCH_INT), touchIsr, FALLING);
 }
 
 static TouchTapArrow touchTapArrowFromPoint(int16_t x, int16_t y) {
@@ -1960,7 +1556,7 @@ static void handleTouchArrowTapLocked(TouchTapArrow arrow) {
         else if (arrow == TOUCH_TAP_ARROW_LEFT) cursorLeft();
         else if (arrow == TOUCH_TAP_ARROW_RIGHT) cursorRight();
         if (cursor_pos != old_cursor) {
-            render_requested = true;
+            requestRender(RENDER_EDITOR);
         }
         return;
     }
@@ -1982,7 +1578,7 @@ static void handleTouchArrowTapLocked(TouchTapArrow arrow) {
             else if (arrow == TOUCH_TAP_ARROW_DOWN) changed = cmdHistoryBrowseLocked(1);
         }
         if (changed) {
-            render_requested = true;
+            requestRender(RENDER_EDITOR);
         }
     }
 }
@@ -2118,12 +1714,16 @@ void setup() {
 
     // Boost SPI clock from default 4MHz to 20MHz for faster data transfer
     display.epd2.selectSPI(SPI, SPISettings(20000000, MSBFIRST, SPI_MODE0));
+    // First busy wait of a frame marks the end of its SPI transfer.
+    display.epd2.setBusyCallback(latBusyCallback);
 
-    memset(text_buf, 0, sizeof(text_buf));
+    textClear();
 
     // Init SD card and load config (before display task to avoid SPI contention)
     sdInit();
     sdLoadConfig();
+    journalRecoverAll();
+    storageInit();
     timeSyncSetTimeZone(config_time_tz);
     gnssInit();
     modemInit();
@@ -2140,11 +1740,18 @@ void setup() {
     updateBattery();  // Seed battery_pct before the first status bar render.
 
     // Init terminal buffer
+    termHistoryInit();
     terminalClear();
 
     // Create mutex
     state_mutex = xSemaphoreCreateMutex();
+    term_mutex = xSemaphoreCreateMutex();
     ssh_io_mutex = xSemaphoreCreateMutex();
+    sshWakeInit();
+
+    // Interrupt-driven keypad reader feeds the key queue that loop() drains
+    keypadInputStart();
+    touchInputStart();
 
     // Launch display task on core 0 (Arduino loop runs on core 1)
     xTaskCreatePinnedToCore(
@@ -2153,10 +1760,15 @@ void setup() {
         8192,           // stack size
         NULL,           // parameter
         1,              // priority
-        NULL,           // task handle
+        &display_task_handle,  // task handle
         0               // core 0
     );
 
+    // Terminal output parser on core 0, fed by sshReceiveTask
+    termRxStart();
+    // Interactive channel writer on core 1, fed by sshSendKey/sshSendString
+    sshTxStart();
+
     SERIAL_LOGLN("Ready. Single-tap MIC for commands. Use `ssh` to open terminal.");
     SERIAL_LOGF("Free heap: %d bytes\n", ESP.getFreeHeap());
 }
@@ -2174,6 +1786,8 @@ void loop() {
     modemScanPoll();
     modemPowerNotifyPoll();
     gnssPoll();
+    storagePollResults();
+    journalFlushIdle();
 
     // Press BOOT to request power-off (same behavior as the "off" command).
     if (!poweroff_requested) {
@@ -2186,6 +1800,7 @@ void loop() {
             if (!boot_sleep_latched && (now - boot_pressed_since >= BOOT_SLEEP_HOLD_MS)) {
                 boot_sleep_latched = true;
                 poweroff_requested = true;
+                requestRender(RENDER_EDITOR);
             }
         } else {
             boot_pressed_since = 0;
@@ -2211,8 +1826,7 @@ void loop() {
         updateBattery();
         if (battery_pct != prev_battery_pct) {
             AppMode cur = app_mode;
-            if (cur == MODE_TERMINAL) term_render_requested = true;
-            else render_requested = true;
+            requestRender(RENDER_STATUS);
         }
     }
 
@@ -2235,18 +1849,19 @@ void loop() {
             cmdPickerStop();
             app_mode = MODE_COMMAND;
             xSemaphoreGive(state_mutex);
-            render_requested = true;
+            requestRender(RENDER_EDITOR);
         }
     }
 
-    // --- Touch scroll polling ---
-    if (touch_available && (millis() - last_touch_poll >= TOUCH_POLL_INTERVAL_MS)) {
-        unsigned long now = millis();
-        last_touch_poll = now;
-        int16_t cur_x = 0;
-        int16_t cur_y = 0;
-        int touch_result = cst226ReadTouch(&cur_x, &cur_y);
-        bool is_touched = (touch_result == 1);
+    // --- Touch gestures (samples from touchTask) ---
+    TouchSample samples[TOUCH_FIFO_LEN];
+    int sample_count = touch_available ? touchTakeSamples(samples) : 0;
+    for (int si = 0; si < sample_count; si++) {
+        const TouchSample& sample = samples[si];
+        unsigned long now = sample.ms;
+        int16_t cur_x = sample.x;
+        int16_t cur_y = sample.y;
+        bool is_touched = (sample.result == 1);
 
         if (is_touched) {
             if (touch_state == TOUCH_IDLE) {
@@ -2261,15 +1876,9 @@ void loop() {
             } else {
                 AppMode mode = app_mode;
                 if (mode == MODE_BT) {
-                    int16_t raw_dx = cur_x - touch_last_x;
-                    int16_t raw_dy = cur_y - touch_last_y;
-                    btTrackpadSendMove(raw_dx, raw_dy);
+                    // Pointer motion is reported by touchTask.
                     touch_last_x = cur_x;
                     touch_last_y = cur_y;
-                    if (raw_dx > BT_TOUCH_TAP_MOVE_MAX || raw_dx < -BT_TOUCH_TAP_MOVE_MAX ||
-                        raw_dy > BT_TOUCH_TAP_MOVE_MAX || raw_dy < -BT_TOUCH_TAP_MOVE_MAX) {
-                        touch_did_scroll = true;
-                    }
                 } else {
                     touch_last_x = cur_x;
                     touch_last_y = cur_y;
@@ -2281,13 +1890,13 @@ void loop() {
                             if (xSemaphoreTake(state_mutex, pdMS_TO_TICKS(10)) == pdTRUE) {
                                 if (mode == MODE_NOTEPAD) {
                                     // Natural scroll: finger down = see earlier content (scroll_line decreases)
-                                    LayoutInfo li = computeLayoutFrom(text_buf, text_len, cursor_pos);
-                                    int max_scroll = li.total_lines > ROWS_PER_SCREEN
-                                        ? li.total_lines - ROWS_PER_SCREEN : 0;
+                                    int total_lines = textTotalLines();
+                                    int max_scroll = total_lines > ROWS_PER_SCREEN
+                                        ? total_lines - ROWS_PER_SCREEN : 0;
                                     scroll_line -= lines_delta;
                                     if (scroll_line < 0) scroll_line = 0;
                                     if (scroll_line > max_scroll) scroll_line = max_scroll;
-                                    render_requested = true;
+                                    requestRender(RENDER_SCROLL);
                                 } else if (mode == MODE_TERMINAL) {
                                     if (terminalMouseTrackingEnabled()) {
                                         int steps = lines_delta;
@@ -2307,12 +1916,10 @@ void loop() {
                                             }
                                         }
                                     } else {
-                                        int max_scroll = term_line_count > ROWS_PER_SCREEN
-                                            ? term_line_count - ROWS_PER_SCREEN : 0;
-                                        term_scroll -= lines_delta;
-                                        if (term_scroll < 0) term_scroll = 0;
-                                        if (term_scroll > max_scroll) term_scroll = max_scroll;
-                                        term_render_requested = true;
+                                        termLock();
+                                        termViewScroll(lines_delta);
+                                        termUnlock();
+                                        requestRender(RENDER_TERMINAL | RENDER_SCROLL);
                                     }
                                 }
                                 xSemaphoreGive(state_mutex);
@@ -2359,36 +1966,9 @@ void loop() {
         }
     }
 
-    while (keypad.available() > 0) {
-        int ev = keypad.getEvent();
-        if (!(ev & 0x80)) continue;  // skip release events
+    keyQueueDispatch();
+    termSessionPollSwitch();
 
-        if (xSemaphoreTake(state_mutex, pdMS_TO_TICKS(25)) != pdTRUE) {
-            continue;
-        }
-        bool needs_render = false;
-        AppMode mode = app_mode;
-        if (mode == MODE_NOTEPAD) {
-            needs_render = handleNotepadKeyPress(ev);
-        } else if (mode == MODE_TERMINAL) {
-            needs_render = handleTerminalKeyPress(ev);
-        } else if (mode == MODE_BT) {
-            needs_render = handleBluetoothKeyPress(ev);
-        } else if (mode == MODE_COMMAND) {
-            needs_render = handleCommandKeyPress(ev);
-        }
-        xSemaphoreGive(state_mutex);
-
-        if (needs_render) {
-            // After command execution, mode may have changed
-            AppMode cur = app_mode;
-            if (cur == MODE_NOTEPAD) {
-                render_requested = true;
-            } else if (cur == MODE_TERMINAL) {
-                term_render_requested = true;
-            } else if (cur == MODE_COMMAND || cur == MODE_BT) {
-                render_requested = true;
-            }
-        }
-    }
+    // Idle until the next key (or the next poll slot) instead of spinning.
+    keyQueueWait(LOOP_IDLE_WAIT_MS);
 }
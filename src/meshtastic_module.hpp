@@ -215,8 +215,7 @@ static constexpr float MSH_REGION_SPACING_MHZ = 0.0f;
 static constexpr float MSH_DEFAULT_BW_KHZ = 250.0f;
 
 static void mshMarkRenderDirty() {
-    render_requested = true;
-    term_render_requested = true;
+    requestRender(RENDER_EDITOR | RENDER_TERMINAL);
 }
 
 static uint32_t mshReadLe32(const uint8_t* p) {
@@ -59,8 +59,7 @@ static bool modem_power_event_pending = false;
 static bool modem_power_event_ok = false;
 
 static void modemMarkRenderDirty() {
-    render_requested = true;
-    term_render_requested = true;
+    requestRender(RENDER_EDITOR | RENDER_TERMINAL);
 }
 
 static bool modemResponseHasOk(const String& response) {
@@ -127,12 +127,174 @@ static void sshIOUnlock() {
     if (ssh_io_mutex) xSemaphoreGive(ssh_io_mutex);
 }
 
-void sshDisconnect() {
-    if (ssh_recv_task_handle) {
-        vTaskDelete(ssh_recv_task_handle);
-        ssh_recv_task_handle = NULL;
+// --- SSH Receive Wakeups ---
+//
+// sshReceiveTask drains whatever libssh has buffered, then sleeps in
+// select() on the session socket plus ssh_wake_fd, an eventfd. Writers kick
+// the eventfd after each channel write, because libssh may read incoming
+// packets into its own buffers during a write, leaving nothing on the
+// socket to wake the select. The task is stopped cooperatively (sshStopReceiveTask):
+// every long sleep is that select, which the stop request kicks, and the
+// task gives ssh_recv_done on its way out. It is never deleted from outside,
+// so it can't die inside select() or while holding ssh_io_mutex.
+//
+// ssh_rx_wakes and ssh_rx_busy_us (STATE) count the task's passes and the
+// time it spends awake, for comparing its idle cost across builds.
+
+static constexpr uint32_t SSH_RX_IDLE_WAIT_MS = 1000;  // safety-net wake while idle
+static constexpr uint32_t SSH_RX_NO_SESSION_MS = 100;  // wait while no channel is open
+static constexpr uint32_t SSH_RX_STOP_POLL_MS = 50;    // select slice without the eventfd
+static constexpr uint32_t SSH_RX_STOP_WAIT_MS = 1000;  // per stop attempt
+static constexpr int SSH_RX_STOP_TRIES = 3;
+
+static int ssh_wake_fd = -1;
+static volatile bool ssh_recv_stop = false;
+static SemaphoreHandle_t ssh_recv_done = NULL;  // given when the task exits
+static volatile uint32_t ssh_rx_wakes = 0;
+static volatile uint32_t ssh_rx_busy_us = 0;
+static volatile uint32_t ssh_rx_stop_fails = 0;
+
+void sshWakeInit() {
+    ssh_recv_done = xSemaphoreCreateBinary();
+    esp_vfs_eventfd_config_t cfg = ESP_VFS_EVENTD_CONFIG_DEFAULT();
+    if (esp_vfs_eventfd_register(&cfg) != ESP_OK) {
+        SERIAL_LOGLN("SSH: eventfd register failed");
+        return;
+    }
+    ssh_wake_fd = eventfd(0, 0);
+    if (ssh_wake_fd < 0) SERIAL_LOGLN("SSH: eventfd create failed");
+}
+
+static void sshWakeReceiver() {
+    if (ssh_wake_fd < 0) return;
+    uint64_t one = 1;
+    write(ssh_wake_fd, &one, sizeof(one));
+}
+
+static ssh_session sshSessionHandle(int session);
+static ssh_channel sshSessionChannel(int session);
+static int sshMuxSockets(fd_set* rfds, int max_fd);
+
+// Receive task: sleep until a session socket is readable, a writer kicks
+// ssh_wake_fd, or timeout_ms passes.
+static void sshWaitReadable(uint32_t timeout_ms) {
+    fd_set rfds;
+    FD_ZERO(&rfds);
+    int max_fd = -1;
+    for (int i = 0; i < TERM_SESSIONS; i++) {
+        ssh_session sess = sshSessionChannel(i) ? sshSessionHandle(i) : NULL;
+        socket_t sock = sess ? ssh_get_fd(sess) : SSH_INVALID_SOCKET;
+        if (sock == SSH_INVALID_SOCKET) continue;
+        FD_SET(sock, &rfds);
+        if (sock > max_fd) max_fd = sock;
+    }
+    max_fd = sshMuxSockets(&rfds, max_fd);
+    if (ssh_wake_fd >= 0) {
+        FD_SET(ssh_wake_fd, &rfds);
+        if (ssh_wake_fd > max_fd) max_fd = ssh_wake_fd;
+    } else if (timeout_ms > SSH_RX_STOP_POLL_MS) {
+        timeout_ms = SSH_RX_STOP_POLL_MS;  // nothing can kick us: look at ssh_recv_stop often
+    }
+    if (max_fd < 0) {
+        vTaskDelay(pdMS_TO_TICKS(timeout_ms));
+        return;
+    }
+
+    struct timeval tv;
+    tv.tv_sec = timeout_ms / 1000;
+    tv.tv_usec = (timeout_ms % 1000) * 1000;
+    uint32_t start_us = micros();
+    int ready = select(max_fd + 1, &rfds, NULL, NULL, &tv);
+    latRecord(lat_ssh_rx_wait, micros() - start_us);
+    if (ready > 0 && ssh_wake_fd >= 0 && FD_ISSET(ssh_wake_fd, &rfds)) {
+        uint64_t count;
+        read(ssh_wake_fd, &count, sizeof(count));
+    }
+    if (ready < 0) vTaskDelay(pdMS_TO_TICKS(10));  // don't spin on a dead socket
+}
+
+void sshReceiveTask(void* param);
+
+void sshStartReceiveTask() {
+    if (ssh_recv_task_handle) return;
+    ssh_recv_stop = false;
+    if (ssh_recv_done) xSemaphoreTake(ssh_recv_done, 0);
+    // Receive task on core 0
+    xTaskCreatePinnedToCore(
+        sshReceiveTask,
+        "ssh_recv",
+        16384,
+        NULL,
+        1,
+        &ssh_recv_task_handle,
+        0
+    );
+}
+
+// Ask the receive task to exit and wait for it, kicking it again on each
+// try. Returns false if it is still running; the request is then withdrawn
+// and the task carries on, since killing it could leave ssh_io_mutex held.
+bool sshStopReceiveTask() {
+    if (!ssh_recv_task_handle) return true;
+    ssh_recv_stop = true;
+    for (int i = 0; i < SSH_RX_STOP_TRIES && ssh_recv_task_handle; i++) {
+        sshWakeReceiver();
+        if (ssh_recv_done) {
+            xSemaphoreTake(ssh_recv_done, pdMS_TO_TICKS(SSH_RX_STOP_WAIT_MS));
+        } else {
+            vTaskDelay(pdMS_TO_TICKS(SSH_RX_STOP_WAIT_MS));
+        }
+    }
+    bool stopped = !ssh_recv_task_handle;
+    if (!stopped) {
+        ssh_rx_stop_fails++;
+        SERIAL_LOGF("SSH: receive task did not stop in %lu ms\n",
+                    (unsigned long)(SSH_RX_STOP_TRIES * SSH_RX_STOP_WAIT_MS));
+    }
+    ssh_recv_stop = false;
+    return stopped;
+}
+
+static void sshTxDiscard();
+static bool sshMuxActive();
+static bool sshMuxService();
+static void sshMuxAbortSession(ssh_session sess);
+
+// A session's connection: the globals for the one on screen, its parked
+// handles otherwise. Consistent under ssh_io_mutex (switches hold it).
+static ssh_session sshSessionHandle(int session) {
+    return session == term_session_active ? ssh_sess : term_sessions[session].sess;
+}
+
+// The session's shell channel while it is connected, else NULL.
+static ssh_channel sshSessionChannel(int session) {
+    if (session == term_session_active) return ssh_connected ? ssh_chan : NULL;
+    const TermSession& s = term_sessions[session];
+    return s.connected ? s.chan : NULL;
+}
+
+static bool sshAnySessionLive() {
+    for (int i = 0; i < TERM_SESSIONS; i++) {
+        if (sshSessionChannel(i)) return true;
     }
+    return false;
+}
+
+// Disconnect the session on screen. Background sessions keep running: the
+// receive task is stopped only while this session's handles are freed.
+void sshDisconnect() {
+    bool stopped = sshStopReceiveTask();
+    termFloodReset();
     ssh_connected = false;
+    sshTxDiscard();
+    bool locked = sshIOLock(pdMS_TO_TICKS(1000));  // let an in-flight key write finish
+    if (!stopped && !locked) {
+        // The receive task may be inside libssh on these handles: leak them.
+        SERIAL_LOGLN("SSH: receive task busy, session left open");
+        ssh_chan = NULL;
+        ssh_sess = NULL;
+    }
+    if (ssh_sess) sshMuxAbortSession(ssh_sess);
     if (ssh_chan) {
         ssh_channel_close(ssh_chan);
         ssh_channel_free(ssh_chan);
@@ -143,11 +305,12 @@ void sshDisconnect() {
         ssh_free(ssh_sess);
         ssh_sess = NULL;
     }
+    if (locked) sshIOUnlock();
     ssh_last_host[0] = '\0';
     SERIAL_LOGLN("SSH: disconnected");
+    if (sshAnySessionLive() || sshMuxActive()) sshStartReceiveTask();
 }
 
-void sshReceiveTask(void* param);
 void renderCommandPrompt();
 
 bool hasNetwork() {
@@ -262,8 +425,10 @@ bool sshConnect() {
     // Clean up any previous session
     sshDisconnect();
 
-    const char* direct_host = config_ssh_host;
-    const char* vpn_host = config_ssh_vpn_host[0] ? config_ssh_vpn_host : config_ssh_host;
+    // `ssh <host>` picks this session's host for both routes.
+    const char* direct_host = ssh_target_host[0] ? ssh_target_host : config_ssh_host;
+    const char* vpn_host = ssh_target_host[0] ? ssh_target_host :
+                           config_ssh_vpn_host[0] ? config_ssh_vpn_host : config_ssh_host;
     const bool vpn_only = vpnActive();
 
     if (vpn_only) {
@@ -370,25 +535,20 @@ bool sshConnect() {
         return false;
     }
 
-    ssh_connected = true;
-    SERIAL_LOGLN("SSH: connected!");
-
-    // Clear terminal buffer for fresh session
-    xSemaphoreTake(state_mutex, portMAX_DELAY);
+    // Clear terminal buffer for fresh session. The receive task may already
+    // be running for other sessions; it only reads this channel once
+    // ssh_connected is set, so the banner lands after the clear.
+    sshTxDiscard();
+    termRxDiscard(term_session_active);
+    termLock();
     terminalClear();
-    xSemaphoreGive(state_mutex);
+    termUnlock();
 
-    // Launch receive task on core 0
-    xTaskCreatePinnedToCore(
-        sshReceiveTask,
-        "ssh_recv",
-        16384,
-        NULL,
-        1,
-        &ssh_recv_task_handle,
-        0
-    );
+    ssh_connected = true;
+    SERIAL_LOGLN("SSH: connected!");
 
+    sshStartReceiveTask();
+    sshWakeReceiver();  // add the new socket to a select already in progress
     return true;
 }
 
@@ -404,7 +564,7 @@ void connectMsg(const char* fmt, ...) {
     vsnprintf(connect_status[connect_status_count], COLS_PER_LINE + 1, fmt, args);
     va_end(args);
     connect_status_count++;
-    term_render_requested = true;
+    requestRender(RENDER_TERMINAL);
 }
 
 void sshConnectTask(void* param) {
@@ -463,7 +623,7 @@ void sshConnectTask(void* param) {
         connect_status_count = 0;
         partial_count = 100;  // force full clean redraw
     }
-    term_render_requested = true;
+    requestRender(RENDER_TERMINAL);
     vTaskDelete(NULL);
 }
 
@@ -481,84 +641,127 @@ void sshConnectAsync() {
     );
 }
 
-void sshSendKey(char c) {
-    if (!ssh_connected || !ssh_chan) return;
-    if (!sshIOLock()) return;
-    int wrote = ssh_channel_write(ssh_chan, &c, 1);
+// A session's shell channel, one receive pass.
+enum SshPtyPass {
+    SSH_PTY_IDLE,      // nothing buffered in libssh
+    SSH_PTY_BUSY,      // moved data or handled a close
+    SSH_PTY_BLOCKED,   // parser behind or I/O lock busy: retry shortly
+};
+
+// Read into recv_buf under the I/O lock, resolving the session's channel
+// there: a switch may have moved it between the globals and its slot.
+static int sshSessionRead(int session, char* recv_buf, size_t recv_len) {
+    if (!sshIOLock()) return 0;
+    ssh_channel chan = sshSessionChannel(session);
+    int nbytes = chan ? ssh_channel_read_nonblocking(chan, recv_buf, recv_len, 0) : 0;
+    sshIOUnlock();
+    return nbytes;
+}
+
+// The remote closed a session's shell. On screen the terminal is reset at
+// once so stale TUI content does not linger; a background session keeps its
+// last screen until it is switched to and reconnected.
+static void sshSessionClosed(int session) {
+    if (!sshIOLock(pdMS_TO_TICKS(1000))) return;
+    bool on_screen = session == term_session_active;
+    if (on_screen) {
+        ssh_connected = false;
+    } else {
+        term_sessions[session].connected = false;
+        term_sessions[session].unseen = true;
+    }
     sshIOUnlock();
-    if (wrote != 1) {
-        SERIAL_LOGF("SSH: key write failed (%d)\n", wrote);
+    SERIAL_LOGF("SSH: session %d closed by remote\n", session + 1);
+    if (!on_screen) {
+        requestRender(RENDER_STATUS);
+        return;
     }
+
+    termRxDiscard(session);
+    termLock();
+    if (session == term_session_active) terminalClear();
+    termUnlock();
+
+    connect_status_count = 0;
+    partial_count = 100;  // force a full clean redraw on next terminal render
+    requestRender(RENDER_TERMINAL);
 }
 
-void sshSendString(const char* s, int len) {
-    if (!ssh_connected || !ssh_chan || !s || len <= 0) return;
-    if (!sshIOLock()) return;
-    int sent = 0;
-    while (sent < len) {
-        int wrote = ssh_channel_write(ssh_chan, s + sent, len - sent);
-        if (wrote <= 0) {
-            SERIAL_LOGF("SSH: string write failed (%d)\n", wrote);
-            break;
+static SshPtyPass sshServicePty(int session, char* recv_buf, size_t recv_len) {
+    // Parser behind: leave the data in the channel until the ring drains.
+    if (termRxFree(session) < recv_len) return SSH_PTY_BLOCKED;
+
+    if (!sshIOLock()) return SSH_PTY_BLOCKED;
+    ssh_channel chan = sshSessionChannel(session);
+    bool on_screen = session == term_session_active;
+    int nbytes = chan ? ssh_channel_read_nonblocking(chan, recv_buf, recv_len, 0) : 0;
+    bool eof = chan && nbytes == 0 && ssh_channel_is_eof(chan);
+    sshIOUnlock();
+    if (!chan) return SSH_PTY_IDLE;
+
+    if (nbytes > 0) {
+        if (on_screen) {
+            uint32_t now_us = latNowUs();
+            latOutputArrived(now_us);
+            latEchoArrived(now_us);
+        }
+        termRxPush(session, recv_buf, nbytes);
+        // Drain loop: hand the parser a whole burst at once
+        int total = nbytes;
+        for (int drain = 0; drain < 10 && total < 2048; drain++) {
+            if (termRxFree(session) < recv_len) break;
+            nbytes = sshSessionRead(session, recv_buf, recv_len);
+            if (nbytes <= 0) break;
+            termRxPush(session, recv_buf, nbytes);
+            total += nbytes;
         }
-        sent += wrote;
+        if (on_screen) termFloodNote(total);
+        return SSH_PTY_BUSY;
     }
-    sshIOUnlock();
+
+    if (on_screen) termFloodNote(0);
+    if (nbytes != SSH_ERROR && !eof) return SSH_PTY_IDLE;
+    sshSessionClosed(session);
+    return SSH_PTY_BUSY;
 }
 
+// Session owner: services every session's shell channel and the exec
+// channels (ssh_mux_module). Exec channels keep running after the shell
+// itself exits, until they close or the session is torn down.
 void sshReceiveTask(void* param) {
     char recv_buf[512];
-    for (;;) {
-        if (!ssh_connected || !ssh_chan) {
-            vTaskDelay(pdMS_TO_TICKS(100));
-            continue;
+    while (!ssh_recv_stop) {
+        uint32_t awake_us = micros();
+        ssh_rx_wakes++;
+        bool any = false;
+        bool busy = false;
+        bool blocked = false;
+        for (int i = 0; i < TERM_SESSIONS; i++) {
+            if (!sshSessionChannel(i)) continue;
+            any = true;
+            SshPtyPass pass = sshServicePty(i, recv_buf, sizeof(recv_buf));
+            if (pass == SSH_PTY_BUSY) busy = true;
+            else if (pass == SSH_PTY_BLOCKED) blocked = true;
         }
-
-        if (!sshIOLock()) {
+        if (sshMuxActive()) {
+            any = true;
+            if (sshMuxService()) busy = true;
+        }
+        ssh_rx_busy_us += micros() - awake_us;
+        if (busy) continue;
+        if (blocked) {
             vTaskDelay(pdMS_TO_TICKS(2));
             continue;
         }
-        int nbytes = ssh_channel_read_nonblocking(ssh_chan, recv_buf, sizeof(recv_buf), 0);
-        sshIOUnlock();
-        if (nbytes > 0) {
-            xSemaphoreTake(state_mutex, portMAX_DELAY);
-            terminalAppendOutput(recv_buf, nbytes);
-            // Drain loop: keep reading to accumulate data before rendering
-            int total = nbytes;
-            for (int drain = 0; drain < 10 && total < 2048; drain++) {
-                if (!sshIOLock()) break;
-                nbytes = ssh_channel_read_nonblocking(ssh_chan, recv_buf, sizeof(recv_buf), 0);
-                sshIOUnlock();
-                if (nbytes <= 0) break;
-                terminalAppendOutput(recv_buf, nbytes);
-                total += nbytes;
-            }
-            xSemaphoreGive(state_mutex);
-            term_render_requested = true;
-        } else {
-            bool eof = false;
-            if (nbytes != SSH_ERROR) {
-                if (sshIOLock()) {
-                    eof = ssh_channel_is_eof(ssh_chan);
-                    sshIOUnlock();
-                }
-            }
-            if (nbytes == SSH_ERROR || eof) {
-            SERIAL_LOGLN("SSH: channel closed by remote");
-            ssh_connected = false;
-
-            // Reset parser/buffer immediately so stale TUI content does not linger.
-            xSemaphoreTake(state_mutex, portMAX_DELAY);
-            terminalClear();
-            xSemaphoreGive(state_mutex);
-
-            connect_status_count = 0;
-            partial_count = 100;  // force a full clean redraw on next terminal render
-            term_render_requested = true;
-            vTaskDelay(pdMS_TO_TICKS(1000));
-            } else {
-                vTaskDelay(pdMS_TO_TICKS(5));
-            }
-        }
+
+        // libssh has nothing buffered: sleep until a socket has data (or,
+        // with no channel open, until one opens or a stop kicks the
+        // eventfd). A flood wakes once per window so its end is still
+        // detected.
+        if (!any) sshWaitReadable(SSH_RX_NO_SESSION_MS);
+        else sshWaitReadable(term_flood_active ? TERM_FLOOD_WINDOW_MS : SSH_RX_IDLE_WAIT_MS);
     }
+    ssh_recv_task_handle = NULL;
+    if (ssh_recv_done) xSemaphoreGive(ssh_recv_done);
+    vTaskDelete(NULL);
 }
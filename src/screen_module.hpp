@@ -1,38 +1,25 @@
 // --- Display Rendering (runs on core 0 only, uses snap_ vars) ---
 
 void drawLinesRange(int first_line, int last_line) {
-    int text_line = 0, col = 0;
-    int start_i = 0;
-    bool found_start = false;
-
-    // Fast-forward to snap_scroll line to avoid scanning entire buffer
-    int target_line = snap_scroll + first_line;
-    if (target_line > 0) {
-        for (int i = 0; i < snap_len; i++) {
-            if (text_line >= target_line) { start_i = i; found_start = true; break; }
-            if (snap_buf[i] == '\n') { text_line++; col = 0; }
-            else { col++; if (col >= COLS_PER_LINE) { text_line++; col = 0; } }
-        }
-        // Handle trailing empty line (cursor after a newline): we may only
-        // reach target_line exactly after consuming the final character.
-        if (!found_start) {
-            if (text_line < target_line) return; // not enough lines
-            start_i = snap_len;
-        }
-    }
+    if (first_line < 0) first_line = 0;
+    if (first_line >= ROWS_PER_SCREEN) return;
+    if (snap_scroll + first_line >= snap_total_lines) return; // not enough lines
+
+    // Row offsets come from the line index; no scan from the window start.
+    int text_line = snap_scroll + first_line;
+    int col = 0;
+    int start_i = snap_line_off[first_line];
 
     // Batch buffer for accumulating runs of chars on the same line
-    char run_buf[COLS_PER_LINE + 1];
+    char run_buf[COLS_PER_LINE];
     int run_start_col = -1;
     int run_len = 0;
     int run_sl = -1;
 
-    // Flush accumulated run to display
+    // Flush accumulated run to the canvas
     auto flushRun = [&]() {
         if (run_len > 0) {
-            run_buf[run_len] = '\0';
-            display.setCursor(MARGIN_X + run_start_col * CHAR_W, MARGIN_Y + run_sl * CHAR_H + 1);
-            display.print(run_buf);
+            fbDrawText(MARGIN_X + run_start_col * CHAR_W, MARGIN_Y + run_sl * CHAR_H + 1, run_buf, run_len);
             run_len = 0;
             run_start_col = -1;
         }
@@ -45,13 +32,7 @@ void drawLinesRange(int first_line, int last_line) {
             flushRun();
             int x = MARGIN_X + col * CHAR_W;
             int y = MARGIN_Y + sl * CHAR_H;
-            display.fillRect(x, y, CHAR_W, CHAR_H, GxEPD_BLACK);
-            if (i < snap_len && snap_buf[i] != '\n') {
-                display.setTextColor(GxEPD_WHITE);
-                display.setCursor(x, y + 1);
-                display.print(snap_buf[i]);
-                display.setTextColor(GxEPD_BLACK);
-            }
+            fbDrawCursorCell(x, y, (i < snap_len && snap_buf[i] != '\n') ? snap_buf[i] : ' ');
         }
 
         if (i >= snap_len) break;
@@ -153,9 +134,9 @@ static void drawStatusBarLine(const char* left, const char* right, int bar_y) {
         }
     }
 
-    display.setCursor(2, bar_y + 1);
+    frame_canvas.setCursor(2, bar_y + 1);
     if (left_buf[0] != '\0') {
-        display.print(left_buf);
+        frame_canvas.print(left_buf);
     }
 
     if (right_cols > 0 && right) {
@@ -166,16 +147,16 @@ static void drawStatusBarLine(const char* left, const char* right, int bar_y) {
         right_buf[copy_len] = '\0';
         int rx = SCREEN_W - copy_len * CHAR_W - 2;
         if (rx < 2) rx = 2;
-        display.setCursor(rx, bar_y + 1);
-        display.print(right_buf);
+        frame_canvas.setCursor(rx, bar_y + 1);
+        frame_canvas.print(right_buf);
     }
 }
 
 void drawStatusBar(const LayoutInfo& info) {
     int bar_y = SCREEN_H - STATUS_H;
-    display.fillRect(0, bar_y, SCREEN_W, STATUS_H, GxEPD_BLACK);
-    display.setTextColor(GxEPD_WHITE);
-    display.setFont(NULL);
+    frame_canvas.fillRect(0, bar_y, SCREEN_W, STATUS_H, GxEPD_BLACK);
+    frame_canvas.setTextColor(GxEPD_WHITE);
+    frame_canvas.setFont(NULL);
     char status[72];
     char mods[16] = "";
     if (snap_shift) strcat(mods, "SH ");
@@ -208,75 +189,153 @@ void drawStatusBar(const LayoutInfo& info) {
 
 // --- Terminal Rendering ---
 
+// Screen rows the next terminal frame has to redraw (core 0 only).
+// term_snap_full forces every visible row, e.g. after another screen
+// covered the canvas.
+static bool term_snap_row_dirty[ROWS_PER_SCREEN];
+static bool term_snap_full = true;
+static bool term_snap_band = false;   // bottom row shows the line-edit band
+// Cells showing a local-echo prediction rather than server output.
+static bool term_snap_tentative[ROWS_PER_SCREEN][TERM_COLS];
+
+static void termSnapMarkCursor() {
+    int sl = term_snap_crow;
+    if (term_snap_cursor_visible && sl >= 0 && sl < ROWS_PER_SCREEN) term_snap_row_dirty[sl] = true;
+}
+
+// Copy the visible rows written since the last snapshot (caller must hold
+// term_mutex). While the view is scrolled back, the top term_view_hist
+// screen rows come from the scrollback and the grid is shifted down below
+// them. With local line edit active the bottom row is the edit band, and the
+// grid moves up a row if the remote cursor would be under it. A scroll or
+// whole-buffer change copies every visible row; a cursor move marks its old
+// and new rows.
 void snapshotTerminalState() {
-    term_snap_scroll = term_scroll;
-    term_snap_crow   = term_cursor_row;
-    term_snap_ccol   = term_cursor_col;
+    int hist = termHistoryCount();
+    bool band = termLineActive() && term_view_hist == 0;
+    int band_sl = ROWS_PER_SCREEN - 1;
+    int scroll = term_scroll;
+    int cursor_row = term_cursor_row;
+    int cursor_col = term_cursor_col;
+    termPredCursor(&cursor_row, &cursor_col);
+    int crow = cursor_row - scroll + term_view_hist;
+    bool show_cursor = cursor_visible;
+    if (band) {
+        if (crow >= band_sl) scroll += crow - band_sl + 1;
+        crow = band_sl;
+        show_cursor = true;
+    }
+    bool full = term_snap_full || term_all_dirty || scroll != term_snap_scroll ||
+                term_view_hist != term_snap_view || band != term_snap_band;
+    bool band_dirty = band && (full || term_line_dirty);
+    char band_row[TERM_COLS + 1];
+    if (band_dirty) cursor_col = termLineRenderBand(band_row);
+    else if (band) cursor_col = term_snap_ccol;
+    bool cursor_moved = term_snap_crow != crow || term_snap_ccol != cursor_col ||
+                        term_snap_cursor_visible != show_cursor;
+    if (cursor_moved && !full) termSnapMarkCursor();
+
+    term_snap_scroll = scroll;
+    term_snap_view   = term_view_hist;
+    term_snap_band   = band;
+    term_snap_crow   = crow;
+    term_snap_ccol   = cursor_col;
     term_snap_lines  = term_line_count;
-    term_snap_cursor_visible = cursor_visible;
-    // Only copy visible rows + 1 for safety
-    int first = term_snap_scroll;
-    int last = first + ROWS_PER_SCREEN;
-    if (first < 0) first = 0;
-    if (last > TERM_ROWS) last = TERM_ROWS;
-    for (int i = first; i < last; i++) {
-        memcpy(term_snap_buf[i], term_buf[i], TERM_COLS + 1);
+    term_snap_cursor_visible = show_cursor;
+    if (cursor_moved && !full) termSnapMarkCursor();
+
+    int grid_rows = band ? band_sl : ROWS_PER_SCREEN;
+    for (int sl = 0; sl < grid_rows; sl++) {
+        if (sl < term_snap_view) {
+            if (!full) continue;
+            memcpy(term_snap_buf[sl], termHistoryLine(hist - term_snap_view + sl), TERM_COLS + 1);
+            term_snap_row_dirty[sl] = true;
+            continue;
+        }
+        int row = term_snap_scroll + sl - term_snap_view;
+        if (row < 0 || row >= TERM_ROWS) continue;
+        if (full || termRowDirty(row)) {
+            memcpy(term_snap_buf[sl], termRow(row), TERM_COLS + 1);
+            memset(term_snap_tentative[sl], 0, TERM_COLS);
+            term_snap_row_dirty[sl] = true;
+        }
+    }
+    if (band_dirty) {
+        memcpy(term_snap_buf[band_sl], band_row, TERM_COLS + 1);
+        memset(term_snap_tentative[band_sl], 0, TERM_COLS);
+        term_snap_row_dirty[band_sl] = true;
+    }
+    // Visible local-echo predictions are drawn over their rows (a change in
+    // the predictions marks the row dirty, so it was just recopied).
+    for (int i = 0; i < term_pred_count; i++) {
+        const TermPrediction& p = term_pred[i];
+        if (!termPredVisible(p)) continue;
+        int sl = p.row - term_snap_scroll + term_snap_view;
+        if (sl < term_snap_view || sl >= grid_rows) continue;
+        term_snap_buf[sl][p.col] = p.ch;
+        term_snap_tentative[sl][p.col] = true;
     }
+    // Rows off screen are recopied in full once a scroll brings them back.
+    term_row_dirty = 0;
+    term_all_dirty = false;
+    term_snap_full = false;
 }
 
 void drawTerminalLines(int first_line, int last_line) {
-    char run_buf[TERM_COLS + 1];
     for (int sl = first_line; sl <= last_line && sl < ROWS_PER_SCREEN; sl++) {
-        int buf_row = term_snap_scroll + sl;
-        if (buf_row < 0 || buf_row >= TERM_ROWS) continue;
-        bool is_cursor_row = term_snap_cursor_visible && (buf_row == term_snap_crow);
+        const char* line = term_snap_buf[sl];
+        bool is_cursor_row = term_snap_cursor_visible && (sl == term_snap_crow);
         int y = MARGIN_Y + sl * CHAR_H;
 
-        // Find runs of non-space characters and print them in batches
+        // Find runs of non-space characters and blit them in runs
         int c = 0;
         while (c < TERM_COLS) {
             // Skip spaces (unless cursor is here)
-            if (term_snap_buf[buf_row][c] == ' ' && !(is_cursor_row && c == term_snap_ccol)) {
+            if (line[c] == ' ' && !(is_cursor_row && c == term_snap_ccol)) {
                 c++;
                 continue;
             }
 
             // Draw cursor cell specially
             if (is_cursor_row && c == term_snap_ccol) {
-                int x = MARGIN_X + c * CHAR_W;
-                display.fillRect(x, y, CHAR_W, CHAR_H, GxEPD_BLACK);
-                if (term_snap_buf[buf_row][c] != ' ') {
-                    display.setTextColor(GxEPD_WHITE);
-                    display.setCursor(x, y + 1);
-                    display.print(term_snap_buf[buf_row][c]);
-                    display.setTextColor(GxEPD_BLACK);
-                }
+                fbDrawCursorCell(MARGIN_X + c * CHAR_W, y, line[c]);
                 c++;
                 continue;
             }
 
-            // Collect run of non-space chars (stop before cursor)
+            // Blit the run of non-space chars straight from the row (stop before cursor)
             int run_start = c;
-            int run_len = 0;
-            while (c < TERM_COLS && term_snap_buf[buf_row][c] != ' ' &&
-                   !(is_cursor_row && c == term_snap_ccol)) {
-                run_buf[run_len++] = term_snap_buf[buf_row][c];
+            while (c < TERM_COLS && line[c] != ' ' && !(is_cursor_row && c == term_snap_ccol)) {
                 c++;
             }
-            run_buf[run_len] = '\0';
-            display.setCursor(MARGIN_X + run_start * CHAR_W, y + 1);
-            display.print(run_buf);
+            fbDrawText(MARGIN_X + run_start * CHAR_W, y + 1, &line[run_start], c - run_start);
+        }
+        for (c = 0; c < TERM_COLS; c++) {
+            if (term_snap_tentative[sl][c]) fbDrawTentativeMark(MARGIN_X + c * CHAR_W, y);
         }
     }
 }
 
 void drawTerminalStatusBar() {
     int bar_y = SCREEN_H - STATUS_H;
-    display.fillRect(0, bar_y, SCREEN_W, STATUS_H, GxEPD_BLACK);
-    display.setTextColor(GxEPD_WHITE);
-    display.setFont(NULL);
+    frame_canvas.fillRect(0, bar_y, SCREEN_W, STATUS_H, GxEPD_BLACK);
+    frame_canvas.setTextColor(GxEPD_WHITE);
+    frame_canvas.setFont(NULL);
 
     char status[72];
+    char view[32] = "";
+    int view_len = 0;
+    if (termSessionsInUse()) {
+        // Session on screen; * = output waiting in another one.
+        view_len = snprintf(view, sizeof(view), "S%d%s ", term_session_active + 1,
+                            termSessionUnseen() ? "*" : "");
+    }
+    if (term_flood_active) {
+        view_len += snprintf(view + view_len, sizeof(view) - view_len, "%luK/s ",
+                             (unsigned long)(term_flood_bps / 1024));
+    }
+    if (term_snap_band) view_len += snprintf(view + view_len, sizeof(view) - view_len, "LE ");
+    if (term_snap_view > 0) snprintf(view + view_len, sizeof(view) - view_len, "[-%d] ", term_snap_view);
     const char* bt_suffix = "";
     if (btIsConnected()) bt_suffix = " +BT";
     else if (btIsEnabled()) bt_suffix = " bt";
@@ -305,63 +364,81 @@ void drawTerminalStatusBar() {
         snprintf(status, sizeof(status), btIsConnected() ? "BT %s" : "No net%s",
                  btIsConnected() ? btPeerAddress() : bt_suffix);
     }
+    char left[88];
+    snprintf(left, sizeof(left), "%s%s", view, status);
     char right[48];
     buildStatusRight(right, sizeof(right), true);
-    drawStatusBarLine(status, right, bar_y);
+    drawStatusBarLine(left, right, bar_y);
 }
 
 void renderConnectScreen() {
-    partial_count++;
-    display.setPartialWindow(0, 0, SCREEN_W, SCREEN_H);
-    display.firstPage();
-    do {
-        display.fillScreen(GxEPD_WHITE);
-        display.setTextColor(GxEPD_BLACK);
-        display.setFont(NULL);
-        int y = MARGIN_Y + CHAR_H * 2;  // start a couple lines down
-        for (int i = 0; i < connect_status_count && i < CONNECT_STATUS_LINES; i++) {
-            display.setCursor(MARGIN_X, y);
-            display.print(connect_status[i]);
-            y += CHAR_H + 2;
-        }
-        drawTerminalStatusBar();
-    } while (display.nextPage());
+    fbBeginDraw();
+    frame_canvas.fillScreen(GxEPD_WHITE);
+    int y = MARGIN_Y + CHAR_H * 2;  // start a couple lines down
+    for (int i = 0; i < connect_status_count && i < CONNECT_STATUS_LINES; i++) {
+        frame_canvas.setCursor(MARGIN_X, y);
+        frame_canvas.print(connect_status[i]);
+        y += CHAR_H + 2;
+    }
+    drawTerminalStatusBar();
+    fbPush();
+    term_snap_full = true;  // the terminal rows were painted over
 }
 
-void renderTerminal() {
-    int y_start = 0;
-    int region_h = SCREEN_H;
-
-    partial_count++;
-    display.setPartialWindow(0, y_start, SCREEN_W, region_h);
-    display.firstPage();
-    do {
-        display.fillScreen(GxEPD_WHITE);
-        display.setTextColor(GxEPD_BLACK);
-        display.setFont(NULL);
+// Redraw the dirty rows into the canvas. Glyphs sit one pixel below the
+// cell top, so descenders reach the next row's first scanline: each dirty
+// row pulls its neighbours into the redraw, and a run keeps its first
+// scanline (owned by the clean row above) unless it starts at the top.
+static void drawTerminalDirtyRows() {
+    bool redraw[ROWS_PER_SCREEN];
+    memset(redraw, 0, sizeof(redraw));
+    for (int sl = 0; sl < ROWS_PER_SCREEN; sl++) {
+        if (!term_snap_row_dirty[sl]) continue;
+        redraw[sl] = true;
+        if (sl > 0) redraw[sl - 1] = true;
+        if (sl + 1 < ROWS_PER_SCREEN) redraw[sl + 1] = true;
+    }
+    int sl = 0;
+    while (sl < ROWS_PER_SCREEN) {
+        if (!redraw[sl]) { sl++; continue; }
+        int first = sl;
+        while (sl < ROWS_PER_SCREEN && redraw[sl]) sl++;
+        int last = sl - 1;
+        int y0 = MARGIN_Y + first * CHAR_H + (first > 0 ? 1 : 0);
+        int y1 = MARGIN_Y + (last + 1) * CHAR_H + (last == ROWS_PER_SCREEN - 1 ? 1 : 0);
+        frame_canvas.fillRect(0, y0, SCREEN_W, y1 - y0, GxEPD_WHITE);
+        drawTerminalLines(first, last);
+    }
+    memset(term_snap_row_dirty, 0, sizeof(term_snap_row_dirty));
+}
+
+static void drawTerminalFrame(bool all) {
+    fbBeginDraw();
+    if (all) {
+        frame_canvas.fillScreen(GxEPD_WHITE);
         drawTerminalLines(0, ROWS_PER_SCREEN - 1);
-        drawTerminalStatusBar();
-    } while (display.nextPage());
+        memset(term_snap_row_dirty, 0, sizeof(term_snap_row_dirty));
+    } else {
+        drawTerminalDirtyRows();
+    }
+    drawTerminalStatusBar();
+}
+
+void renderTerminal() {
+    drawTerminalFrame(false);
+    fbPush();
 }
 
 void renderTerminalFullClean() {
-    partial_count = 0;
-    display.setFullWindow();
-    display.firstPage();
-    do {
-        display.fillScreen(GxEPD_WHITE);
-        display.setTextColor(GxEPD_BLACK);
-        display.setFont(NULL);
-        drawTerminalLines(0, ROWS_PER_SCREEN - 1);
-        drawTerminalStatusBar();
-    } while (display.nextPage());
+    drawTerminalFrame(true);
+    fbPushFull();
 }
 
 void drawBtTrackpadStatusBar() {
     int bar_y = SCREEN_H - STATUS_H;
-    display.fillRect(0, bar_y, SCREEN_W, STATUS_H, GxEPD_BLACK);
-    display.setTextColor(GxEPD_WHITE);
-    display.setFont(NULL);
+    frame_canvas.fillRect(0, bar_y, SCREEN_W, STATUS_H, GxEPD_BLACK);
+    frame_canvas.setTextColor(GxEPD_WHITE);
+    frame_canvas.setFont(NULL);
     char status[72];
     if (btIsConnected()) {
         snprintf(status, sizeof(status), "BT trackpad %s", btPeerAddress());
@@ -376,105 +453,180 @@ void drawBtTrackpadStatusBar() {
 }
 
 void renderBtTrackpad() {
-    partial_count++;
-    display.setPartialWindow(0, 0, SCREEN_W, SCREEN_H);
-    display.firstPage();
-    do {
-        display.fillScreen(GxEPD_WHITE);
-        drawBtTrackpadStatusBar();
-    } while (display.nextPage());
+    fbBeginDraw();
+    frame_canvas.fillScreen(GxEPD_WHITE);
+    drawBtTrackpadStatusBar();
+    fbPush();
 }
 
 void renderBtTrackpadFullClean() {
-    partial_count = 0;
-    display.setFullWindow();
-    display.firstPage();
-    do {
-        display.fillScreen(GxEPD_WHITE);
-        drawBtTrackpadStatusBar();
-    } while (display.nextPage());
+    fbBeginDraw();
+    frame_canvas.fillScreen(GxEPD_WHITE);
+    drawBtTrackpadStatusBar();
+    fbPushFull();
 }
 
 // --- Notepad Rendering ---
 
-void refreshLines(int first_line, int last_line, const LayoutInfo& layout) {
+// Redraw text rows from first_line down (a wrap change can shift every
+// later row) plus the status bar; the shadow diff narrows what is sent.
+static void drawNotepadFrom(int first_line, const LayoutInfo& layout) {
     if (first_line < 0) first_line = 0;
-    if (last_line >= ROWS_PER_SCREEN) last_line = ROWS_PER_SCREEN - 1;
-
-    int y_start = MARGIN_Y + first_line * CHAR_H;
-    int region_h = SCREEN_H - y_start;
-
-    partial_count++;
-
-    display.setPartialWindow(0, y_start, SCREEN_W, region_h);
-    display.firstPage();
-    do {
-        display.fillScreen(GxEPD_WHITE);
-        display.setTextColor(GxEPD_BLACK);
-        display.setFont(NULL);
-        drawLinesRange(first_line, ROWS_PER_SCREEN - 1);
-        drawStatusBar(layout);
-    } while (display.nextPage());
+    // Text rows are drawn from row_y + 1, so a row's descender scanline sits
+    // on the next row's first y; keep it when the row above is not redrawn.
+    // A status-only refresh clears just the bar.
+    int y_start = MARGIN_Y + first_line * CHAR_H + (first_line > 0 ? 1 : 0);
+    if (first_line >= ROWS_PER_SCREEN) y_start = SCREEN_H - STATUS_H;
+
+    fbBeginDraw();
+    frame_canvas.fillRect(0, y_start, SCREEN_W, SCREEN_H - y_start, GxEPD_WHITE);
+    drawLinesRange(first_line, ROWS_PER_SCREEN - 1);
+    drawStatusBar(layout);
+}
+
+void refreshLines(int first_line, const LayoutInfo& layout) {
+    drawNotepadFrom(first_line, layout);
+    fbPush();
 }
 
 void refreshAllPartial(const LayoutInfo& layout) {
-    partial_count++;
-
-    display.setPartialWindow(0, 0, SCREEN_W, SCREEN_H);
-    display.firstPage();
-    do {
-        display.fillScreen(GxEPD_WHITE);
-        display.setTextColor(GxEPD_BLACK);
-        display.setFont(NULL);
-        drawLinesRange(0, ROWS_PER_SCREEN - 1);
-        drawStatusBar(layout);
-    } while (display.nextPage());
+    drawNotepadFrom(0, layout);
+    fbPush();
 }
 
 void refreshFullClean(const LayoutInfo& layout) {
-    partial_count = 0;
-    display.setFullWindow();
-    display.firstPage();
-    do {
-        display.fillScreen(GxEPD_WHITE);
-        display.setTextColor(GxEPD_BLACK);
-        display.setFont(NULL);
-        drawLinesRange(0, ROWS_PER_SCREEN - 1);
-        drawStatusBar(layout);
-    } while (display.nextPage());
+    drawNotepadFrom(0, layout);
+    fbPushFull();
 }
 
-// Take a snapshot of shared state (called with mutex held)
-void snapshotState() {
-    memcpy(snap_buf, text_buf, text_len + 1);
-    snap_len    = text_len;
-    snap_cursor = cursor_pos;
+// Take a snapshot of the visible window (called with mutex held). When
+// follow_cursor is set, scroll_line is adjusted to keep the cursor on screen.
+LayoutInfo snapshotState(bool follow_cursor) {
+    LayoutInfo layout = textComputeLayout(cursor_pos);
+    if (follow_cursor) {
+        if (layout.cursor_line < scroll_line) {
+            scroll_line = layout.cursor_line;
+        }
+        if (layout.cursor_line >= scroll_line + ROWS_PER_SCREEN) {
+            scroll_line = layout.cursor_line - ROWS_PER_SCREEN + 1;
+        }
+    }
     snap_scroll = scroll_line;
+    snap_total_lines = layout.total_lines;
+
+    int base = textOffsetAt(snap_scroll, 0);
+    for (int r = 0; r <= ROWS_PER_SCREEN; r++) {
+        snap_line_off[r] = textOffsetAt(snap_scroll + r, 0) - base;
+    }
+    snap_len = snap_line_off[ROWS_PER_SCREEN];
+    if (snap_len > SNAP_BUF_LEN) snap_len = SNAP_BUF_LEN;
+    textCopyOut(base, snap_len, snap_buf);
+    snap_buf[snap_len] = '\0';
+    snap_cursor = cursor_pos - base;
     snap_shift  = shift_held;
     snap_sym    = sym_mode;
+    return layout;
 }
 
 // --- Display Task (Core 0) ---
+//
+// The task sleeps on its notification value (RenderHint bits from
+// requestRender). Keystrokes draw at once; SSH output bursts are coalesced
+// until the stream pauses or the latency budget since the oldest request
+// runs out, whichever comes first. The budget adapts to the output rate and
+// shrinks while the user is typing so remote echo stays quick.
+
+static constexpr uint32_t RENDER_BUDGET_MAX_MS = 120;     // streaming output deadline
+static constexpr uint32_t RENDER_BUDGET_TYPING_MS = 30;   // output deadline while typing
+static constexpr uint32_t RENDER_TYPING_ACTIVE_MS = 1000; // "typing" = key within this window
+static constexpr uint32_t RENDER_QUIET_MIN_MS = 4;
+static constexpr uint32_t RENDER_FLOOD_MAX_MS = TERM_FLOOD_RENDER_MS;  // frame interval during an output flood
+static constexpr uint32_t RENDER_FLOOD_SETTLE_MS = 300;   // flood output pause that draws the final screen
+static constexpr uint32_t DISPLAY_IDLE_CHECK_MS = 500;    // mode-change safety net
 
 static LayoutInfo prev_layout = {1, 0, 0};
+static int prev_snap_scroll = 0;
+
+// Smoothed gaps between request sources, for the coalescing budget.
+static uint32_t render_output_gap_ms = RENDER_BUDGET_MAX_MS;
+static uint32_t render_last_output_ms = 0;
+static uint32_t render_last_typing_ms = 0;
+
+static void renderNoteArrival(uint32_t hints) {
+    uint32_t now = millis();
+    if (hints & RENDER_OUTPUT) {
+        uint32_t gap = now - render_last_output_ms;
+        if (gap > 1000) gap = 1000;
+        render_output_gap_ms = (render_output_gap_ms * 3 + gap) / 4;
+        render_last_output_ms = now;
+    }
+    if (hints & RENDER_TYPING) render_last_typing_ms = now;
+}
+
+static uint32_t renderBudgetMs(uint32_t hints) {
+    if (hints & RENDER_TYPING) return 0;
+    if (!(hints & RENDER_OUTPUT)) return 0;
+    // A flood only draws when it settles or every RENDER_FLOOD_MAX_MS.
+    if (term_flood_active) return RENDER_FLOOD_MAX_MS;
+    // Sporadic output (prompt, echo) draws at once; a stream is batched.
+    if (render_output_gap_ms >= RENDER_BUDGET_MAX_MS) return 0;
+    if (millis() - render_last_typing_ms < RENDER_TYPING_ACTIVE_MS) return RENDER_BUDGET_TYPING_MS;
+    return RENDER_BUDGET_MAX_MS;
+}
+
+// Gather more requests while a burst is still arriving. Returns the merged
+// hints; the frame is due once the stream pauses or the deadline passes.
+static uint32_t renderCoalesce(uint32_t hints, uint32_t first_ms) {
+    for (;;) {
+        uint32_t budget = renderBudgetMs(hints);
+        uint32_t elapsed = millis() - first_ms;
+        if (budget == 0 || elapsed >= budget) return hints;
+        uint32_t quiet = render_output_gap_ms * 2;
+        if (quiet < RENDER_QUIET_MIN_MS) quiet = RENDER_QUIET_MIN_MS;
+        if (term_flood_active) quiet = RENDER_FLOOD_SETTLE_MS;
+        if (quiet > budget - elapsed) quiet = budget - elapsed;
+        uint32_t more = 0;
+        if (xTaskNotifyWait(0, UINT32_MAX, &more, pdMS_TO_TICKS(quiet)) != pdTRUE) return hints;
+        renderNoteArrival(more);
+        hints |= more;
+    }
+}
+
+static LatFrame lat_frame;
+
+static uint32_t renderFrameBegin(bool terminal = false) {
+    display_idle = false;
+    latFrameBegin(lat_frame, terminal);
+    return millis();
+}
+
+static void renderFrameEnd(uint32_t queued_ms, uint32_t started_ms) {
+    uint32_t done = millis();
+    latFrameEnd(lat_frame);
+    perfRecordFrame(queued_ms ? started_ms - queued_ms : 0, done - started_ms);
+    display_idle = true;
+}
 
 void displayTask(void* param) {
     // Initial full refresh
     xSemaphoreTake(state_mutex, portMAX_DELAY);
-    snapshotState();
+    prev_layout = snapshotState(false);
+    prev_snap_scroll = snap_scroll;
     xSemaphoreGive(state_mutex);
-    display_idle = false;
-    prev_layout = computeLayoutFrom(snap_buf, snap_len, snap_cursor);
-    uint32_t render_started = millis();
+    uint32_t started = renderFrameBegin();
     refreshFullClean(prev_layout);
-    perfRecordRenderMs(millis() - render_started);
-    display_idle = true;
+    renderFrameEnd(0, started);
 
     AppMode last_mode = MODE_NOTEPAD;
+    uint32_t hints = 0;
 
     for (;;) {
-        // Yield SPI bus to SD card operations
-        if (sd_busy) { vTaskDelay(1); continue; }
+        if (hints == 0) {
+            uint32_t bits = 0;
+            xTaskNotifyWait(0, UINT32_MAX, &bits, pdMS_TO_TICKS(DISPLAY_IDLE_CHECK_MS));
+            renderNoteArrival(bits);
+            hints |= bits;
+        }
 
         // Power off requested — render art and enter deep sleep
         if (poweroff_requested) {
@@ -482,160 +634,118 @@ void displayTask(void* param) {
         }
 
         AppMode cur_mode = app_mode;
+        if (hints == 0 && cur_mode == last_mode) continue;
+
+        uint32_t queued = render_request_first_ms;
+        if (hints != 0 && queued != 0) hints = renderCoalesce(hints, queued);
+
+        // Yield SPI bus to SD card operations
+        if (sd_busy) {
+            uint32_t bits = 0;
+            xTaskNotifyWait(0, UINT32_MAX, &bits, 1);
+            renderNoteArrival(bits);
+            hints |= bits;
+            continue;
+        }
+        render_request_first_ms = 0;
+        uint32_t frame = hints;
+        hints = 0;
+        cur_mode = app_mode;
 
         // Mode switch — full redraw
         if (cur_mode != last_mode) {
             last_mode = cur_mode;
             partial_count = 0;
-            display_idle = false;
             if (cur_mode == MODE_TERMINAL) {
-                xSemaphoreTake(state_mutex, portMAX_DELAY);
+                termLock();
                 snapshotTerminalState();
-                xSemaphoreGive(state_mutex);
-                uint32_t render_started = millis();
+                termUnlock();
+                started = renderFrameBegin(true);
                 renderTerminalFullClean();
-                perfRecordRenderMs(millis() - render_started);
             } else if (cur_mode == MODE_BT) {
-                uint32_t render_started = millis();
+                started = renderFrameBegin();
                 renderBtTrackpadFullClean();
-                perfRecordRenderMs(millis() - render_started);
             } else if (cur_mode == MODE_COMMAND) {
-                uint32_t render_started = millis();
+                started = renderFrameBegin();
                 renderCommandPrompt();
-                perfRecordRenderMs(millis() - render_started);
             } else {
                 xSemaphoreTake(state_mutex, portMAX_DELAY);
-                snapshotState();
+                prev_layout = snapshotState(false);
+                prev_snap_scroll = snap_scroll;
                 xSemaphoreGive(state_mutex);
-                prev_layout = computeLayoutFrom(snap_buf, snap_len, snap_cursor);
-                uint32_t render_started = millis();
+                started = renderFrameBegin();
                 refreshFullClean(prev_layout);
-                perfRecordRenderMs(millis() - render_started);
             }
-            display_idle = true;
-            render_requested = false;
-            term_render_requested = false;
+            renderFrameEnd(queued, started);
             continue;
         }
 
         // --- Terminal mode ---
         if (cur_mode == MODE_TERMINAL) {
-            if (term_render_requested || render_requested) {
-                term_render_requested = false;
-                render_requested = false;
-
-                display_idle = false;
-                uint32_t render_started = millis();
-                if (cur_mode == MODE_TERMINAL && connect_status_count > 0) {
-                    renderConnectScreen();
+            if (!(frame & (RENDER_TERMINAL | RENDER_EDITOR | RENDER_STATUS))) continue;
+            if (connect_status_count > 0) {
+                started = renderFrameBegin(true);
+                renderConnectScreen();
+            } else {
+                termLock();
+                snapshotTerminalState();
+                termUnlock();
+                started = renderFrameBegin(true);
+
+                if (partial_count >= 20) {
+                    renderTerminalFullClean();
                 } else {
-                    xSemaphoreTake(state_mutex, portMAX_DELAY);
-                    snapshotTerminalState();
-                    xSemaphoreGive(state_mutex);
-
-                    if (partial_count >= 20) {
-                        renderTerminalFullClean();
-                    } else {
-                        renderTerminal();
-                    }
+                    renderTerminal();
                 }
-                perfRecordRenderMs(millis() - render_started);
-                display_idle = true;
             }
-            vTaskDelay(1);
+            renderFrameEnd(queued, started);
             continue;
         }
 
         // --- Bluetooth trackpad mode ---
         if (cur_mode == MODE_BT) {
-            if (render_requested || term_render_requested) {
-                render_requested = false;
-                term_render_requested = false;
-                display_idle = false;
-                uint32_t render_started = millis();
-                if (partial_count >= 20) renderBtTrackpadFullClean();
-                else renderBtTrackpad();
-                perfRecordRenderMs(millis() - render_started);
-                display_idle = true;
-            }
-            vTaskDelay(1);
+            started = renderFrameBegin();
+            if (partial_count >= 20) renderBtTrackpadFullClean();
+            else renderBtTrackpad();
+            renderFrameEnd(queued, started);
             continue;
         }
 
         // --- Command mode ---
         if (cur_mode == MODE_COMMAND) {
-            if (render_requested) {
-                render_requested = false;
-                display_idle = false;
-                uint32_t render_started = millis();
-                renderCommandPrompt();
-                perfRecordRenderMs(millis() - render_started);
-                display_idle = true;
-            }
-            vTaskDelay(1);
+            if (!(frame & (RENDER_EDITOR | RENDER_STATUS))) continue;
+            started = renderFrameBegin();
+            renderCommandPrompt();
+            renderFrameEnd(queued, started);
             continue;
         }
 
         // --- Notepad mode ---
-        if (!render_requested) {
-            vTaskDelay(1);
-            continue;
-        }
-        render_requested = false;
+        if (!(frame & (RENDER_EDITOR | RENDER_STATUS | RENDER_SCROLL))) continue;
 
         xSemaphoreTake(state_mutex, portMAX_DELAY);
-        snapshotState();
-
-        LayoutInfo cur = computeLayoutFrom(snap_buf, snap_len, snap_cursor);
-
-        if (cur.cursor_line < snap_scroll) {
-            snap_scroll = cur.cursor_line;
-        }
-        if (cur.cursor_line >= snap_scroll + ROWS_PER_SCREEN) {
-            snap_scroll = cur.cursor_line - ROWS_PER_SCREEN + 1;
-        }
-        scroll_line = snap_scroll;
+        // A touch scroll may move the view away from the cursor until the next edit.
+        LayoutInfo cur = snapshotState((frame & RENDER_EDITOR) || !(frame & RENDER_SCROLL));
         xSemaphoreGive(state_mutex);
+        bool scrolled = snap_scroll != prev_snap_scroll;
+        prev_snap_scroll = snap_scroll;
 
-        display_idle = false;
+        started = renderFrameBegin();
         if (partial_count >= 20) {
-            uint32_t render_started = millis();
             refreshFullClean(cur);
-            perfRecordRenderMs(millis() - render_started);
-            display_idle = true;
-            prev_layout = cur;
-            continue;
-        }
-
-        int line_delta = abs(cur.cursor_line - prev_layout.cursor_line);
-        if (line_delta > ROWS_PER_SCREEN) {
-            uint32_t render_started = millis();
+        } else if (scrolled || abs(cur.cursor_line - prev_layout.cursor_line) > ROWS_PER_SCREEN) {
             refreshAllPartial(cur);
-            perfRecordRenderMs(millis() - render_started);
-            display_idle = true;
-            prev_layout = cur;
-            continue;
-        }
-
-        int old_sl = prev_layout.cursor_line - snap_scroll;
-        int new_sl = cur.cursor_line - snap_scroll;
-
-        if (cur.total_lines != prev_layout.total_lines) {
-            int from = min(old_sl, new_sl);
-            if (from < 0) from = 0;
-            uint32_t render_started = millis();
-            refreshLines(from, ROWS_PER_SCREEN - 1, cur);
-            perfRecordRenderMs(millis() - render_started);
         } else {
-            int min_l = min(old_sl, new_sl);
-            int max_l = max(old_sl, new_sl);
-            if (min_l < 0) min_l = 0;
-            uint32_t render_started = millis();
-            refreshLines(min_l, max_l, cur);
-            perfRecordRenderMs(millis() - render_started);
+            int old_sl = prev_layout.cursor_line - snap_scroll;
+            int new_sl = cur.cursor_line - snap_scroll;
+            if (old_sl == new_sl && !(frame & RENDER_EDITOR)) {
+                // Status-only change: redraw the bar.
+                refreshLines(ROWS_PER_SCREEN, cur);
+            } else {
+                refreshLines(min(old_sl, new_sl), cur);
+            }
         }
-        display_idle = true;
-
+        renderFrameEnd(queued, started);
         prev_layout = cur;
     }
 }
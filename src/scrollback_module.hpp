@@ -0,0 +1,191 @@
+#pragma once
+
+// --- Terminal Scrollback (PSRAM) ---
+//
+// The live grid only holds the screen; lines scrolled off the top of the main
+// screen are appended here. Each line is stored as a variable-length record
+// in a PSRAM byte ring: trailing spaces are dropped and runs of 2+ spaces
+// become one byte (HIST_RUN_BASE + n; grid cells are printable ASCII, so the
+// high range is free). hist_start holds each record's absolute arena offset,
+// indexed by line sequence number. The oldest lines are dropped when either
+// ring is full; worst case (40 non-space chars) still keeps over 12k lines.
+//
+// The view can be scrolled back into history (term_view_hist lines above the
+// grid). History rows are read through a small decoded-line cache so touch
+// scrolling does not re-decode the window on every frame.
+//
+// All state is protected by term_mutex.
+
+static constexpr uint32_t HIST_LINES = 16384;       // index slots, power of two
+static constexpr uint32_t HIST_BYTES = 512 * 1024;  // record arena, power of two
+static constexpr uint8_t  HIST_RUN_BASE = 0x80;
+static constexpr int      HIST_CACHE_LINES = 64;
+
+struct HistCacheLine {
+    uint32_t seq;
+    bool valid;
+    char text[TERM_COLS + 1];
+};
+
+static uint8_t*       hist_arena = NULL;
+static uint32_t*      hist_start = NULL;
+static HistCacheLine* hist_cache = NULL;
+static uint32_t hist_first = 0;      // sequence number of the oldest kept line
+static uint32_t hist_next = 0;       // sequence number of the next pushed line
+static uint32_t hist_write_pos = 0;  // absolute arena offset of the next record
+
+static int term_view_hist = 0;       // lines scrolled back above the grid (0 = live)
+
+void termHistoryInit() {
+    hist_arena = (uint8_t*)ps_malloc(HIST_BYTES);
+    hist_start = (uint32_t*)ps_malloc(HIST_LINES * sizeof(uint32_t));
+    hist_cache = (HistCacheLine*)ps_malloc(HIST_CACHE_LINES * sizeof(HistCacheLine));
+    if (!hist_arena || !hist_start || !hist_cache) {
+        free(hist_arena);
+        free(hist_start);
+        free(hist_cache);
+        hist_arena = NULL;
+        hist_start = NULL;
+        hist_cache = NULL;
+        SERIAL_LOGLN("Scrollback: no PSRAM, history disabled");
+        return;
+    }
+    memset(hist_cache, 0, HIST_CACHE_LINES * sizeof(HistCacheLine));
+}
+
+static inline int termHistoryCount() {
+    return (int)(hist_next - hist_first);
+}
+
+void termHistoryClear() {
+    hist_first = hist_next;
+    term_view_hist = 0;
+}
+
+// Append one grid row (TERM_COLS chars) as the newest history line.
+void termHistoryPush(const char* row) {
+    if (!hist_arena) return;
+    int end = TERM_COLS;
+    while (end > 0 && row[end - 1] == ' ') end--;
+
+    uint8_t rec[TERM_COLS + 1];
+    int len = 1;
+    for (int i = 0; i < end;) {
+        if (row[i] == ' ' && i + 1 < end && row[i + 1] == ' ') {
+            int run = 2;
+            while (i + run < end && row[i + run] == ' ') run++;
+            rec[len++] = HIST_RUN_BASE + run;
+            i += run;
+        } else {
+            rec[len++] = (uint8_t)row[i++];
+        }
+    }
+    rec[0] = (uint8_t)(len - 1);
+
+    while (hist_next != hist_first &&
+           (termHistoryCount() >= (int)HIST_LINES - 1 ||
+            hist_write_pos + len - hist_start[hist_first & (HIST_LINES - 1)] > HIST_BYTES)) {
+        hist_first++;
+    }
+    hist_start[hist_next & (HIST_LINES - 1)] = hist_write_pos;
+    for (int i = 0; i < len; i++) {
+        hist_arena[(hist_write_pos + i) & (HIST_BYTES - 1)] = rec[i];
+    }
+    hist_write_pos += len;
+    hist_next++;
+
+    // Keep a scrolled-back view on the same text while output continues.
+    if (term_view_hist > 0) {
+        term_view_hist++;
+        if (term_view_hist > termHistoryCount()) term_view_hist = termHistoryCount();
+    }
+}
+
+// Decoded text (TERM_COLS chars + NUL) of history line idx, 0 = oldest kept.
+const char* termHistoryLine(int idx) {
+    static char empty[TERM_COLS + 1];
+    if (!hist_arena || idx < 0 || idx >= termHistoryCount()) {
+        memset(empty, ' ', TERM_COLS);
+        empty[TERM_COLS] = '\0';
+        return empty;
+    }
+    uint32_t seq = hist_first + idx;
+    HistCacheLine& line = hist_cache[seq % HIST_CACHE_LINES];
+    if (line.valid && line.seq == seq) return line.text;
+
+    uint32_t pos = hist_start[seq & (HIST_LINES - 1)];
+    int n = hist_arena[pos & (HIST_BYTES - 1)];
+    int col = 0;
+    for (int i = 1; i <= n && col < TERM_COLS; i++) {
+        uint8_t b = hist_arena[(pos + i) & (HIST_BYTES - 1)];
+        if (b >= HIST_RUN_BASE) {
+            for (int r = b - HIST_RUN_BASE; r > 0 && col < TERM_COLS; r--) line.text[col++] = ' ';
+        } else {
+            line.text[col++] = (char)b;
+        }
+    }
+    while (col < TERM_COLS) line.text[col++] = ' ';
+    line.text[TERM_COLS] = '\0';
+    line.seq = seq;
+    line.valid = true;
+    return line.text;
+}
+
+// Move the view by lines (positive = back in time). History is only shown
+// over the main screen.
+void termViewScroll(int lines) {
+    if (term_alt_active) {
+        term_view_hist = 0;
+        return;
+    }
+    int v = term_view_hist + lines;
+    if (v > termHistoryCount()) v = termHistoryCount();
+    if (v < 0) v = 0;
+    term_view_hist = v;
+}
+
+// Return the view to the live screen; true if it was scrolled back.
+bool termViewLive() {
+    if (term_view_hist == 0) return false;
+    term_view_hist = 0;
+    return true;
+}
+
+// --- Search ---
+//
+// Lines are numbered oldest first across history and then the live grid.
+// A new search walks backwards from the newest line and leaves the match on
+// the top row of the view; repeating it continues further back.
+
+static char term_search_pat[48] = "";
+static int  term_search_before = -1;
+
+static const char* termVirtualLine(int v) {
+    int hist = termHistoryCount();
+    if (v < hist) return termHistoryLine(v);
+    return termRow(v - hist);
+}
+
+// Returns the matched line number (0 = oldest) or -1. An empty pattern
+// repeats the previous search from its last match.
+int termSearch(const char* pat, int* total_out) {
+    int hist = termHistoryCount();
+    int total = hist + (term_alt_active ? 0 : term_line_count);
+    if (total_out) *total_out = total;
+    if (pat && pat[0]) {
+        strncpy(term_search_pat, pat, sizeof(term_search_pat) - 1);
+        term_search_pat[sizeof(term_search_pat) - 1] = '\0';
+        term_search_before = -1;
+    }
+    if (!term_search_pat[0] || term_alt_active) return -1;
+
+    int before = term_search_before;
+    if (before < 0 || before > total) before = total;  // new search: from the newest line
+    for (int v = before - 1; v >= 0; v--) {
+        if (!strstr(termVirtualLine(v), term_search_pat)) continue;
+        term_search_before = v;
+        term_view_hist = v < hist ? hist - v : 0;
+        return v;
+    }
+    return -1;
+}
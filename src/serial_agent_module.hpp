@@ -63,8 +63,8 @@ static bool agentDispatchEventLocked(int event_code) {
 
     if (needs_render) {
         AppMode cur = app_mode;
-        if (cur == MODE_TERMINAL) term_render_requested = true;
-        else render_requested = true;
+        if (cur == MODE_TERMINAL) requestRender(RENDER_TERMINAL | RENDER_TYPING);
+        else requestRender(RENDER_EDITOR | RENDER_TYPING);
     }
     return true;
 }
@@ -197,7 +197,7 @@ static char* agentTrim(char* s) {
 
 static void agentReportStateLocked() {
     Serial.printf(
-        "AGENT OK STATE mode=%s text_len=%d cursor=%d scroll=%d cmd_len=%d wifi=%d ssh=%d bt=%s touch=%d heap=%d up=%d/%d up_run=%d down=%d/%d down_run=%d\n",
+        "AGENT OK STATE mode=%s text_len=%d cursor=%d scroll=%d cmd_len=%d wifi=%d ssh=%d sess=%d bt=%s touch=%d heap=%d up=%d/%d up_run=%d down=%d/%d down_run=%d save_q=%d ssh_tx_bytes=%lu ssh_tx_writes=%lu pred_hit=%lu pred_miss=%lu key_block_max=%lu key_q_hw=%lu key_drop=%lu touch_hz=%lu touch_lat_max_us=%lu touch_drop=%lu bt_move_hz=%lu bt_move_lat_max=%lu frame_wait=%lu frame_wait_max=%lu frame_ms=%lu ssh_rx_wake=%lu ssh_rx_busy_us=%lu ssh_rx_stop_fail=%lu\n",
         agentModeName(app_mode),
         text_len,
         cursor_pos,
@@ -205,6 +205,7 @@ static void agentReportStateLocked() {
         cmd_len,
         (int)wifi_state,
         ssh_connected ? 1 : 0,
+        term_session_active + 1,
         btStatusShort(),
         touch_available ? 1 : 0,
         ESP.getFreeHeap(),
@@ -213,7 +214,26 @@ static void agentReportStateLocked() {
         upload_running ? 1 : 0,
         download_done_count,
         download_total_count,
-        download_running ? 1 : 0
+        download_running ? 1 : 0,
+        storagePendingCount(),
+        (unsigned long)ssh_tx_bytes,
+        (unsigned long)ssh_tx_writes,
+        (unsigned long)term_pred_hits,
+        (unsigned long)term_pred_misses,
+        (unsigned long)perf_key_block_max_ms,
+        (unsigned long)perf_key_queue_hw,
+        (unsigned long)perf_key_drop_count,
+        (unsigned long)perf_touch_rate_hz,
+        (unsigned long)perf_touch_lat_max_us,
+        (unsigned long)perf_touch_drop_count,
+        (unsigned long)perf_bt_move_rate_hz,
+        (unsigned long)perf_bt_move_lat_max_ms,
+        (unsigned long)perf_frame_wait_last_ms,
+        (unsigned long)perf_frame_wait_max5_ms,
+        (unsigned long)perf_frame_render_last_ms,
+        (unsigned long)ssh_rx_wakes,
+        (unsigned long)ssh_rx_busy_us,
+        (unsigned long)ssh_rx_stop_fails
     );
 }
 
@@ -241,7 +261,7 @@ static void agentRunCommand(char* line) {
         return;
     }
     if (strcasecmp(p, "HELP") == 0) {
-        agentReplyOk("commands=PING HELP STATE GPS WIFI RESULT RESULTALL TRACE TERMDBG TERMSNAP TERMHEX TERMRANGE KEY PRESS TEXT CMD WAIT RENDER BOOTOFF");
+        agentReplyOk("commands=PING HELP STATE GPS WIFI RESULT RESULTALL LAT TRACE TERMDBG TERMSNAP TERMHEX TERMRANGE KEY PRESS TEXT CMD WAIT RENDER BOOTOFF");
         return;
     }
 
@@ -283,6 +303,21 @@ static void agentRunCommand(char* line) {
         return;
     }
 
+    if (strcasecmp(p, "LAT") == 0) {
+        if (arg && strcasecmp(arg, "RESET") == 0) {
+            latResetAll();
+            agentReplyOk("LAT reset");
+            return;
+        }
+        if (arg && *arg) {
+            agentReplyErr("usage: @LAT [RESET]");
+            return;
+        }
+        agentReplyOk("LAT buckets=%d unit=us", LAT_BUCKETS);
+        latDumpAll();
+        return;
+    }
+
     if (strcasecmp(p, "TRACE") == 0) {
         if (!arg || *arg == '\0') {
             agentReplyOk("TRACE enabled=%d", terminalDebugTraceEnabled() ? 1 : 0);
@@ -450,7 +485,9 @@ static void agentRunCommand(char* line) {
         if (row >= TERM_ROWS) row = TERM_ROWS - 1;
 
         char line[TERM_COLS + 1];
-        memcpy(line, term_buf[row], TERM_COLS);
+        termLock();
+        memcpy(line, termRow(row), TERM_COLS);
+        termUnlock();
         line[TERM_COLS] = '\0';
         int end = TERM_COLS;
         while (end > 0 && line[end - 1] == ' ') end--;
@@ -479,10 +516,14 @@ static void agentRunCommand(char* line) {
         if (row < 0) row = 0;
         if (row >= TERM_ROWS) row = TERM_ROWS - 1;
 
+        char cells[TERM_COLS];
+        termLock();
+        memcpy(cells, termRow(row), TERM_COLS);
+        termUnlock();
         char hex[TERM_COLS * 3 + 1];
         int pos = 0;
         for (int i = 0; i < TERM_COLS; i++) {
-            pos += snprintf(&hex[pos], sizeof(hex) - pos, "%02X", (unsigned char)term_buf[row][i]);
+            pos += snprintf(&hex[pos], sizeof(hex) - pos, "%02X", (unsigned char)cells[i]);
             if (i + 1 < TERM_COLS && pos < (int)sizeof(hex) - 1) hex[pos++] = ' ';
             if (pos >= (int)sizeof(hex) - 1) break;
         }
@@ -513,7 +554,9 @@ static void agentRunCommand(char* line) {
             int row = first + i;
             if (row < 0 || row >= TERM_ROWS) break;
             char line[TERM_COLS + 1];
-            memcpy(line, term_buf[row], TERM_COLS);
+            termLock();
+            memcpy(line, termRow(row), TERM_COLS);
+            termUnlock();
             line[TERM_COLS] = '\0';
             int end = TERM_COLS;
             while (end > 0 && line[end - 1] == ' ') end--;
@@ -550,8 +593,7 @@ static void agentRunCommand(char* line) {
     }
 
     if (strcasecmp(p, "RENDER") == 0) {
-        render_requested = true;
-        term_render_requested = true;
+        requestRender(RENDER_EDITOR | RENDER_TERMINAL);
         agentReplyOk("RENDER queued");
         xSemaphoreGive(state_mutex);
         return;
@@ -559,6 +601,7 @@ static void agentRunCommand(char* line) {
 
     if (strcasecmp(p, "BOOTOFF") == 0) {
         poweroff_requested = true;
+        requestRender(RENDER_EDITOR);
         agentReplyOk("BOOTOFF");
         xSemaphoreGive(state_mutex);
         return;
@@ -683,8 +726,8 @@ static void agentRunCommand(char* line) {
             agentReplyErr("busy: state lock timeout");
             return;
         }
-        if (app_mode == MODE_TERMINAL) term_render_requested = true;
-        else render_requested = true;
+        if (app_mode == MODE_TERMINAL) requestRender(RENDER_TERMINAL);
+        else requestRender(RENDER_EDITOR);
         agentReplyOk("CMD %s", arg);
         xSemaphoreGive(state_mutex);
         return;
@@ -0,0 +1,400 @@
+#pragma once
+
+// --- SSH Channel Multiplexer ---
+//
+// sshReceiveTask owns the SSH sessions. Besides the shell channels (fed to
+// term_rx, written by ssh_tx) it services every exec channel opened
+// here, so a transfer or remote shortcut runs next to the shell instead of
+// stopping it. Each exec channel has a bounded receive ring and send ring;
+// while a channel is open only the receive task moves its data, its EOF
+// and its errors through libssh. Open and close run on the consumer's task
+// under ssh_io_mutex.
+//
+// Per pass the owner reads into a channel's rx ring while it has room
+// (stderr is read and dropped, or a chatty command never reaches EOF),
+// then writes what the tx ring holds, never more than the remote window,
+// so a stalled peer can't block the pass. A full rx ring leaves the data
+// in the SSH channel window; the consumer kicks the owner once it frees
+// room. After a pass that moved anything the channel's notify callback
+// runs and ->ready is given, which wakes a consumer blocked in
+// sshMuxRead/sshMuxWrite.
+//
+// Ring contents, ->chan and the remote_eof/failed flags change only under
+// ssh_io_mutex, so a slot closed and reopened between passes never sees a
+// stale write. sshMuxAbortSession (disconnect) fails the session's
+// channels; a slot stays claimed until its consumer closes it. A channel
+// stays with the session it was opened on across terminal session switches.
+
+static constexpr int SSH_MUX_MAX = 3;
+static constexpr uint32_t SSH_MUX_RX_SIZE = 8192;          // power of two
+static constexpr uint32_t SSH_MUX_TX_SIZE = 4096;          // power of two
+static constexpr uint32_t SSH_MUX_CHUNK = 1024;            // bytes per libssh call
+static constexpr uint32_t SSH_MUX_IO_TIMEOUT_MS = 15000;   // consumer gives up without progress
+
+struct SshMuxChannel;
+typedef void (*SshMuxNotify)(SshMuxChannel* ch, void* arg);
+
+struct SshMuxRing {
+    uint8_t* buf;
+    uint32_t size;
+    uint32_t head;   // free-running
+    uint32_t tail;   // free-running
+};
+
+struct SshMuxChannel {
+    bool in_use;                 // slot claimed by a consumer
+    ssh_session sess;            // session the channel was opened on
+    ssh_channel chan;            // NULL unless open
+    SshMuxRing rx;
+    SshMuxRing tx;
+    volatile bool eof_wanted;    // consumer: send EOF once tx drains
+    volatile bool eof_sent;
+    volatile bool remote_eof;
+    volatile bool failed;
+    SemaphoreHandle_t ready;
+    SshMuxNotify notify;         // runs on the receive task
+    void* notify_arg;
+};
+
+static SshMuxChannel ssh_mux[SSH_MUX_MAX];
+static portMUX_TYPE ssh_mux_lock = portMUX_INITIALIZER_UNLOCKED;
+
+static volatile uint32_t ssh_mux_rx_bytes = 0;   // exec bytes received since boot
+static volatile uint32_t ssh_mux_tx_bytes = 0;   // exec bytes written since boot
+
+static uint32_t sshMuxRingUsed(SshMuxRing* r) {
+    portENTER_CRITICAL(&ssh_mux_lock);
+    uint32_t n = r->head - r->tail;
+    portEXIT_CRITICAL(&ssh_mux_lock);
+    return n;
+}
+
+static uint32_t sshMuxRingPush(SshMuxRing* r, const uint8_t* data, uint32_t len) {
+    portENTER_CRITICAL(&ssh_mux_lock);
+    uint32_t head = r->head;
+    uint32_t n = r->size - (head - r->tail);
+    if (len < n) n = len;
+    uint32_t pos = head & (r->size - 1);
+    uint32_t first = r->size - pos;
+    if (first > n) first = n;
+    memcpy(r->buf + pos, data, first);
+    memcpy(r->buf, data + first, n - first);
+    r->head = head + n;
+    portEXIT_CRITICAL(&ssh_mux_lock);
+    return n;
+}
+
+static uint32_t sshMuxRingPop(SshMuxRing* r, uint8_t* out, uint32_t max) {
+    portENTER_CRITICAL(&ssh_mux_lock);
+    uint32_t tail = r->tail;
+    uint32_t n = r->head - tail;
+    if (n > max) n = max;
+    uint32_t pos = tail & (r->size - 1);
+    uint32_t first = r->size - pos;
+    if (first > n) first = n;
+    memcpy(out, r->buf + pos, first);
+    memcpy(out + first, r->buf, n - first);
+    r->tail = tail + n;
+    portEXIT_CRITICAL(&ssh_mux_lock);
+    return n;
+}
+
+// Receive task: is any exec channel open?
+static bool sshMuxActive() {
+    for (int i = 0; i < SSH_MUX_MAX; i++) {
+        if (ssh_mux[i].chan) return true;
+    }
+    return false;
+}
+
+// Receive task, with ssh_io_mutex held: read into rx. Returns true on progress.
+static bool sshMuxReceive(SshMuxChannel* ch, uint8_t* buf) {
+    bool moved = false;
+    while (!ch->remote_eof && ch->rx.size - sshMuxRingUsed(&ch->rx) >= SSH_MUX_CHUNK) {
+        int n = ssh_channel_read_nonblocking(ch->chan, buf, SSH_MUX_CHUNK, 0);
+        if (n > 0) {
+            sshMuxRingPush(&ch->rx, buf, (uint32_t)n);
+            ssh_mux_rx_bytes += n;
+            moved = true;
+            continue;
+        }
+        if (n == SSH_ERROR) {
+            ch->failed = true;
+            return true;
+        }
+        while (ssh_channel_read_nonblocking(ch->chan, buf, SSH_MUX_CHUNK, 1) > 0) {}
+        if (ssh_channel_is_eof(ch->chan)) {
+            ch->remote_eof = true;
+            moved = true;
+        }
+        break;
+    }
+    return moved;
+}
+
+// Receive task, with ssh_io_mutex held: write tx up to the remote window,
+// then the EOF the consumer asked for. Returns true on progress.
+static bool sshMuxTransmit(SshMuxChannel* ch, uint8_t* buf) {
+    bool moved = false;
+    uint32_t pending;
+    while ((pending = sshMuxRingUsed(&ch->tx)) > 0) {
+        uint32_t n = ssh_channel_window_size(ch->chan);
+        if (n == 0) return moved;  // the window adjust wakes the select
+        if (n > pending) n = pending;
+        if (n > SSH_MUX_CHUNK) n = SSH_MUX_CHUNK;
+        n = sshMuxRingPop(&ch->tx, buf, n);
+        int wrote = ssh_channel_write(ch->chan, buf, n);
+        if (wrote != (int)n) {
+            SERIAL_LOGF("SSH: exec write failed (%d/%lu)\n", wrote, (unsigned long)n);
+            ch->failed = true;
+            return true;
+        }
+        ssh_mux_tx_bytes += n;
+        moved = true;
+    }
+    if (ch->eof_wanted && !ch->eof_sent) {
+        ssh_channel_send_eof(ch->chan);
+        ch->eof_sent = true;
+        moved = true;
+    }
+    return moved;
+}
+
+// Receive task: one pass over the exec channels. Returns true if any moved.
+static bool sshMuxService() {
+    static uint8_t buf[SSH_MUX_CHUNK];
+    bool busy = false;
+    for (int i = 0; i < SSH_MUX_MAX; i++) {
+        SshMuxChannel* ch = &ssh_mux[i];
+        if (!ch->chan || ch->failed) continue;
+        if (!sshIOLock()) continue;
+        bool moved = false;
+        if (ch->chan && !ch->failed) {
+            moved = sshMuxReceive(ch, buf);
+            if (!ch->failed) moved = sshMuxTransmit(ch, buf) || moved;
+        }
+        sshIOUnlock();
+        if (!moved) continue;
+        if (ch->notify) ch->notify(ch, ch->notify_arg);
+        xSemaphoreGive(ch->ready);
+        busy = true;
+    }
+    return busy;
+}
+
+// Receive task: add the sockets of sessions with open exec channels to the
+// select set; returns the new max fd.
+static int sshMuxSockets(fd_set* rfds, int max_fd) {
+    for (int i = 0; i < SSH_MUX_MAX; i++) {
+        ssh_session sess = ssh_mux[i].chan ? ssh_mux[i].sess : NULL;
+        socket_t sock = sess ? ssh_get_fd(sess) : SSH_INVALID_SOCKET;
+        if (sock == SSH_INVALID_SOCKET) continue;
+        FD_SET(sock, rfds);
+        if (sock > max_fd) max_fd = sock;
+    }
+    return max_fd;
+}
+
+// Session teardown, with ssh_io_mutex held: the session's channels die
+// with it, so fail them and wake their consumers.
+static void sshMuxAbortSession(ssh_session sess) {
+    for (int i = 0; i < SSH_MUX_MAX; i++) {
+        SshMuxChannel* ch = &ssh_mux[i];
+        if (!ch->chan || ch->sess != sess) continue;
+        ch->chan = NULL;
+        ch->failed = true;
+        xSemaphoreGive(ch->ready);
+    }
+}
+
+static void sshMuxRelease(SshMuxChannel* ch) {
+    portENTER_CRITICAL(&ssh_mux_lock);
+    ch->in_use = false;
+    portEXIT_CRITICAL(&ssh_mux_lock);
+}
+
+// Why sshMuxOpenExec failed. Only SSH_MUX_SESSION_LOST means the session
+// itself is gone; the rest are local limits or a refusal by the server, and
+// the shell on the same session is still fine.
+enum SshMuxOpenResult {
+    SSH_MUX_OPENED,
+    SSH_MUX_NO_SESSION,     // not connected
+    SSH_MUX_NO_SLOT,        // all SSH_MUX_MAX channels in use
+    SSH_MUX_NO_MEMORY,
+    SSH_MUX_IO_BUSY,        // ssh_io_mutex not free within the timeout
+    SSH_MUX_REFUSED,        // server refused the channel or the command
+    SSH_MUX_SESSION_LOST,   // the connection died
+};
+
+static const char* sshMuxOpenResultText(SshMuxOpenResult r) {
+    switch (r) {
+        case SSH_MUX_OPENED:       return "ok";
+        case SSH_MUX_NO_SESSION:   return "not connected";
+        case SSH_MUX_NO_SLOT:      return "channels busy";
+        case SSH_MUX_NO_MEMORY:    return "no memory";
+        case SSH_MUX_IO_BUSY:      return "SSH busy";
+        case SSH_MUX_REFUSED:      return "refused by server";
+        case SSH_MUX_SESSION_LOST: return "session lost";
+    }
+    return "?";
+}
+
+// Open an exec channel running command. notify (optional) runs on the
+// receive task whenever the channel has news. Returns NULL on failure, with
+// the reason in *result when given.
+static SshMuxChannel* sshMuxOpenExec(const char* command, SshMuxNotify notify = NULL, void* notify_arg = NULL,
+                                     SshMuxOpenResult* result = NULL) {
+    SshMuxOpenResult dummy;
+    if (!result) result = &dummy;
+    *result = SSH_MUX_NO_SESSION;
+    if (!ssh_connected || !ssh_sess || !command) return NULL;
+
+    SshMuxChannel* ch = NULL;
+    portENTER_CRITICAL(&ssh_mux_lock);
+    for (int i = 0; i < SSH_MUX_MAX && !ch; i++) {
+        if (!ssh_mux[i].in_use) {
+            ch = &ssh_mux[i];
+            ch->in_use = true;
+        }
+    }
+    portEXIT_CRITICAL(&ssh_mux_lock);
+    if (!ch) {
+        SERIAL_LOGLN("SSH: no free exec channel");
+        *result = SSH_MUX_NO_SLOT;
+        return NULL;
+    }
+
+    if (!ch->rx.buf) {
+        ch->rx.buf = (uint8_t*)ps_malloc(SSH_MUX_RX_SIZE);
+        ch->tx.buf = (uint8_t*)ps_malloc(SSH_MUX_TX_SIZE);
+        ch->rx.size = SSH_MUX_RX_SIZE;
+        ch->tx.size = SSH_MUX_TX_SIZE;
+    }
+    if (!ch->ready) ch->ready = xSemaphoreCreateBinary();
+    if (!ch->rx.buf || !ch->tx.buf || !ch->ready) {
+        sshMuxRelease(ch);
+        *result = SSH_MUX_NO_MEMORY;
+        return NULL;
+    }
+    ch->rx.head = ch->rx.tail = 0;
+    ch->tx.head = ch->tx.tail = 0;
+    ch->eof_wanted = false;
+    ch->eof_sent = false;
+    ch->remote_eof = false;
+    ch->failed = false;
+    ch->notify = notify;
+    ch->notify_arg = notify_arg;
+    xSemaphoreTake(ch->ready, 0);
+
+    // The open round trips hold the I/O lock; the shell's output waits in
+    // libssh meanwhile.
+    if (!sshIOLock(pdMS_TO_TICKS(SSH_MUX_IO_TIMEOUT_MS))) {
+        sshMuxRelease(ch);
+        *result = SSH_MUX_IO_BUSY;
+        return NULL;
+    }
+    bool ok = false;
+    ssh_channel chan = ssh_sess ? ssh_channel_new(ssh_sess) : NULL;
+    if (!chan) {
+        *result = ssh_sess ? SSH_MUX_NO_MEMORY : SSH_MUX_NO_SESSION;
+    } else if (ssh_channel_open_session(chan) != SSH_OK) {
+        ssh_channel_free(chan);
+        *result = SSH_MUX_REFUSED;
+    } else if (ssh_channel_request_exec(chan, command) != SSH_OK) {
+        ssh_channel_close(chan);
+        ssh_channel_free(chan);
+        *result = SSH_MUX_REFUSED;
+    } else {
+        ch->sess = ssh_sess;
+        ch->chan = chan;
+        ok = true;
+        *result = SSH_MUX_OPENED;
+    }
+    if (*result == SSH_MUX_REFUSED && !ssh_is_connected(ssh_sess)) *result = SSH_MUX_SESSION_LOST;
+    if (!ok) SERIAL_LOGF("SSH: exec open failed (%s): %s\n", sshMuxOpenResultText(*result), ssh_get_error(ssh_sess));
+    sshIOUnlock();
+    if (!ok) {
+        sshMuxRelease(ch);
+        return NULL;
+    }
+    sshWakeReceiver();
+    return ch;
+}
+
+// Read up to len bytes, waiting up to timeout_ms for the first. Returns the
+// count, 0 on timeout, -1 once the remote sent EOF (or the channel failed)
+// and everything before it was read.
+static int sshMuxRead(SshMuxChannel* ch, uint8_t* out, size_t len, uint32_t timeout_ms) {
+    uint32_t start_ms = millis();
+    for (;;) {
+        bool done = ch->remote_eof || ch->failed;   // before the pop: data precedes EOF
+        uint32_t used = sshMuxRingUsed(&ch->rx);
+        uint32_t n = sshMuxRingPop(&ch->rx, out, (uint32_t)len);
+        if (n > 0) {
+            // The owner skips a channel with less than a chunk free.
+            if (used + SSH_MUX_CHUNK > ch->rx.size) sshWakeReceiver();
+            return (int)n;
+        }
+        if (done) return -1;
+        uint32_t waited = millis() - start_ms;
+        if (waited >= timeout_ms) return 0;
+        xSemaphoreTake(ch->ready, pdMS_TO_TICKS(timeout_ms - waited));
+    }
+}
+
+// Queue all len bytes, waiting while the tx ring is full.
+static bool sshMuxWrite(SshMuxChannel* ch, const uint8_t* data, size_t len) {
+    uint32_t progress_ms = millis();
+    while (len > 0) {
+        if (ch->failed || ch->eof_wanted) return false;
+        uint32_t n = sshMuxRingPush(&ch->tx, data, (uint32_t)len);
+        if (n > 0) {
+            data += n;
+            len -= n;
+            progress_ms = millis();
+            sshWakeReceiver();
+            continue;
+        }
+        if (millis() - progress_ms >= SSH_MUX_IO_TIMEOUT_MS) return false;
+        xSemaphoreTake(ch->ready, pdMS_TO_TICKS(100));
+    }
+    return true;
+}
+
+// EOF goes out after everything queued so far.
+static void sshMuxSendEof(SshMuxChannel* ch) {
+    ch->eof_wanted = true;
+    sshWakeReceiver();
+}
+
+// Remote sent EOF (or the channel failed) and all its data has been read.
+static bool sshMuxIsEof(SshMuxChannel* ch) {
+    return (ch->remote_eof || ch->failed) && sshMuxRingUsed(&ch->rx) == 0;
+}
+
+// Flush queued bytes and EOF, close and free the channel. Returns the
+// remote exit status, or -1.
+static int sshMuxClose(SshMuxChannel* ch) {
+    if (!ch) return -1;
+    sshMuxSendEof(ch);
+    uint32_t start_ms = millis();
+    while (ch->chan && !ch->failed && !ch->eof_sent &&
+           millis() - start_ms < SSH_MUX_IO_TIMEOUT_MS) {
+        xSemaphoreTake(ch->ready, pdMS_TO_TICKS(100));
+    }
+    int exit_status = -1;
+    if (sshIOLock(pdMS_TO_TICKS(SSH_MUX_IO_TIMEOUT_MS))) {
+        ssh_channel chan = ch->chan;
+        ch->chan = NULL;
+        if (chan) {
+            ssh_channel_close(chan);
+            exit_status = ssh_channel_get_exit_status(chan);
+            ssh_channel_free(chan);
+        }
+        sshIOUnlock();
+    } else {
+        ch->chan = NULL;  // left to ssh_free with the session
+    }
+    sshMuxRelease(ch);
+    return exit_status;
+}
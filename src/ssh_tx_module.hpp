@@ -0,0 +1,170 @@
+#pragma once
+
+// --- SSH Send Queue ---
+//
+// Keys and strings bound for the interactive channel are queued in
+// ssh_tx_buf and written by the ssh_tx task, so the keyboard loop never
+// waits on ssh_io_mutex or a channel write. The writer sends whatever has
+// accumulated as one ssh_channel_write. Nagle-like: a write that follows
+// the previous one within config_ssh_tx_ms waits out the rest of that
+// window first, so a burst of keys (fast typing, paste) becomes one packet
+// per window, while a key after a pause goes out at once.
+//
+// Input is never dropped: producers block while the queue is full. The key
+// path must not block under state_mutex, so keyQueueDispatch first waits
+// outside the lock for SSH_TX_KEY_ROOM free bytes (sshTxWaitRoom) and leaves
+// the key queued if the room does not come. Queued
+// bytes are only discarded when the session they were meant for goes away
+// (sshTxDiscard on connect, disconnect and session switch); a batch the
+// writer already popped is dropped too, by generation. Producers may run on any task;
+// the ring indices are guarded by ssh_tx_mux, and only the writer pops.
+
+static constexpr uint32_t SSH_TX_SIZE = 4096;        // power of two
+static constexpr uint32_t SSH_TX_BATCH_MAX = 1024;   // bytes per channel write
+static constexpr uint32_t SSH_TX_KEY_ROOM = 512;     // most one key can queue (line edit flush)
+
+static uint8_t  ssh_tx_buf[SSH_TX_SIZE];
+static uint32_t ssh_tx_head = 0;   // free-running
+static uint32_t ssh_tx_tail = 0;   // free-running
+static portMUX_TYPE ssh_tx_mux = portMUX_INITIALIZER_UNLOCKED;
+static TaskHandle_t ssh_tx_task_handle = NULL;
+static uint32_t ssh_tx_last_write_ms = 0;
+static volatile uint32_t ssh_tx_gen = 0;   // bumped by sshTxDiscard
+
+static volatile uint32_t ssh_tx_bytes = 0;    // bytes written since boot
+static volatile uint32_t ssh_tx_writes = 0;   // channel writes since boot
+
+// Queue up to len bytes; returns how many fit.
+static int sshTxPush(const char* data, int len) {
+    portENTER_CRITICAL(&ssh_tx_mux);
+    uint32_t head = ssh_tx_head;
+    uint32_t n = SSH_TX_SIZE - (head - ssh_tx_tail);
+    if ((uint32_t)len < n) n = (uint32_t)len;
+    uint32_t pos = head & (SSH_TX_SIZE - 1);
+    uint32_t first = SSH_TX_SIZE - pos;
+    if (first > n) first = n;
+    memcpy(ssh_tx_buf + pos, data, first);
+    memcpy(ssh_tx_buf, data + first, n - first);
+    ssh_tx_head = head + n;
+    portEXIT_CRITICAL(&ssh_tx_mux);
+    return (int)n;
+}
+
+// Writer: take up to max queued bytes and the generation they belong to.
+static uint32_t sshTxPop(char* out, uint32_t max, uint32_t* gen) {
+    portENTER_CRITICAL(&ssh_tx_mux);
+    *gen = ssh_tx_gen;
+    uint32_t tail = ssh_tx_tail;
+    uint32_t n = ssh_tx_head - tail;
+    if (n > max) n = max;
+    uint32_t pos = tail & (SSH_TX_SIZE - 1);
+    uint32_t first = SSH_TX_SIZE - pos;
+    if (first > n) first = n;
+    memcpy(out, ssh_tx_buf + pos, first);
+    memcpy(out + first, ssh_tx_buf, n - first);
+    ssh_tx_tail = tail + n;
+    portEXIT_CRITICAL(&ssh_tx_mux);
+    return n;
+}
+
+static uint32_t sshTxPending() {
+    portENTER_CRITICAL(&ssh_tx_mux);
+    uint32_t n = ssh_tx_head - ssh_tx_tail;
+    portEXIT_CRITICAL(&ssh_tx_mux);
+    return n;
+}
+
+// Wait up to timeout_ms for room bytes to be free. Returns true if they are
+// (or there is no session to send to).
+static bool sshTxWaitRoom(uint32_t room, uint32_t timeout_ms) {
+    uint32_t start = millis();
+    while (ssh_connected && SSH_TX_SIZE - sshTxPending() < room) {
+        if (millis() - start >= timeout_ms) return false;
+        if (ssh_tx_task_handle) xTaskNotifyGive(ssh_tx_task_handle);
+        vTaskDelay(pdMS_TO_TICKS(2));
+    }
+    return true;
+}
+
+// Forget queued bytes meant for a session that is gone.
+static void sshTxDiscard() {
+    portENTER_CRITICAL(&ssh_tx_mux);
+    ssh_tx_tail = ssh_tx_head;
+    ssh_tx_gen++;
+    portEXIT_CRITICAL(&ssh_tx_mux);
+}
+
+static void sshTxTask(void* param) {
+    (void)param;
+    static char batch[SSH_TX_BATCH_MAX];
+    for (;;) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        while (sshTxPending() > 0) {
+            uint32_t window = config_ssh_tx_ms > 0 ? (uint32_t)config_ssh_tx_ms : 0;
+            uint32_t since = millis() - ssh_tx_last_write_ms;
+            if (since < window) vTaskDelay(pdMS_TO_TICKS(window - since));
+
+            uint32_t gen;
+            uint32_t n = sshTxPop(batch, sizeof(batch), &gen);
+            if (n == 0) break;
+            if (!ssh_connected || !ssh_chan) continue;  // session gone, drop its bytes
+            // Wait for the lock rather than give up: the receive task only
+            // holds it for one non-blocking read.
+            bool locked = false;
+            while (ssh_connected && !locked) locked = sshIOLock(pdMS_TO_TICKS(200));
+            if (!locked) continue;
+            if (gen != ssh_tx_gen) {   // discarded while we waited for the lock
+                sshIOUnlock();
+                continue;
+            }
+            int wrote = ssh_channel_write(ssh_chan, batch, n);
+            sshIOUnlock();
+            sshWakeReceiver();
+            ssh_tx_last_write_ms = millis();
+            if (wrote != (int)n) {
+                SERIAL_LOGF("SSH: write failed (%d/%lu)\n", wrote, (unsigned long)n);
+                continue;
+            }
+            ssh_tx_bytes += n;
+            ssh_tx_writes++;
+        }
+    }
+}
+
+// Queue all len bytes for the interactive channel, waiting while the
+// queue is full.
+static void sshTxQueue(const char* s, int len) {
+    while (len > 0) {
+        int n = sshTxPush(s, len);
+        s += n;
+        len -= n;
+        if (ssh_tx_task_handle) xTaskNotifyGive(ssh_tx_task_handle);
+        if (len > 0) {
+            if (!ssh_connected) return;
+            vTaskDelay(pdMS_TO_TICKS(2));
+        }
+    }
+}
+
+// Escape sequences and pastes move the remote cursor in ways local echo
+// can't follow, so they end the current prediction epoch.
+void sshSendString(const char* s, int len) {
+    if (!ssh_connected || !ssh_chan || !s || len <= 0) return;
+    termLock();
+    termPredBreak();
+    termUnlock();
+    sshTxQueue(s, len);
+}
+
+// Send one key. Returns true if local echo drew it (the caller renders).
+bool sshSendKey(char c) {
+    if (!ssh_connected || !ssh_chan) return false;
+    latKeySent();
+    bool shown = termPredictSent(c);  // before the echo can possibly arrive
+    sshTxQueue(&c, 1);
+    return shown;
+}
+
+void sshTxStart() {
+    xTaskCreatePinnedToCore(sshTxTask, "ssh_tx", 6144, NULL, 1, &ssh_tx_task_handle, 1);
+}
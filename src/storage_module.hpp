@@ -0,0 +1,281 @@
+#pragma once
+
+// Background storage worker: local saves are planned on the loop (a copy of
+// the journal batch or of the flattened document) and written to SD by a
+// dedicated task, so a slow FAT write never stalls keyboard polling. Like
+// every other SD user it runs on core 1, away from the display task that
+// shares the SPI bus.
+
+enum StorageOp : uint8_t {
+    STORAGE_APPEND,    // append a journal batch
+    STORAGE_COMPACT,   // rewrite the base file and drop its journal
+};
+
+struct StorageRequest {
+    StorageOp op;
+    bool write_header;
+    bool report;       // post the outcome to the command result area
+    int len;           // bytes in data
+    int doc_len;       // document length when planned, for the report
+    uint32_t doc_id;   // text_doc_id / text_edit_seq when planned
+    uint32_t edit_seq;
+    char* data;        // owned by the request, freed by the worker
+    char path[96];
+};
+
+static constexpr int STORAGE_QUEUE_LEN = 4;
+static QueueHandle_t storage_queue = NULL;
+
+// Outcomes the worker hands back. jnl_overflow, file_modified and the result
+// area belong to loop(), which applies them under state_mutex
+// (storagePollResults); the worker only touches jnl_write_failed.
+struct StorageOutcome {
+    uint32_t failed;       // writes lost since the last poll
+    uint32_t failed_doc;   // doc_id of the newest lost write
+    bool saved;            // the newest finished write landed
+    uint32_t saved_doc;
+    uint32_t saved_seq;
+    bool report;           // a reporting save finished
+    bool report_ok;
+    int report_len;
+    char report_path[96];
+};
+static StorageOutcome storage_outcome;
+static volatile bool storage_outcome_ready = false;
+static portMUX_TYPE storage_outcome_mux = portMUX_INITIALIZER_UNLOCKED;
+
+// --- Worker ---
+
+// Write one request to SD; returns false when the data did not land.
+static bool storageWrite(StorageRequest& req) {
+    sdAcquire();
+    bool ok;
+    if (req.op == STORAGE_APPEND) {
+        // A failed write leaves the journal behind the document; later
+        // batches would apply to the wrong text, so skip them until the
+        // compaction planned after the failure lands.
+        ok = !jnl_write_failed &&
+             journalWriteBatch(req.path, (const uint8_t*)req.data, req.len, req.write_header);
+    } else {
+        ok = journalWriteBase(req.path, req.data, req.len);
+        if (ok) jnl_write_failed = false;
+    }
+    sdRelease();
+    free(req.data);
+    req.data = nullptr;
+
+    if (!ok) {
+        jnl_write_failed = true;
+        SERIAL_LOGF("Storage: %s %s failed\n", req.op == STORAGE_APPEND ? "append" : "compact", req.path);
+    }
+    return ok;
+}
+
+// Fold one finished request into o. Requests finish in queue order, so a
+// failure drops an earlier success and a later success supersedes both.
+static void storageOutcomeAdd(StorageOutcome& o, const StorageRequest& req, bool ok) {
+    if (ok) {
+        o.saved = true;
+        o.saved_doc = req.doc_id;
+        o.saved_seq = req.edit_seq;
+    } else {
+        o.failed++;
+        o.failed_doc = req.doc_id;
+        o.saved = false;
+    }
+    if (req.report) {
+        o.report = true;
+        o.report_ok = ok;
+        o.report_len = req.doc_len;
+        memcpy(o.report_path, req.path, sizeof(o.report_path));
+    }
+}
+
+// Caller holds state_mutex (or is the only editor writer, e.g. boot). The
+// document is clean once a save of exactly the open text has landed; edits
+// made after it was planned, or a different document, keep their state.
+static void storageApply(const StorageOutcome& o) {
+    if (o.failed > 0) {
+        if (o.failed_doc == text_doc_id) {
+            // The journal no longer matches the document: compact on the next save.
+            jnl_overflow = true;
+            file_modified = true;
+        } else if (!o.report) {
+            cmdSetResult("Save failed (file closed)");
+            requestRender(RENDER_EDITOR);
+        }
+    }
+    if (o.saved && o.saved_doc == text_doc_id && o.saved_seq == text_edit_seq) {
+        file_modified = false;
+    }
+    if (o.report) {
+        if (o.report_ok) cmdSetResult("Saved %s (%d B)", o.report_path, o.report_len);
+        else cmdSetResult("Save failed");
+        requestRender(RENDER_EDITOR);
+    }
+}
+
+static void storagePost(const StorageRequest& req, bool ok) {
+    portENTER_CRITICAL(&storage_outcome_mux);
+    storageOutcomeAdd(storage_outcome, req, ok);
+    storage_outcome_ready = true;
+    portEXIT_CRITICAL(&storage_outcome_mux);
+}
+
+// The request stays in the queue until it is written, so the queue depth
+// doubles as the in-flight count for storageWaitIdle.
+static void storageTask(void* param) {
+    StorageRequest req;
+    for (;;) {
+        if (xQueuePeek(storage_queue, &req, portMAX_DELAY) != pdTRUE) continue;
+        bool ok = storageWrite(req);
+        storagePost(req, ok);
+        xQueueReceive(storage_queue, &req, 0);
+    }
+}
+
+void storageInit() {
+    storage_queue = xQueueCreate(STORAGE_QUEUE_LEN, sizeof(StorageRequest));
+    if (!storage_queue) {
+        SERIAL_LOGLN("Storage: queue create failed");
+        return;
+    }
+    xTaskCreatePinnedToCore(storageTask, "storage", 4096, NULL, 1, NULL, 1);
+}
+
+static int storagePendingCount() {
+    return storage_queue ? (int)uxQueueMessagesWaiting(storage_queue) : 0;
+}
+
+// Block until every queued write has reached SD. Used before anything that
+// reads local files or replaces the journal state (loads, uploads).
+void storageWaitIdle() {
+    while (storagePendingCount() > 0) vTaskDelay(pdMS_TO_TICKS(5));
+}
+
+// loop(): apply what the worker finished. A busy state_mutex leaves it for
+// the next pass.
+void storagePollResults() {
+    if (!storage_outcome_ready) return;
+    if (xSemaphoreTake(state_mutex, pdMS_TO_TICKS(25)) != pdTRUE) return;
+    StorageOutcome o;
+    portENTER_CRITICAL(&storage_outcome_mux);
+    o = storage_outcome;
+    memset(&storage_outcome, 0, sizeof(storage_outcome));
+    storage_outcome_ready = false;
+    portEXIT_CRITICAL(&storage_outcome_mux);
+    storageApply(o);
+    xSemaphoreGive(state_mutex);
+}
+
+// --- Requests (loop only) ---
+
+// Queue a save of the open document to path. With wait unset a full queue
+// is reported as false and nothing changes; otherwise the call blocks until
+// a slot frees up. Without a worker (boot) the write happens inline.
+bool storageRequestSave(const char* path, bool compact, bool report, bool wait) {
+    if (!path || !path[0] || strlen(path) >= sizeof(StorageRequest::path)) {
+        if (report) cmdSetResult("Save failed (bad path)");
+        return false;
+    }
+    bool same_base = jnl_base_path.length() > 0 && jnl_base_path == path;
+    if (!compact && same_base && !jnl_overflow && jnl_pending_len == 0) {
+        // Everything is already on SD, or queued ahead of this point; the
+        // queued save's outcome settles file_modified then.
+        if (storagePendingCount() == 0) file_modified = false;
+        if (report) cmdSetResult("Saved %s (%d B)", path, text_len);
+        return true;
+    }
+    if (storage_queue && !wait && uxQueueSpacesAvailable(storage_queue) == 0) return false;
+
+    // path may point into jnl_base_path, which planning rewrites.
+    StorageRequest req;
+    memset(&req, 0, sizeof(req));
+    strncpy(req.path, path, sizeof(req.path) - 1);
+    path = req.path;
+    bool is_append = false;
+    req.data = journalPlanSave(path, compact, &is_append, &req.write_header, &req.len);
+    if (!req.data) {
+        if (report) cmdSetResult("Save failed (no memory)");
+        return false;
+    }
+    req.op = is_append ? STORAGE_APPEND : STORAGE_COMPACT;
+    req.report = report;
+    req.doc_len = text_len;
+    req.doc_id = text_doc_id;
+    req.edit_seq = text_edit_seq;
+
+    if (!storage_queue) {
+        bool ok = storageWrite(req);
+        StorageOutcome o;
+        memset(&o, 0, sizeof(o));
+        storageOutcomeAdd(o, req, ok);
+        storageApply(o);
+        return ok;
+    }
+    xQueueSend(storage_queue, &req, portMAX_DELAY);
+    if (report) cmdSetResult("Saving %s...", path);
+    return true;
+}
+
+// Append pending edits once typing has paused, so a crash or power loss
+// loses at most the last few seconds. Called from loop(); skipped while the
+// worker is backed up.
+void journalFlushIdle() {
+    if (jnl_pending_len == 0 || jnl_overflow || jnl_base_path.length() == 0) return;
+    if (file_is_remote || !sd_mounted) return;
+    if (millis() - jnl_last_edit_ms < JOURNAL_IDLE_FLUSH_MS) return;
+    storageRequestSave(jnl_base_path.c_str(), false, false, false);
+}
+
+// Fold the open file's journal into its base (before leaving it or uploading).
+void journalFoldCurrent() {
+    if (file_is_remote || !sd_mounted || jnl_base_path.length() == 0) return;
+    if (!journalHasEntries()) return;
+    storageRequestSave(jnl_base_path.c_str(), true, false, true);
+}
+
+bool loadFromFile(const char* path);
+
+// Boot-time crash recovery: fold every journal left in / into its base file.
+// Runs before the storage worker starts.
+void journalRecoverAll() {
+    if (!sd_mounted) return;
+    static constexpr int MAX_RECOVER = 8;
+    char bases[MAX_RECOVER][64];
+    int count = 0;
+
+    sdAcquire();
+    File dir = SD.open("/");
+    if (dir) {
+        File entry = dir.openNextFile();
+        while (entry && count < MAX_RECOVER) {
+            const char* name = entry.name();
+            const char* slash = strrchr(name, '/');
+            if (slash) name = slash + 1;
+            size_t len = strlen(name);
+            bool is_jnl = len > 5 && strcmp(name + len - 4, ".jnl") == 0;
+            bool is_tmp = len > 5 && strcmp(name + len - 4, ".tmp") == 0;
+            if (name[0] == '.' && (is_jnl || is_tmp) && len - 5 < sizeof(bases[0]) - 1) {
+                snprintf(bases[count], sizeof(bases[0]), "/%.*s", (int)(len - 5), name + 1);
+                count++;
+            }
+            entry = dir.openNextFile();
+        }
+        dir.close();
+    }
+    sdRelease();
+
+    for (int i = 0; i < count; i++) {
+        if (!loadFromFile(bases[i])) continue;
+        if (journalHasEntries()) {
+            sdAcquire();
+            journalCompactNow(bases[i]);
+            sdRelease();
+        }
+        SERIAL_LOGF("JNL: recovered %s (%d B)\n", bases[i], text_len);
+    }
+    textClear();
+    current_file = "";
+    file_modified = false;
+}
@@ -0,0 +1,817 @@
+#pragma once
+
+// --- Terminal Buffer Operations ---
+
+static uint8_t termMouseTrackingModeBit(int mode) {
+    switch (mode) {
+        case 1000: return 0x01; // button-event tracking
+        case 1002: return 0x02; // button-motion tracking
+        case 1003: return 0x04; // any-motion tracking
+        default:   return 0x00;
+    }
+}
+
+void terminalClear() {
+    termGridReset(term_main_grid, term_main_rows, TERM_ROWS);
+    termGridReset(term_alt_grid, term_alt_rows, TERM_ROWS);
+    term_grid = &term_main_grid;
+    term_all_dirty = true;
+    term_view_hist = 0;  // scrollback itself is kept
+    term_line_count = 1;
+    term_scroll     = 0;
+    term_cursor_row = 0;
+    term_cursor_col = 0;
+    vt_state = VT_GROUND;
+    vt_collect_count = 0;
+    csi_param_count = 0;
+    csi_param_idx = 0;
+    csi_has_params = false;
+    csi_private = false;
+    term_mouse_tracking_mode_mask = 0;
+    term_mouse_sgr_mode = false;
+    scroll_region_top = 0;
+    scroll_region_bot = ROWS_PER_SCREEN - 1;
+    scroll_region_set = false;
+    term_alt_active = false;
+    cursor_visible = true;
+    term_wrap_pending = false;
+    utf8_remaining = 0;
+    utf8_codepoint = 0;
+    saved_cursor_row = 0;
+    saved_cursor_col = 0;
+    termPredReset();
+}
+
+// Whether rows top..bot sit in consecutive ring slots, so a region scroll
+// can shift their pointers with one memmove.
+static inline bool termRegionContiguous(int top, int bot) {
+    return term_grid->head + bot < TERM_ROWS || term_grid->head + top >= TERM_ROWS;
+}
+
+// Scroll rows top..bot up by one: the top row's storage is recycled as the
+// blank bottom row. The whole grid is a head advance.
+void terminalScrollRegionUp(int top, int bot) {
+    if (top < 0) top = 0;
+    if (bot >= TERM_ROWS) bot = TERM_ROWS - 1;
+    if (top == 0 && bot == TERM_ROWS - 1) {
+        if (term_grid == &term_main_grid) termHistoryPush(termRow(0));
+        term_grid->head = (term_grid->head + 1) % TERM_ROWS;
+    } else if (top < bot) {
+        char* recycled = termRowSlot(top);
+        if (termRegionContiguous(top, bot)) {
+            char** slot = &termRowSlot(top);
+            memmove(slot, slot + 1, (bot - top) * sizeof(char*));
+        } else {
+            for (int i = top; i < bot; i++) termRowSlot(i) = termRowSlot(i + 1);
+        }
+        termRowSlot(bot) = recycled;
+    }
+    memset(termRow(bot), ' ', TERM_COLS);
+    termRow(bot)[TERM_COLS] = '\0';
+    termMarkRows(top, bot);
+    termPredScroll(top, bot, -1);
+}
+
+void terminalScrollRegionDown(int top, int bot) {
+    if (top < 0) top = 0;
+    if (bot >= TERM_ROWS) bot = TERM_ROWS - 1;
+    if (top == 0 && bot == TERM_ROWS - 1) {
+        term_grid->head = (term_grid->head + TERM_ROWS - 1) % TERM_ROWS;
+    } else if (top < bot) {
+        char* recycled = termRowSlot(bot);
+        if (termRegionContiguous(top, bot)) {
+            char** slot = &termRowSlot(top);
+            memmove(slot + 1, slot, (bot - top) * sizeof(char*));
+        } else {
+            for (int i = bot; i > top; i--) termRowSlot(i) = termRowSlot(i - 1);
+        }
+        termRowSlot(top) = recycled;
+    }
+    memset(termRow(top), ' ', TERM_COLS);
+    termRow(top)[TERM_COLS] = '\0';
+    termMarkRows(top, bot);
+    termPredScroll(top, bot, 1);
+}
+
+// Map Unicode codepoint to printable ASCII (box drawing, symbols)
+char unicodeToAscii(uint32_t cp) {
+    // Box drawing: U+2500-U+257F
+    if (cp >= 0x2500 && cp <= 0x257F) {
+        // Horizontal lines
+        if (cp == 0x2500 || cp == 0x2501 || cp == 0x2504 || cp == 0x2505 ||
+            cp == 0x2508 || cp == 0x2509 || cp == 0x254C || cp == 0x254D ||
+            cp == 0x2550) return '-';
+        // Vertical lines
+        if (cp == 0x2502 || cp == 0x2503 || cp == 0x2506 || cp == 0x2507 ||
+            cp == 0x250A || cp == 0x250B || cp == 0x254E || cp == 0x254F ||
+            cp == 0x2551) return '|';
+        // Everything else (corners, tees, crosses)
+        return '+';
+    }
+    // Block elements: U+2580-U+259F
+    if (cp >= 0x2580 && cp <= 0x259F) return '#';
+    // Common symbols
+    if (cp == 0x2713 || cp == 0x2714) return '*';  // checkmarks
+    if (cp == 0x2022 || cp == 0x25CF) return '*';  // bullets
+    if (cp == 0x25CB || cp == 0x25A0 || cp == 0x25A1) return '*';  // circles/squares
+    if (cp == 0x2192) return '>';  // right arrow
+    if (cp == 0x2190) return '<';  // left arrow
+    if (cp == 0x2191) return '^';  // up arrow
+    if (cp == 0x2193) return 'v';  // down arrow
+    if (cp == 0x2026) return '.';  // ellipsis
+    if (cp == 0x2014 || cp == 0x2013) return '-';  // em/en dash
+    if (cp == 0x2018 || cp == 0x2019) return '\''; // smart quotes
+    if (cp == 0x201C || cp == 0x201D) return '"';   // smart double quotes
+    return 0;  // unknown - skip
+}
+
+void enterAltScreen() {
+    if (term_alt_active) return;
+    // Save main screen state; its rows stay untouched in term_main_grid
+    saved_main_cursor_row = term_cursor_row;
+    saved_main_cursor_col = term_cursor_col;
+    saved_main_line_count = term_line_count;
+    saved_main_scroll = term_scroll;
+    // Blank alt screen (only the visible rows are ever used)
+    termGridReset(term_alt_grid, term_alt_rows, ROWS_PER_SCREEN);
+    term_grid = &term_alt_grid;
+    term_view_hist = 0;
+    term_all_dirty = true;
+    term_cursor_row = 0;
+    term_cursor_col = 0;
+    term_line_count = 1;
+    term_scroll = 0;
+    term_wrap_pending = false;
+    scroll_region_top = 0;
+    scroll_region_bot = ROWS_PER_SCREEN - 1;
+    scroll_region_set = false;
+    term_alt_active = true;
+}
+
+void leaveAltScreen() {
+    if (!term_alt_active) return;
+    // Restore main screen
+    term_grid = &term_main_grid;
+    term_all_dirty = true;
+    term_cursor_row = saved_main_cursor_row;
+    term_cursor_col = saved_main_cursor_col;
+    term_line_count = saved_main_line_count;
+    term_scroll = saved_main_scroll;
+    term_wrap_pending = false;
+    scroll_region_top = 0;
+    scroll_region_bot = ROWS_PER_SCREEN - 1;
+    scroll_region_set = false;
+    term_alt_active = false;
+}
+
+void handleCSI(char final_char) {
+    int p0 = (csi_param_count > 0) ? csi_params[0] : 0;
+    int p1 = (csi_param_count > 1) ? csi_params[1] : 0;
+    int max_row = term_alt_active ? ROWS_PER_SCREEN : TERM_ROWS;
+
+    // Formatting-only CSI (SGR) should not consume delayed-wrap state, nor
+    // should EL. While a wrap is pending the cursor is past the last column,
+    // so ED 0 and EL 0 leave that column alone, as tmux and VTE do.
+    bool wrap_was_pending = term_wrap_pending;
+    if (final_char != 'm' && final_char != 'K') term_wrap_pending = false;
+
+    // Handle private mode sequences (CSI ? ...)
+    if (csi_private) {
+        if (final_char == 'h') {
+            // Set mode
+            for (int pi = 0; pi < csi_param_count; pi++) {
+                switch (csi_params[pi]) {
+                    case 1049: // Alt screen + save cursor
+                        saved_cursor_row = term_cursor_row;
+                        saved_cursor_col = term_cursor_col;
+                        enterAltScreen();
+                        break;
+                    case 47:   // Alt screen (no cursor save)
+                    case 1047:
+                        enterAltScreen();
+                        break;
+                    case 25:   // Show cursor
+                        cursor_visible = true;
+                        break;
+                    case 1000:
+                    case 1002:
+                    case 1003:
+                        term_mouse_tracking_mode_mask |= termMouseTrackingModeBit(csi_params[pi]);
+                        break;
+                    case 1006:
+                        term_mouse_sgr_mode = true;
+                        break;
+                }
+            }
+        } else if (final_char == 'l') {
+            // Reset mode
+            for (int pi = 0; pi < csi_param_count; pi++) {
+                switch (csi_params[pi]) {
+                    case 1049: // Leave alt screen + restore cursor
+                        leaveAltScreen();
+                        term_cursor_row = saved_cursor_row;
+                        term_cursor_col = saved_cursor_col;
+                        break;
+                    case 47:
+                    case 1047:
+                        leaveAltScreen();
+                        break;
+                    case 25:   // Hide cursor
+                        cursor_visible = false;
+                        break;
+                    case 1000:
+                    case 1002:
+                    case 1003:
+                        term_mouse_tracking_mode_mask &= (uint8_t)~termMouseTrackingModeBit(csi_params[pi]);
+                        break;
+                    case 1006:
+                        term_mouse_sgr_mode = false;
+                        break;
+                }
+            }
+        }
+        return;
+    }
+
+    switch (final_char) {
+        case 'A': // Cursor Up
+            term_cursor_row -= (p0 > 0) ? p0 : 1;
+            if (term_cursor_row < 0) term_cursor_row = 0;
+            break;
+        case 'B': // Cursor Down
+            term_cursor_row += (p0 > 0) ? p0 : 1;
+            if (term_cursor_row >= max_row) term_cursor_row = max_row - 1;
+            break;
+        case 'C': // Cursor Right
+            term_cursor_col += (p0 > 0) ? p0 : 1;
+            if (term_cursor_col >= TERM_COLS) term_cursor_col = TERM_COLS - 1;
+            break;
+        case 'D': // Cursor Left
+            term_cursor_col -= (p0 > 0) ? p0 : 1;
+            if (term_cursor_col < 0) term_cursor_col = 0;
+            break;
+        case 'E': // Cursor Next Line
+            term_cursor_col = 0;
+            term_cursor_row += (p0 > 0) ? p0 : 1;
+            if (term_cursor_row >= max_row) term_cursor_row = max_row - 1;
+            break;
+        case 'F': // Cursor Previous Line
+            term_cursor_col = 0;
+            term_cursor_row -= (p0 > 0) ? p0 : 1;
+            if (term_cursor_row < 0) term_cursor_row = 0;
+            break;
+        case 'H': // Cursor Position (row;col) — 1-based
+        case 'f': // Same as H
+            term_cursor_row = (p0 > 0) ? p0 - 1 : 0;
+            term_cursor_col = (p1 > 0) ? p1 - 1 : 0;
+            if (term_cursor_row >= max_row) term_cursor_row = max_row - 1;
+            if (term_cursor_col >= TERM_COLS) term_cursor_col = TERM_COLS - 1;
+            if (term_cursor_row >= term_line_count) term_line_count = term_cursor_row + 1;
+            break;
+        case 'J': // Erase in Display
+            if (p0 == 0) {
+                if (!wrap_was_pending) {
+                    memset(&termRow(term_cursor_row)[term_cursor_col], ' ',
+                           TERM_COLS - term_cursor_col);
+                }
+                for (int r = term_cursor_row + 1; r < max_row; r++) {
+                    memset(termRow(r), ' ', TERM_COLS);
+                }
+                termMarkRows(term_cursor_row, max_row - 1);
+            } else if (p0 == 1) {
+                for (int r = 0; r < term_cursor_row; r++) {
+                    memset(termRow(r), ' ', TERM_COLS);
+                }
+                memset(termRow(term_cursor_row), ' ', term_cursor_col + 1);
+                termMarkRows(0, term_cursor_row);
+            } else if (p0 == 2 || p0 == 3) {
+                if (p0 == 3) termHistoryClear();
+                for (int r = 0; r < max_row; r++) {
+                    memset(termRow(r), ' ', TERM_COLS);
+                }
+                termMarkRows(0, max_row - 1);
+                term_cursor_row = 0;
+                term_cursor_col = 0;
+                term_line_count = 1;
+                term_scroll = 0;
+            }
+            break;
+        case 'K': // Erase in Line
+            termMarkRow(term_cursor_row);
+            if (p0 == 0) {
+                if (!wrap_was_pending) {
+                    memset(&termRow(term_cursor_row)[term_cursor_col], ' ',
+                           TERM_COLS - term_cursor_col);
+                }
+            } else if (p0 == 1) {
+                memset(termRow(term_cursor_row), ' ', term_cursor_col + 1);
+            } else if (p0 == 2) {
+                memset(termRow(term_cursor_row), ' ', TERM_COLS);
+            }
+            break;
+        case 'G': // Cursor Horizontal Absolute
+            term_cursor_col = (p0 > 0) ? p0 - 1 : 0;
+            if (term_cursor_col >= TERM_COLS) term_cursor_col = TERM_COLS - 1;
+            break;
+        case 'd': // Cursor Vertical Absolute
+            term_cursor_row = (p0 > 0) ? p0 - 1 : 0;
+            if (term_cursor_row >= max_row) term_cursor_row = max_row - 1;
+            if (term_cursor_row >= term_line_count) term_line_count = term_cursor_row + 1;
+            break;
+        case 'P': { // Delete Characters
+            int n = (p0 > 0) ? p0 : 1;
+            int r = term_cursor_row;
+            int c = term_cursor_col;
+            if (c + n > TERM_COLS) n = TERM_COLS - c;
+            memmove(&termRow(r)[c], &termRow(r)[c + n], TERM_COLS - c - n);
+            memset(&termRow(r)[TERM_COLS - n], ' ', n);
+            termMarkRow(r);
+            break;
+        }
+        case '@': { // Insert Characters
+            int n = (p0 > 0) ? p0 : 1;
+            int r = term_cursor_row;
+            int c = term_cursor_col;
+            if (c + n > TERM_COLS) n = TERM_COLS - c;
+            memmove(&termRow(r)[c + n], &termRow(r)[c], TERM_COLS - c - n);
+            memset(&termRow(r)[c], ' ', n);
+            termMarkRow(r);
+            break;
+        }
+        case 'X': { // Erase Characters (overwrite with spaces, don't move cursor)
+            int n = (p0 > 0) ? p0 : 1;
+            int c = term_cursor_col;
+            if (c + n > TERM_COLS) n = TERM_COLS - c;
+            memset(&termRow(term_cursor_row)[c], ' ', n);
+            termMarkRow(term_cursor_row);
+            break;
+        }
+        case 'L': { // Insert Lines (within scroll region)
+            int n = (p0 > 0) ? p0 : 1;
+            int bot = (term_alt_active || scroll_region_set) ? scroll_region_bot : max_row - 1;
+            if (term_cursor_row > bot) break;
+            if (n > bot - term_cursor_row + 1) n = bot - term_cursor_row + 1;
+            for (int j = 0; j < n; j++) terminalScrollRegionDown(term_cursor_row, bot);
+            break;
+        }
+        case 'M': { // Delete Lines (within scroll region)
+            int n = (p0 > 0) ? p0 : 1;
+            int bot = (term_alt_active || scroll_region_set) ? scroll_region_bot : max_row - 1;
+            if (term_cursor_row > bot) break;
+            if (n > bot - term_cursor_row + 1) n = bot - term_cursor_row + 1;
+            for (int j = 0; j < n; j++) terminalScrollRegionUp(term_cursor_row, bot);
+            break;
+        }
+        case 'S': { // Scroll Up (within scroll region)
+            int n = (p0 > 0) ? p0 : 1;
+            for (int j = 0; j < n; j++)
+                terminalScrollRegionUp(scroll_region_top, scroll_region_bot);
+            break;
+        }
+        case 'T': { // Scroll Down (within scroll region)
+            int n = (p0 > 0) ? p0 : 1;
+            for (int j = 0; j < n; j++)
+                terminalScrollRegionDown(scroll_region_top, scroll_region_bot);
+            break;
+        }
+        case 'r': { // Set Scroll Region (top;bottom, 1-based)
+            if (p0 == 0 && p1 == 0) {
+                // Reset scroll region
+                scroll_region_top = 0;
+                scroll_region_bot = ROWS_PER_SCREEN - 1;
+                scroll_region_set = false;
+            } else {
+                scroll_region_top = (p0 > 0) ? p0 - 1 : 0;
+                scroll_region_bot = (p1 > 0) ? p1 - 1 : ROWS_PER_SCREEN - 1;
+                if (scroll_region_top < 0) scroll_region_top = 0;
+                if (scroll_region_bot >= ROWS_PER_SCREEN) scroll_region_bot = ROWS_PER_SCREEN - 1;
+                if (scroll_region_top >= scroll_region_bot) {
+                    scroll_region_top = 0;
+                    scroll_region_bot = ROWS_PER_SCREEN - 1;
+                }
+                scroll_region_set = true;
+            }
+            term_cursor_row = 0;
+            term_cursor_col = 0;
+            break;
+        }
+        case 's': // Save cursor position
+            saved_cursor_row = term_cursor_row;
+            saved_cursor_col = term_cursor_col;
+            break;
+        case 'u': // Restore cursor position
+            term_cursor_row = saved_cursor_row;
+            term_cursor_col = saved_cursor_col;
+            break;
+        case 'h': // Set mode (non-private)
+        case 'l': // Reset mode (non-private)
+            break;  // ignore standard modes
+        default:
+            break;
+    }
+}
+
+// Handle cursor moving past bottom of scroll region or screen
+void terminalCursorDown() {
+    if (term_alt_active || scroll_region_set) {
+        // Screen-bounded mode: scroll region
+        if (term_cursor_row == scroll_region_bot) {
+            terminalScrollRegionUp(scroll_region_top, scroll_region_bot);
+        } else if (term_cursor_row < scroll_region_bot) {
+            term_cursor_row++;
+        }
+    } else {
+        // Main screen: scrollback mode
+        term_cursor_row++;
+        if (term_cursor_row >= TERM_ROWS) {
+            terminalScrollRegionUp(0, TERM_ROWS - 1);
+            term_cursor_row = TERM_ROWS - 1;
+        }
+        if (term_cursor_row >= term_line_count) {
+            term_line_count = term_cursor_row + 1;
+        }
+    }
+}
+
+void terminalPutChar(char ch) {
+    if (term_wrap_pending) {
+        term_cursor_col = 0;
+        terminalCursorDown();
+        term_wrap_pending = false;
+    }
+
+    termRow(term_cursor_row)[term_cursor_col] = ch;
+    termMarkRow(term_cursor_row);
+    if (term_cursor_col >= TERM_COLS - 1) {
+        term_wrap_pending = true;
+    } else {
+        term_cursor_col++;
+    }
+}
+
+// Length of the printable ASCII (0x20..0x7E) run at the start of p. After
+// aligning, four bytes are tested per step: a word is clean when no byte is
+// below 0x20 and none is 0x7F or above.
+static int terminalPrintableRun(const unsigned char* p, int len) {
+    int n = 0;
+    while (n < len && ((uintptr_t)(p + n) & 3) != 0) {
+        if (p[n] < ' ' || p[n] > '~') return n;
+        n++;
+    }
+    while (n + 4 <= len) {
+        uint32_t w;
+        memcpy(&w, __builtin_assume_aligned(p + n, 4), 4);
+        uint32_t below = (w - 0x20202020U) & ~w & 0x80808080U;
+        uint32_t above = (w | (w + 0x01010101U)) & 0x80808080U;
+        if (below | above) break;
+        n += 4;
+    }
+    while (n < len && p[n] >= ' ' && p[n] <= '~') n++;
+    return n;
+}
+
+// Write a run of printable chars with the same wrap rules as
+// terminalPutChar, one memcpy per row segment.
+static void terminalPutRun(const char* s, int n) {
+    while (n > 0) {
+        if (term_wrap_pending) {
+            term_cursor_col = 0;
+            terminalCursorDown();
+            term_wrap_pending = false;
+        }
+        int chunk = TERM_COLS - term_cursor_col;
+        if (chunk > n) chunk = n;
+        memcpy(&termRow(term_cursor_row)[term_cursor_col], s, chunk);
+        termMarkRow(term_cursor_row);
+        term_cursor_col += chunk;
+        if (term_cursor_col >= TERM_COLS) {
+            term_cursor_col = TERM_COLS - 1;
+            term_wrap_pending = true;
+        }
+        s += chunk;
+        n -= chunk;
+    }
+}
+
+// --- Escape Parser ---
+//
+// Table-driven DEC/ANSI parser after the VT500 state diagram. Each byte is
+// reduced to a class, and vt_table[state][class] gives the action and the
+// next state. All state is kept between calls, so sequences may be split
+// across SSH reads at any byte. OSC, DCS and SOS/PM/APC strings are consumed
+// and ignored. Bytes >= 0x80 are UTF-8 in the ground state.
+
+enum VtClass : uint8_t {
+    VC_C0,        // 0x00-0x17, 0x19, 0x1C-0x1F (except BEL)
+    VC_BEL,       // 0x07
+    VC_CANSUB,    // 0x18, 0x1A
+    VC_ESC,       // 0x1B
+    VC_INTER,     // 0x20-0x2F
+    VC_DIGIT,     // 0x30-0x39
+    VC_COLON,     // 0x3A
+    VC_SEMI,      // 0x3B
+    VC_MARKER,    // 0x3C-0x3F
+    VC_DCS,       // 'P'
+    VC_CSI,       // '['
+    VC_OSC,       // ']'
+    VC_SOS,       // 'X', '^', '_'
+    VC_FINAL,     // other 0x40-0x7E
+    VC_DEL,       // 0x7F
+    VC_HIGH,      // 0x80-0xFF
+    VC_COUNT,
+};
+
+enum VtAction : uint8_t {
+    VA_NONE,
+    VA_PRINT,
+    VA_EXECUTE,
+    VA_CLEAR,
+    VA_COLLECT,
+    VA_PARAM,
+    VA_ESC_DISPATCH,
+    VA_CSI_DISPATCH,
+};
+
+static inline uint8_t vtByteClass(uint8_t c) {
+    if (c >= 0x80) return VC_HIGH;
+    if (c >= 0x40) {
+        if (c == 0x7F) return VC_DEL;
+        if (c == '[') return VC_CSI;
+        if (c == ']') return VC_OSC;
+        if (c == 'P') return VC_DCS;
+        if (c == 'X' || c == '^' || c == '_') return VC_SOS;
+        return VC_FINAL;
+    }
+    if (c >= 0x3C) return VC_MARKER;
+    if (c == 0x3B) return VC_SEMI;
+    if (c == 0x3A) return VC_COLON;
+    if (c >= 0x30) return VC_DIGIT;
+    if (c >= 0x20) return VC_INTER;
+    if (c == 0x1B) return VC_ESC;
+    if (c == 0x18 || c == 0x1A) return VC_CANSUB;
+    if (c == 0x07) return VC_BEL;
+    return VC_C0;
+}
+
+#define VT(action, state) (uint8_t)(((action) << 4) | (state))
+#define VT_STRING_ROW(self) { \
+    VT(VA_NONE, self), VT(VA_NONE, self), VT(VA_NONE, VT_GROUND), VT(VA_CLEAR, VT_ESCAPE), \
+    VT(VA_NONE, self), VT(VA_NONE, self), VT(VA_NONE, self), VT(VA_NONE, self), \
+    VT(VA_NONE, self), VT(VA_NONE, self), VT(VA_NONE, self), VT(VA_NONE, self), \
+    VT(VA_NONE, self), VT(VA_NONE, self), VT(VA_NONE, self), VT(VA_NONE, self) }
+
+static const uint8_t vt_table[VT_STATE_COUNT][VC_COUNT] = {
+    // C0 BEL CAN/SUB ESC | INTER DIGIT COLON SEMI | MARKER DCS CSI OSC | SOS FINAL DEL HIGH
+    /* VT_GROUND */ {
+        VT(VA_EXECUTE, VT_GROUND), VT(VA_EXECUTE, VT_GROUND), VT(VA_NONE, VT_GROUND), VT(VA_CLEAR, VT_ESCAPE),
+        VT(VA_PRINT, VT_GROUND), VT(VA_PRINT, VT_GROUND), VT(VA_PRINT, VT_GROUND), VT(VA_PRINT, VT_GROUND),
+        VT(VA_PRINT, VT_GROUND), VT(VA_PRINT, VT_GROUND), VT(VA_PRINT, VT_GROUND), VT(VA_PRINT, VT_GROUND),
+        VT(VA_PRINT, VT_GROUND), VT(VA_PRINT, VT_GROUND), VT(VA_EXECUTE, VT_GROUND), VT(VA_PRINT, VT_GROUND) },
+    /* VT_ESCAPE */ {
+        VT(VA_EXECUTE, VT_ESCAPE), VT(VA_EXECUTE, VT_ESCAPE), VT(VA_NONE, VT_GROUND), VT(VA_CLEAR, VT_ESCAPE),
+        VT(VA_COLLECT, VT_ESCAPE_INTER), VT(VA_ESC_DISPATCH, VT_GROUND), VT(VA_ESC_DISPATCH, VT_GROUND), VT(VA_ESC_DISPATCH, VT_GROUND),
+        VT(VA_ESC_DISPATCH, VT_GROUND), VT(VA_CLEAR, VT_DCS_ENTRY), VT(VA_CLEAR, VT_CSI_ENTRY), VT(VA_NONE, VT_OSC_STRING),
+        VT(VA_NONE, VT_SOS_STRING), VT(VA_ESC_DISPATCH, VT_GROUND), VT(VA_NONE, VT_ESCAPE), VT(VA_NONE, VT_ESCAPE) },
+    /* VT_ESCAPE_INTER */ {
+        VT(VA_EXECUTE, VT_ESCAPE_INTER), VT(VA_EXECUTE, VT_ESCAPE_INTER), VT(VA_NONE, VT_GROUND), VT(VA_CLEAR, VT_ESCAPE),
+        VT(VA_COLLECT, VT_ESCAPE_INTER), VT(VA_ESC_DISPATCH, VT_GROUND), VT(VA_ESC_DISPATCH, VT_GROUND), VT(VA_ESC_DISPATCH, VT_GROUND),
+        VT(VA_ESC_DISPATCH, VT_GROUND), VT(VA_ESC_DISPATCH, VT_GROUND), VT(VA_ESC_DISPATCH, VT_GROUND), VT(VA_ESC_DISPATCH, VT_GROUND),
+        VT(VA_ESC_DISPATCH, VT_GROUND), VT(VA_ESC_DISPATCH, VT_GROUND), VT(VA_NONE, VT_ESCAPE_INTER), VT(VA_NONE, VT_ESCAPE_INTER) },
+    /* VT_CSI_ENTRY */ {
+        VT(VA_EXECUTE, VT_CSI_ENTRY), VT(VA_EXECUTE, VT_CSI_ENTRY), VT(VA_NONE, VT_GROUND), VT(VA_CLEAR, VT_ESCAPE),
+        VT(VA_COLLECT, VT_CSI_INTER), VT(VA_PARAM, VT_CSI_PARAM), VT(VA_NONE, VT_CSI_IGNORE), VT(VA_PARAM, VT_CSI_PARAM),
+        VT(VA_COLLECT, VT_CSI_PARAM), VT(VA_CSI_DISPATCH, VT_GROUND), VT(VA_CSI_DISPATCH, VT_GROUND), VT(VA_CSI_DISPATCH, VT_GROUND),
+        VT(VA_CSI_DISPATCH, VT_GROUND), VT(VA_CSI_DISPATCH, VT_GROUND), VT(VA_NONE, VT_CSI_ENTRY), VT(VA_NONE, VT_CSI_ENTRY) },
+    /* VT_CSI_PARAM */ {
+        VT(VA_EXECUTE, VT_CSI_PARAM), VT(VA_EXECUTE, VT_CSI_PARAM), VT(VA_NONE, VT_GROUND), VT(VA_CLEAR, VT_ESCAPE),
+        VT(VA_COLLECT, VT_CSI_INTER), VT(VA_PARAM, VT_CSI_PARAM), VT(VA_NONE, VT_CSI_IGNORE), VT(VA_PARAM, VT_CSI_PARAM),
+        VT(VA_NONE, VT_CSI_IGNORE), VT(VA_CSI_DISPATCH, VT_GROUND), VT(VA_CSI_DISPATCH, VT_GROUND), VT(VA_CSI_DISPATCH, VT_GROUND),
+        VT(VA_CSI_DISPATCH, VT_GROUND), VT(VA_CSI_DISPATCH, VT_GROUND), VT(VA_NONE, VT_CSI_PARAM), VT(VA_NONE, VT_CSI_PARAM) },
+    /* VT_CSI_INTER */ {
+        VT(VA_EXECUTE, VT_CSI_INTER), VT(VA_EXECUTE, VT_CSI_INTER), VT(VA_NONE, VT_GROUND), VT(VA_CLEAR, VT_ESCAPE),
+        VT(VA_COLLECT, VT_CSI_INTER), VT(VA_NONE, VT_CSI_IGNORE), VT(VA_NONE, VT_CSI_IGNORE), VT(VA_NONE, VT_CSI_IGNORE),
+        VT(VA_NONE, VT_CSI_IGNORE), VT(VA_CSI_DISPATCH, VT_GROUND), VT(VA_CSI_DISPATCH, VT_GROUND), VT(VA_CSI_DISPATCH, VT_GROUND),
+        VT(VA_CSI_DISPATCH, VT_GROUND), VT(VA_CSI_DISPATCH, VT_GROUND), VT(VA_NONE, VT_CSI_INTER), VT(VA_NONE, VT_CSI_INTER) },
+    /* VT_CSI_IGNORE */ {
+        VT(VA_EXECUTE, VT_CSI_IGNORE), VT(VA_EXECUTE, VT_CSI_IGNORE), VT(VA_NONE, VT_GROUND), VT(VA_CLEAR, VT_ESCAPE),
+        VT(VA_NONE, VT_CSI_IGNORE), VT(VA_NONE, VT_CSI_IGNORE), VT(VA_NONE, VT_CSI_IGNORE), VT(VA_NONE, VT_CSI_IGNORE),
+        VT(VA_NONE, VT_CSI_IGNORE), VT(VA_NONE, VT_GROUND), VT(VA_NONE, VT_GROUND), VT(VA_NONE, VT_GROUND),
+        VT(VA_NONE, VT_GROUND), VT(VA_NONE, VT_GROUND), VT(VA_NONE, VT_CSI_IGNORE), VT(VA_NONE, VT_CSI_IGNORE) },
+    /* VT_OSC_STRING: BEL or ST ends it */ {
+        VT(VA_NONE, VT_OSC_STRING), VT(VA_NONE, VT_GROUND), VT(VA_NONE, VT_GROUND), VT(VA_CLEAR, VT_ESCAPE),
+        VT(VA_NONE, VT_OSC_STRING), VT(VA_NONE, VT_OSC_STRING), VT(VA_NONE, VT_OSC_STRING), VT(VA_NONE, VT_OSC_STRING),
+        VT(VA_NONE, VT_OSC_STRING), VT(VA_NONE, VT_OSC_STRING), VT(VA_NONE, VT_OSC_STRING), VT(VA_NONE, VT_OSC_STRING),
+        VT(VA_NONE, VT_OSC_STRING), VT(VA_NONE, VT_OSC_STRING), VT(VA_NONE, VT_OSC_STRING), VT(VA_NONE, VT_OSC_STRING) },
+    /* VT_DCS_ENTRY (DCS params are not used, only skipped) */ {
+        VT(VA_NONE, VT_DCS_ENTRY), VT(VA_NONE, VT_DCS_ENTRY), VT(VA_NONE, VT_GROUND), VT(VA_CLEAR, VT_ESCAPE),
+        VT(VA_NONE, VT_DCS_INTER), VT(VA_NONE, VT_DCS_PARAM), VT(VA_NONE, VT_DCS_IGNORE), VT(VA_NONE, VT_DCS_PARAM),
+        VT(VA_NONE, VT_DCS_PARAM), VT(VA_NONE, VT_DCS_PASS), VT(VA_NONE, VT_DCS_PASS), VT(VA_NONE, VT_DCS_PASS),
+        VT(VA_NONE, VT_DCS_PASS), VT(VA_NONE, VT_DCS_PASS), VT(VA_NONE, VT_DCS_ENTRY), VT(VA_NONE, VT_DCS_ENTRY) },
+    /* VT_DCS_PARAM */ {
+        VT(VA_NONE, VT_DCS_PARAM), VT(VA_NONE, VT_DCS_PARAM), VT(VA_NONE, VT_GROUND), VT(VA_CLEAR, VT_ESCAPE),
+        VT(VA_NONE, VT_DCS_INTER), VT(VA_NONE, VT_DCS_PARAM), VT(VA_NONE, VT_DCS_IGNORE), VT(VA_NONE, VT_DCS_PARAM),
+        VT(VA_NONE, VT_DCS_IGNORE), VT(VA_NONE, VT_DCS_PASS), VT(VA_NONE, VT_DCS_PASS), VT(VA_NONE, VT_DCS_PASS),
+        VT(VA_NONE, VT_DCS_PASS), VT(VA_NONE, VT_DCS_PASS), VT(VA_NONE, VT_DCS_PARAM), VT(VA_NONE, VT_DCS_PARAM) },
+    /* VT_DCS_INTER */ {
+        VT(VA_NONE, VT_DCS_INTER), VT(VA_NONE, VT_DCS_INTER), VT(VA_NONE, VT_GROUND), VT(VA_CLEAR, VT_ESCAPE),
+        VT(VA_NONE, VT_DCS_INTER), VT(VA_NONE, VT_DCS_IGNORE), VT(VA_NONE, VT_DCS_IGNORE), VT(VA_NONE, VT_DCS_IGNORE),
+        VT(VA_NONE, VT_DCS_IGNORE), VT(VA_NONE, VT_DCS_PASS), VT(VA_NONE, VT_DCS_PASS), VT(VA_NONE, VT_DCS_PASS),
+        VT(VA_NONE, VT_DCS_PASS), VT(VA_NONE, VT_DCS_PASS), VT(VA_NONE, VT_DCS_INTER), VT(VA_NONE, VT_DCS_INTER) },
+    /* VT_DCS_PASS */ VT_STRING_ROW(VT_DCS_PASS),
+    /* VT_DCS_IGNORE */ VT_STRING_ROW(VT_DCS_IGNORE),
+    /* VT_SOS_STRING */ VT_STRING_ROW(VT_SOS_STRING),
+};
+
+#undef VT_STRING_ROW
+#undef VT
+
+// C0 controls (and DEL, which this terminal has always treated as backspace).
+static void terminalExecute(uint8_t c) {
+    switch (c) {
+        case '\n':
+        case 0x0B:  // VT
+        case 0x0C:  // FF
+            term_wrap_pending = false;
+            term_cursor_col = 0;
+            terminalCursorDown();
+            break;
+        case '\r':
+            term_wrap_pending = false;
+            term_cursor_col = 0;
+            break;
+        case '\b':
+        case 0x7F:
+            if (term_wrap_pending) term_wrap_pending = false;
+            if (term_cursor_col > 0) {
+                term_cursor_col--;
+                termRow(term_cursor_row)[term_cursor_col] = ' ';
+                termMarkRow(term_cursor_row);
+            }
+            break;
+        case '\t': {
+            if (term_wrap_pending) term_wrap_pending = false;
+            int next_tab = (term_cursor_col + 8) & ~7;
+            if (next_tab > TERM_COLS) next_tab = TERM_COLS;
+            termMarkRow(term_cursor_row);
+            while (term_cursor_col < next_tab) {
+                termRow(term_cursor_row)[term_cursor_col] = ' ';
+                term_cursor_col++;
+            }
+            if (term_cursor_col >= TERM_COLS) {
+                term_cursor_col = 0;
+                terminalCursorDown();
+            }
+            break;
+        }
+        default:
+            break;  // BEL and other controls are ignored
+    }
+}
+
+// Printable ASCII, or one byte of a UTF-8 sequence.
+static void terminalPrint(uint8_t c) {
+    if (c < 0x80) {
+        utf8_remaining = 0;
+        terminalPutChar((char)c);
+        return;
+    }
+    if (utf8_remaining > 0 && (c & 0xC0) == 0x80) {
+        utf8_codepoint = (utf8_codepoint << 6) | (c & 0x3F);
+        if (--utf8_remaining == 0) {
+            char mapped = unicodeToAscii(utf8_codepoint);
+            if (mapped) terminalPutChar(mapped);
+            // else skip unknown/zero-width characters
+        }
+        return;
+    }
+    if ((c & 0xE0) == 0xC0) {
+        utf8_codepoint = c & 0x1F;
+        utf8_remaining = 1;
+    } else if ((c & 0xF0) == 0xE0) {
+        utf8_codepoint = c & 0x0F;
+        utf8_remaining = 2;
+    } else if ((c & 0xF8) == 0xF0) {
+        utf8_codepoint = c & 0x07;
+        utf8_remaining = 3;
+    } else {
+        utf8_remaining = 0;  // stray continuation / invalid byte: ignore
+    }
+}
+
+static void terminalEscDispatch(uint8_t c) {
+    if (vt_collect_count > 0) return;  // charset designation (ESC ( B) etc.: ignored
+    switch (c) {
+        case 'M': // Reverse Index — cursor up, scroll region down if at top
+            term_wrap_pending = false;
+            if (term_cursor_row == scroll_region_top) {
+                terminalScrollRegionDown(scroll_region_top, scroll_region_bot);
+            } else if (term_cursor_row > 0) {
+                term_cursor_row--;
+            }
+            break;
+        case 'D': // Index — cursor down, scroll region up if at bottom
+            term_wrap_pending = false;
+            if (term_cursor_row == scroll_region_bot) {
+                terminalScrollRegionUp(scroll_region_top, scroll_region_bot);
+            } else {
+                terminalCursorDown();
+            }
+            break;
+        case 'E': // Next Line — cursor to start of next line
+            term_wrap_pending = false;
+            term_cursor_col = 0;
+            terminalCursorDown();
+            break;
+        case '7': // Save cursor
+            saved_cursor_row = term_cursor_row;
+            saved_cursor_col = term_cursor_col;
+            break;
+        case '8': // Restore cursor
+            term_wrap_pending = false;
+            term_cursor_row = saved_cursor_row;
+            term_cursor_col = saved_cursor_col;
+            break;
+        case 'c': // Full reset
+            term_wrap_pending = false;
+            terminalClear();
+            break;
+        default:
+            break; // ignore unknown ESC sequences (and ST, ESC \)
+    }
+}
+
+static void terminalParserAction(uint8_t action, uint8_t c) {
+    switch (action) {
+        case VA_PRINT:
+            terminalPrint(c);
+            break;
+        case VA_EXECUTE:
+            terminalExecute(c);
+            break;
+        case VA_CLEAR:
+            vt_collect_count = 0;
+            csi_param_idx = 0;
+            csi_has_params = false;
+            memset(csi_params, 0, sizeof(csi_params));
+            break;
+        case VA_COLLECT:
+            if (vt_collect_count == 0) vt_collect = c;
+            if (vt_collect_count < 255) vt_collect_count++;
+            break;
+        case VA_PARAM:
+            csi_has_params = true;
+            if (c == ';') {
+                if (csi_param_idx < MAX_CSI_PARAMS) csi_param_idx++;
+            } else if (csi_param_idx < MAX_CSI_PARAMS) {
+                int v = csi_params[csi_param_idx] * 10 + (c - '0');
+                csi_params[csi_param_idx] = v > CSI_PARAM_MAX ? CSI_PARAM_MAX : v;
+            }
+            break;
+        case VA_ESC_DISPATCH:
+            terminalEscDispatch(c);
+            break;
+        case VA_CSI_DISPATCH:
+            // Plain or '?' sequences only; other markers (>, =, <) and
+            // intermediates (CSI ! p, CSI SP q) are not implemented.
+            if (vt_collect_count > 1 || (vt_collect_count == 1 && vt_collect != '?')) break;
+            csi_private = vt_collect_count == 1;
+            csi_param_count = !csi_has_params ? 0
+                : (csi_param_idx < MAX_CSI_PARAMS ? csi_param_idx + 1 : MAX_CSI_PARAMS);
+            handleCSI((char)c);
+            break;
+        default:
+            break;
+    }
+}
+
+void terminalAppendOutput(const char* data, int len) {
+    const unsigned char* bytes = (const unsigned char*)data;
+    for (int i = 0; i < len; i++) {
+        unsigned char c = bytes[i];
+
+        // Fast path: plain text in the ground state
+        if (c >= ' ' && c <= '~' && vt_state == VT_GROUND && utf8_remaining == 0) {
+            int run = terminalPrintableRun(bytes + i, len - i);
+            for (int k = 0; k < run; k++) terminalDebugTraceRecord(bytes[i + k]);
+            terminalPutRun(data + i, run);
+            i += run - 1;
+            continue;
+        }
+        terminalDebugTraceRecord(c);
+
+        // An unfinished UTF-8 sequence is dropped by any non-continuation byte.
+        if (utf8_remaining > 0 && (c & 0xC0) != 0x80) utf8_remaining = 0;
+
+        uint8_t t = vt_table[vt_state][vtByteClass(c)];
+        vt_state = t & 0x0F;
+        terminalParserAction(t >> 4, c);
+    }
+
+    // Auto-scroll to keep cursor visible
+    if (term_cursor_row >= term_scroll + ROWS_PER_SCREEN) {
+        term_scroll = term_cursor_row - ROWS_PER_SCREEN + 1;
+    }
+    if (term_cursor_row < term_scroll) {
+        term_scroll = term_cursor_row;
+    }
+}
@@ -0,0 +1,157 @@
+#pragma once
+
+// --- Local Line Edit ---
+//
+// Optional line-buffered terminal input for slow links (`le` toggles it).
+// The command line is edited on the device and drawn in a band on the
+// bottom terminal row; the grid shifts up a row when the remote cursor
+// would sit under the band. Enter sends the whole line plus CR as one
+// write, so a command costs one packet and one echo frame instead of one
+// per character.
+//
+// The editor steps aside while the remote runs a full-screen or raw-mode
+// app (alt screen or mouse tracking) and keys go straight to the channel
+// again. Keys the editor does not own (Tab, Esc, Ctrl-*) first send the
+// buffered text without CR, then the key, so shell completion and Ctrl-C
+// keep working; the remote then holds that prefix, and Backspace on an
+// empty local line is passed through to edit it.
+//
+// Line state is under term_mutex (the display snapshot reads it). Sends
+// happen after the lock is dropped: sshSendString takes term_mutex itself.
+
+static constexpr int TERM_LINE_MAX = 255;
+static constexpr int TERM_LINE_HISTORY = 16;
+static constexpr int TERM_LINE_PREFIX = 2;   // "> " before the text in the band
+static_assert(TERM_LINE_MAX + 1 <= (int)SSH_TX_KEY_ROOM, "one key's flush fits the key room");
+
+static bool term_line_enabled = false;
+static char term_line_buf[TERM_LINE_MAX + 1];
+static int  term_line_len = 0;
+static int  term_line_cur = 0;
+static bool term_line_dirty = true;   // band needs recopying into the snapshot
+
+static char term_line_hist[TERM_LINE_HISTORY][TERM_LINE_MAX + 1];
+static int  term_line_hist_count = 0;
+static int  term_line_hist_head = 0;      // next slot to write
+static int  term_line_hist_browse = -1;   // entries back from newest, -1 = editing
+
+// Caller holds term_mutex.
+static bool termLineActive() {
+    return term_line_enabled && ssh_connected && !term_alt_active &&
+           term_mouse_tracking_mode_mask == 0;
+}
+
+static void termLineSet(const char* s) {
+    strncpy(term_line_buf, s, TERM_LINE_MAX);
+    term_line_buf[TERM_LINE_MAX] = '\0';
+    term_line_len = (int)strlen(term_line_buf);
+    term_line_cur = term_line_len;
+    term_line_dirty = true;
+}
+
+static void termLineClear() {
+    term_line_len = 0;
+    term_line_cur = 0;
+    term_line_buf[0] = '\0';
+    term_line_hist_browse = -1;
+    term_line_dirty = true;
+}
+
+static void termLineHistoryAdd() {
+    if (term_line_len == 0) return;
+    int newest = (term_line_hist_head + TERM_LINE_HISTORY - 1) % TERM_LINE_HISTORY;
+    if (term_line_hist_count > 0 && strcmp(term_line_hist[newest], term_line_buf) == 0) return;
+    memcpy(term_line_hist[term_line_hist_head], term_line_buf, term_line_len + 1);
+    term_line_hist_head = (term_line_hist_head + 1) % TERM_LINE_HISTORY;
+    if (term_line_hist_count < TERM_LINE_HISTORY) term_line_hist_count++;
+}
+
+// direction -1 = older, +1 = newer.
+static void termLineHistoryBrowse(int direction) {
+    int next = term_line_hist_browse - direction;
+    if (next >= term_line_hist_count) return;
+    if (next < 0) {
+        term_line_hist_browse = -1;
+        termLineSet("");
+        return;
+    }
+    term_line_hist_browse = next;
+    int slot = (term_line_hist_head + TERM_LINE_HISTORY - 1 - next) % TERM_LINE_HISTORY;
+    termLineSet(term_line_hist[slot]);
+}
+
+// Apply one key; fills out/out_len with bytes to send. Caller holds term_mutex.
+static void termLineApplyKey(char c, char* out, int* out_len) {
+    *out_len = 0;
+    if (c >= ' ' && c <= '~') {
+        if (term_line_len >= TERM_LINE_MAX) return;
+        memmove(term_line_buf + term_line_cur + 1, term_line_buf + term_line_cur,
+                term_line_len - term_line_cur + 1);
+        term_line_buf[term_line_cur++] = c;
+        term_line_len++;
+    } else if (c == 0x7F) {
+        if (term_line_len == 0) {
+            out[(*out_len)++] = 0x7F;  // edits what the remote already holds
+            return;
+        }
+        if (term_line_cur == 0) return;
+        memmove(term_line_buf + term_line_cur - 1, term_line_buf + term_line_cur,
+                term_line_len - term_line_cur + 1);
+        term_line_cur--;
+        term_line_len--;
+    } else {
+        // Enter sends the line; any other key flushes it and follows it.
+        if (c == '\r') termLineHistoryAdd();
+        memcpy(out, term_line_buf, term_line_len);
+        *out_len = term_line_len;
+        out[(*out_len)++] = c;
+        termLineClear();
+        return;
+    }
+    term_line_hist_browse = -1;
+    term_line_dirty = true;
+}
+
+// Key path: returns false when line edit is inactive (the caller sends the
+// key as usual), true when the editor took it.
+static bool termLineKey(char c) {
+    static char out[TERM_LINE_MAX + 2];
+    int out_len = 0;
+    termLock();
+    bool active = termLineActive();
+    if (active) termLineApplyKey(c, out, &out_len);
+    termUnlock();
+    if (!active) return false;
+    if (out_len > 0) sshSendString(out, out_len);
+    return true;
+}
+
+// Touch arrows: left/right move the cursor, up/down walk the history.
+static bool termLineArrow(TouchTapArrow arrow) {
+    termLock();
+    bool active = termLineActive();
+    if (active) {
+        if (arrow == TOUCH_TAP_ARROW_LEFT && term_line_cur > 0) term_line_cur--;
+        else if (arrow == TOUCH_TAP_ARROW_RIGHT && term_line_cur < term_line_len) term_line_cur++;
+        else if (arrow == TOUCH_TAP_ARROW_UP) termLineHistoryBrowse(-1);
+        else if (arrow == TOUCH_TAP_ARROW_DOWN) termLineHistoryBrowse(1);
+        term_line_dirty = true;
+    }
+    termUnlock();
+    return active;
+}
+
+// Snapshot: render the band text into row (TERM_COLS wide) and return the
+// cursor column. The view scrolls sideways to keep the cursor visible.
+static int termLineRenderBand(char* row) {
+    int width = TERM_COLS - TERM_LINE_PREFIX - 1;
+    int first = term_line_cur > width ? term_line_cur - width : 0;
+    memset(row, ' ', TERM_COLS);
+    row[TERM_COLS] = '\0';
+    row[0] = first > 0 ? '<' : '>';
+    int n = term_line_len - first;
+    if (n > TERM_COLS - TERM_LINE_PREFIX) n = TERM_COLS - TERM_LINE_PREFIX;
+    if (n > 0) memcpy(row + TERM_LINE_PREFIX, term_line_buf + first, n);
+    term_line_dirty = false;
+    return TERM_LINE_PREFIX + term_line_cur - first;
+}
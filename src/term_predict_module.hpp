@@ -0,0 +1,182 @@
+#pragma once
+
+// --- Predictive Local Echo ---
+//
+// Printable terminal keys are drawn at the cursor as soon as they are sent,
+// before the server echoes them (mosh-style). Each prediction records the
+// grid cell it expects the echo in (kept in step with scrolls by
+// termPredScroll) and the epoch it was made in. The parser
+// task checks predictions after every slice (termPredCheck):
+//   confirmed  the server cursor passed the cell and the cell holds the char
+//   wrong      the cursor passed it with another char, or left the row
+//   expired    no echo within TERM_PRED_TIMEOUT_MS
+// A wrong or expired prediction drops every pending one and starts a new
+// epoch. Enter, control keys and anything else that is not predicted also
+// start a new epoch. Predictions are only shown once an echo in their epoch
+// has been confirmed, so after Enter (password prompts, pagers, editors in
+// command mode) nothing is displayed until the remote is seen echoing again.
+//
+// Predictions never touch the grid: the display snapshot overlays the
+// visible ones and marks them tentative. All state is under term_mutex.
+
+static constexpr int TERM_PRED_MAX = 64;
+static constexpr uint32_t TERM_PRED_TIMEOUT_MS = 3000;
+
+struct TermPrediction {
+    int16_t row;        // grid row
+    int16_t col;
+    char ch;
+    uint32_t epoch;
+    uint32_t sent_ms;
+};
+
+static TermPrediction term_pred[TERM_PRED_MAX];
+static int term_pred_count = 0;
+static uint32_t term_pred_epoch = 1;             // epoch new predictions join
+static uint32_t term_pred_confirmed_epoch = 0;   // newest epoch the server echoed
+static uint32_t term_pred_hits = 0;
+static uint32_t term_pred_misses = 0;
+
+static inline bool termPredVisible(const TermPrediction& p) {
+    return p.epoch <= term_pred_confirmed_epoch;
+}
+
+// Drop every pending prediction and start a new epoch. Returns true if a
+// visible one was removed (the screen changes).
+static bool termPredRollback() {
+    bool shown = false;
+    for (int i = 0; i < term_pred_count; i++) {
+        if (termPredVisible(term_pred[i])) shown = true;
+        termMarkRow(term_pred[i].row);
+    }
+    term_pred_count = 0;
+    term_pred_epoch++;
+    return shown;
+}
+
+// New session or full reset: forget predictions and the echo history.
+static void termPredReset() {
+    term_pred_count = 0;
+    term_pred_epoch++;
+    term_pred_confirmed_epoch = 0;
+}
+
+// Rows top..bot scrolled by one (up when dir < 0): predictions in the region
+// move with their row. One pushed out of the region has nowhere left to be
+// echoed, so everything pending rolls back. Inline: every scroll calls it,
+// and almost always with nothing pending.
+static inline void termPredScroll(int top, int bot, int dir) {
+    if (term_pred_count == 0) return;
+    for (int i = 0; i < term_pred_count; i++) {
+        TermPrediction& p = term_pred[i];
+        if (p.row < top || p.row > bot) continue;
+        if (p.row == (dir < 0 ? top : bot)) {
+            termPredRollback();
+            return;
+        }
+        p.row = (int16_t)(p.row + (dir < 0 ? -1 : 1));
+    }
+}
+
+// A key that is sent but not predicted: later keys can't be placed
+// relative to it, so they join a new, unconfirmed epoch.
+static void termPredBreak() {
+    term_pred_epoch++;
+}
+
+// Predict printable c at the cursor. Returns true if it is shown at once.
+static bool termPredictKey(char c) {
+    int row = term_cursor_row;
+    int col = term_cursor_col;
+    bool wrap = term_wrap_pending;
+    if (term_pred_count > 0 && term_pred[term_pred_count - 1].epoch == term_pred_epoch) {
+        const TermPrediction& last = term_pred[term_pred_count - 1];
+        row = last.row;
+        col = last.col + 1;
+        wrap = false;
+    }
+    // No prediction across a line wrap or past a full table.
+    if (wrap || col >= TERM_COLS || term_pred_count >= TERM_PRED_MAX || term_view_hist > 0) {
+        termPredBreak();
+        return false;
+    }
+    TermPrediction& p = term_pred[term_pred_count++];
+    p.row = (int16_t)row;
+    p.col = (int16_t)col;
+    p.ch = c;
+    p.epoch = term_pred_epoch;
+    p.sent_ms = millis();
+    termMarkRow(row);
+    return termPredVisible(p);
+}
+
+// Backspace takes back the newest unechoed prediction; otherwise it edits
+// text the server owns and is not predicted.
+static bool termPredictBackspace() {
+    if (term_pred_count > 0 && term_pred[term_pred_count - 1].epoch == term_pred_epoch) {
+        const TermPrediction& last = term_pred[--term_pred_count];
+        termMarkRow(last.row);
+        return termPredVisible(last);
+    }
+    termPredBreak();
+    return false;
+}
+
+// Parser task, after a slice (or an idle wake): settle predictions against
+// the grid. Returns true if the displayed overlay changed.
+static bool termPredCheck() {
+    if (term_pred_count == 0) return false;
+    uint32_t now = millis();
+    int done = 0;
+    bool changed = false;
+    for (; done < term_pred_count; done++) {
+        const TermPrediction& p = term_pred[done];
+        bool passed = term_cursor_row > p.row ||
+                      (term_cursor_row == p.row && term_cursor_col > p.col) ||
+                      (term_cursor_row == p.row && term_cursor_col == p.col && term_wrap_pending);
+        bool wrong = term_cursor_row < p.row || (passed && termRow(p.row)[p.col] != p.ch);
+        if (!wrong && !passed && now - p.sent_ms <= TERM_PRED_TIMEOUT_MS) break;
+        if (wrong || !passed) {
+            term_pred_misses++;
+            term_pred_count -= done;
+            memmove(term_pred, term_pred + done, term_pred_count * sizeof(TermPrediction));
+            return termPredRollback() || changed;
+        }
+        // Confirmed: the echo is on the grid now; its epoch becomes visible.
+        term_pred_hits++;
+        if (termPredVisible(p)) changed = true;
+        if (p.epoch > term_pred_confirmed_epoch) {
+            term_pred_confirmed_epoch = p.epoch;
+            changed = true;  // later predictions in this epoch appear
+        }
+        termMarkRow(p.row);
+    }
+    if (done > 0) {
+        term_pred_count -= done;
+        memmove(term_pred, term_pred + done, term_pred_count * sizeof(TermPrediction));
+    }
+    return changed;
+}
+
+// Grid position the cursor is drawn at: after the newest visible prediction.
+static void termPredCursor(int* row, int* col) {
+    for (int i = term_pred_count - 1; i >= 0; i--) {
+        const TermPrediction& p = term_pred[i];
+        if (!termPredVisible(p)) continue;
+        *row = p.row;
+        *col = p.col + 1 < TERM_COLS ? p.col + 1 : p.col;
+        return;
+    }
+}
+
+// Key path: note a byte just handed to the send queue. Takes term_mutex.
+// Returns true if the screen shows something new.
+static bool termPredictSent(char c) {
+    termLock();
+    bool shown = false;
+    if (c >= ' ' && c <= '~') shown = termPredictKey(c);
+    else if (c == 0x7F) shown = termPredictBackspace();
+    else termPredBreak();
+    termUnlock();
+    return shown;
+}
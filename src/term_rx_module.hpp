@@ -0,0 +1,232 @@
+#pragma once
+
+// --- Terminal Receive Ring ---
+//
+// sshReceiveTask only moves bytes from the SSH channel into a session's
+// term_rx ring; the term_parse task drains it into the terminal under
+// term_mutex, one slice at a time, so a key handler or display snapshot
+// waits for at most one slice however much output is queued. Single
+// producer / single consumer: head is only written by the receive task,
+// tail only by the parser. When the ring is full the receive task stops
+// reading and the data stays in the SSH channel window.
+//
+// Each terminal session has its own ring (the first in internal RAM, the
+// others in PSRAM, see term_session_module). The parser applies background
+// sessions' slices to their parked state with rendering left alone.
+//
+// termRxDiscard drops everything queued so far (new session, remote close).
+// The parser re-checks the discard generation under term_mutex before each
+// slice, so a slice taken before the discard is never applied after the
+// caller's terminalClear.
+
+static constexpr uint32_t TERM_RX_SIZE = 8192;      // power of two
+static constexpr uint32_t TERM_PARSE_SLICE = 256;   // bytes parsed per term_mutex hold
+
+struct TermRxRing {
+    uint8_t* buf;             // NULL until the session is first used
+    uint32_t head;            // free-running, producer only
+    uint32_t tail;            // free-running, consumer only
+    uint32_t discard_to;      // head at the last discard
+    uint32_t discard_gen;
+};
+
+static uint8_t term_rx_buf[TERM_RX_SIZE];
+static TermRxRing term_rx[TERM_SESSIONS] = { { term_rx_buf, 0, 0, 0, 0 } };
+static TaskHandle_t term_parse_task_handle = NULL;
+
+// --- Output Flood Detection ---
+//
+// The receive task measures the accepted output rate over
+// TERM_FLOOD_WINDOW_MS windows. Two windows in a row at or above
+// TERM_FLOOD_ENTER_BPS switch flood mode on; one window below
+// TERM_FLOOD_EXIT_BPS switches it off and requests the final frame. While
+// flooding, the display skips intermediate frames (renderBudgetMs), the
+// parser yields between slices, sleeps a tick every
+// TERM_FLOOD_SLICES_PER_TICK slices and asks for a frame every
+// TERM_FLOOD_RENDER_MS without waiting to drain, and the status bar shows
+// the rate. The rate is what the parser keeps up with: a full ring stops
+// channel reads.
+
+static constexpr uint32_t TERM_FLOOD_WINDOW_MS = 250;
+static constexpr uint32_t TERM_FLOOD_ENTER_BPS = 16 * 1024;
+static constexpr uint32_t TERM_FLOOD_EXIT_BPS = 4 * 1024;
+static constexpr uint32_t TERM_FLOOD_RENDER_MS = 2000;   // frame interval while flooding
+static constexpr int TERM_FLOOD_SLICES_PER_TICK = 16;    // 4 KB parsed between sleeps
+
+static volatile bool     term_flood_active = false;
+static volatile uint32_t term_flood_bps = 0;
+static uint32_t term_flood_window_start_ms = 0;
+static uint32_t term_flood_window_bytes = 0;
+static uint8_t  term_flood_hot_windows = 0;
+
+// Receive task only (or while it is stopped).
+static void termFloodReset() {
+    term_flood_active = false;
+    term_flood_bps = 0;
+    term_flood_window_start_ms = 0;
+    term_flood_window_bytes = 0;
+    term_flood_hot_windows = 0;
+}
+
+// Receive task: account bytes just queued (0 on idle passes).
+static void termFloodNote(uint32_t bytes) {
+    uint32_t now = millis();
+    if (term_flood_window_start_ms == 0) term_flood_window_start_ms = now;
+    term_flood_window_bytes += bytes;
+    uint32_t elapsed = now - term_flood_window_start_ms;
+    if (elapsed < TERM_FLOOD_WINDOW_MS) return;
+
+    uint32_t bps = (uint32_t)((uint64_t)term_flood_window_bytes * 1000U / elapsed);
+    term_flood_bps = bps;
+    term_flood_window_start_ms = now;
+    term_flood_window_bytes = 0;
+    if (bps >= TERM_FLOOD_ENTER_BPS) {
+        if (term_flood_hot_windows < 2) term_flood_hot_windows++;
+    } else {
+        term_flood_hot_windows = 0;
+    }
+
+    if (!term_flood_active && term_flood_hot_windows >= 2) {
+        term_flood_active = true;
+        SERIAL_LOGF("TERM: flood on (%lu B/s)\n", (unsigned long)bps);
+    } else if (term_flood_active && bps < TERM_FLOOD_EXIT_BPS) {
+        term_flood_active = false;
+        SERIAL_LOGF("TERM: flood off (%lu B/s)\n", (unsigned long)bps);
+        requestRender(RENDER_TERMINAL);
+    }
+}
+
+static uint32_t termRxFree(int session) {
+    TermRxRing& r = term_rx[session];
+    if (!r.buf) return 0;
+    return TERM_RX_SIZE - (r.head - __atomic_load_n(&r.tail, __ATOMIC_ACQUIRE));
+}
+
+// Producer: queue up to len bytes; returns how many fit.
+static int termRxPush(int session, const char* data, int len) {
+    TermRxRing& r = term_rx[session];
+    uint32_t head = r.head;
+    uint32_t n = termRxFree(session);
+    if ((uint32_t)len < n) n = (uint32_t)len;
+    if (n == 0) return 0;
+    uint32_t pos = head & (TERM_RX_SIZE - 1);
+    uint32_t first = TERM_RX_SIZE - pos;
+    if (first > n) first = n;
+    memcpy(r.buf + pos, data, first);
+    memcpy(r.buf, data + first, n - first);
+    __atomic_store_n(&r.head, head + n, __ATOMIC_RELEASE);
+    if (term_parse_task_handle) xTaskNotifyGive(term_parse_task_handle);
+    return (int)n;
+}
+
+// Producer side (or while no receive task runs): forget queued output.
+// Callers clear the terminal afterwards under term_mutex.
+static void termRxDiscard(int session) {
+    TermRxRing& r = term_rx[session];
+    r.discard_to = r.head;
+    __atomic_store_n(&r.discard_gen, r.discard_gen + 1, __ATOMIC_RELEASE);
+    if (session == term_session_active) termFloodReset();
+}
+
+// term_session_module: apply a background session's output to its parked state.
+static void termSessionParse(int session, const char* data, int len);
+
+// Parse one slice of a session's ring. Returns false when it is empty.
+static bool termRxParseSlice(int session, char* slice, uint32_t* seen_gen, bool* on_screen) {
+    TermRxRing& r = term_rx[session];
+    if (!r.buf) return false;
+    for (;;) {
+        uint32_t gen = __atomic_load_n(&r.discard_gen, __ATOMIC_ACQUIRE);
+        if (gen != *seen_gen) {
+            *seen_gen = gen;
+            __atomic_store_n(&r.tail, r.discard_to, __ATOMIC_RELEASE);
+        }
+        uint32_t tail = r.tail;
+        uint32_t n = __atomic_load_n(&r.head, __ATOMIC_ACQUIRE) - tail;
+        if (n == 0) return false;
+        if (n > TERM_PARSE_SLICE) n = TERM_PARSE_SLICE;
+        uint32_t pos = tail & (TERM_RX_SIZE - 1);
+        uint32_t first = TERM_RX_SIZE - pos;
+        if (first > n) first = n;
+        memcpy(slice, r.buf + pos, first);
+        memcpy(slice + first, r.buf, n - first);
+
+        termLock();
+        bool stale = __atomic_load_n(&r.discard_gen, __ATOMIC_ACQUIRE) != *seen_gen;
+        *on_screen = session == term_session_active;
+        if (!stale) {
+            if (*on_screen) {
+                terminalAppendOutput(slice, (int)n);
+                termPredCheck();
+            } else {
+                termSessionParse(session, slice, (int)n);
+            }
+        }
+        termUnlock();
+        if (stale) continue;  // re-read from the discard point
+        __atomic_store_n(&r.tail, tail + n, __ATOMIC_RELEASE);
+        return true;
+    }
+}
+
+static void termParseTask(void* param) {
+    (void)param;
+    static char slice[TERM_PARSE_SLICE];
+    uint32_t seen_gen[TERM_SESSIONS] = {};
+    uint32_t last_request_ms = 0;
+    int flood_slices = 0;
+    for (;;) {
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(100));
+        bool parsed = false;
+        bool background = false;
+        // The session on screen is drained whole; background sessions get a
+        // slice each per round until they are drained too.
+        bool more = true;
+        while (more) {
+            more = false;
+            for (int i = 0; i < TERM_SESSIONS; i++) {
+                bool on_screen = false;
+                while (termRxParseSlice(i, slice, &seen_gen[i], &on_screen)) {
+                    more = true;
+                    if (!on_screen) {
+                        if (!term_sessions[i].unseen) background = true;
+                        term_sessions[i].unseen = true;
+                        break;
+                    }
+                    parsed = true;
+                    if (term_flood_active) {
+                        // A flood may never drain; show progress meanwhile.
+                        if (millis() - last_request_ms >= TERM_FLOOD_RENDER_MS) {
+                            last_request_ms = millis();
+                            requestRender(RENDER_TERMINAL | RENDER_OUTPUT);
+                        }
+                        // taskYIELD lets the display and receive tasks in, but
+                        // not IDLE0 below us; without a blocked tick now and
+                        // then a long flood trips the task watchdog.
+                        if (++flood_slices >= TERM_FLOOD_SLICES_PER_TICK) {
+                            flood_slices = 0;
+                            vTaskDelay(1);
+                        } else {
+                            taskYIELD();
+                        }
+                    }
+                }
+            }
+        }
+        if (parsed) {
+            last_request_ms = millis();
+            requestRender(RENDER_TERMINAL | RENDER_OUTPUT);
+        } else if (term_pred_count > 0) {
+            // Idle wake: let unechoed predictions expire.
+            termLock();
+            bool changed = termPredCheck();
+            termUnlock();
+            if (changed) requestRender(RENDER_TERMINAL);
+        }
+        if (background) requestRender(RENDER_STATUS);
+    }
+}
+
+void termRxStart() {
+    xTaskCreatePinnedToCore(termParseTask, "term_parse", 4096, NULL, 1, &term_parse_task_handle, 0);
+}
@@ -0,0 +1,387 @@
+#pragma once
+
+// --- Terminal Sessions ---
+//
+// Up to TERM_SESSIONS SSH sessions run at once, each with its own
+// connection, terminal grid, parser state, scrollback and receive ring.
+// The session on screen lives in the usual globals, its grid in the static
+// internal-RAM stores. The others are parked in PSRAM: TermState holds
+// everything the parser and scrollback keep in globals, and the parked
+// grids' rows sit in the session's own PSRAM stores.
+//
+// Background sessions keep reading and parsing. For each of their slices
+// the parser loads the parked state into the globals, runs
+// terminalAppendOutput and parks it again (row pointers and scalars, no
+// grid copies), leaving the display's dirty flags as they were. Nothing is
+// rendered; the status bar marks that a parked session has new output.
+//
+// Alt+Mic cycles sessions (termSessionCycle). The key handler only records
+// the request; loop() runs it without state_mutex (termSessionPollSwitch),
+// letting queued keys go out first, then under state_mutex, term_mutex and
+// ssh_io_mutex parks the session on screen, moves the next one's grid into
+// internal RAM and swaps the SSH globals. Keys typed after Alt+Mic wait in
+// the key queue until the switch is done. The repaint comes from the cached
+// grid, no round trip needed.
+// A session's PSRAM (state, grids, receive ring, scrollback) is allocated
+// the first time it is switched to; the first session keeps its internal
+// receive ring and boot-time scrollback.
+
+struct TermState {
+    char (*main_rows)[TERM_COLS + 1];
+    char (*alt_rows)[TERM_COLS + 1];
+    TermGrid main_grid;
+    TermGrid alt_grid;
+    bool on_alt_grid;
+    int line_count;
+    int scroll;
+    int cursor_row;
+    int cursor_col;
+    uint8_t vt_state;
+    uint8_t vt_collect;
+    uint8_t vt_collect_count;
+    int csi_params[MAX_CSI_PARAMS];
+    int csi_param_count;
+    int csi_param_idx;
+    bool csi_has_params;
+    bool csi_private;
+    uint8_t mouse_mask;
+    bool mouse_sgr;
+    int region_top;
+    int region_bot;
+    bool region_set;
+    bool alt_active;
+    int saved_main_cursor_row;
+    int saved_main_cursor_col;
+    int saved_main_line_count;
+    int saved_main_scroll;
+    int saved_cursor_row;
+    int saved_cursor_col;
+    bool cursor_visible;
+    bool wrap_pending;
+    int utf8_remaining;
+    uint32_t utf8_codepoint;
+    uint8_t* hist_arena;
+    uint32_t* hist_start;
+    HistCacheLine* hist_cache;
+    uint32_t hist_first;
+    uint32_t hist_next;
+    uint32_t hist_write_pos;
+    int view_hist;
+};
+
+static TermState term_state_scratch;   // the session on screen while a parked one is loaded
+
+// Copy the emulator globals into st. Caller holds term_mutex.
+static void termStateSave(TermState* st) {
+    st->main_rows = term_main_rows;
+    st->alt_rows = term_alt_rows;
+    st->main_grid = term_main_grid;
+    st->alt_grid = term_alt_grid;
+    st->on_alt_grid = term_grid == &term_alt_grid;
+    st->line_count = term_line_count;
+    st->scroll = term_scroll;
+    st->cursor_row = term_cursor_row;
+    st->cursor_col = term_cursor_col;
+    st->vt_state = vt_state;
+    st->vt_collect = vt_collect;
+    st->vt_collect_count = vt_collect_count;
+    memcpy(st->csi_params, csi_params, sizeof(csi_params));
+    st->csi_param_count = csi_param_count;
+    st->csi_param_idx = csi_param_idx;
+    st->csi_has_params = csi_has_params;
+    st->csi_private = csi_private;
+    st->mouse_mask = term_mouse_tracking_mode_mask;
+    st->mouse_sgr = term_mouse_sgr_mode;
+    st->region_top = scroll_region_top;
+    st->region_bot = scroll_region_bot;
+    st->region_set = scroll_region_set;
+    st->alt_active = term_alt_active;
+    st->saved_main_cursor_row = saved_main_cursor_row;
+    st->saved_main_cursor_col = saved_main_cursor_col;
+    st->saved_main_line_count = saved_main_line_count;
+    st->saved_main_scroll = saved_main_scroll;
+    st->saved_cursor_row = saved_cursor_row;
+    st->saved_cursor_col = saved_cursor_col;
+    st->cursor_visible = cursor_visible;
+    st->wrap_pending = term_wrap_pending;
+    st->utf8_remaining = utf8_remaining;
+    st->utf8_codepoint = utf8_codepoint;
+    st->hist_arena = hist_arena;
+    st->hist_start = hist_start;
+    st->hist_cache = hist_cache;
+    st->hist_first = hist_first;
+    st->hist_next = hist_next;
+    st->hist_write_pos = hist_write_pos;
+    st->view_hist = term_view_hist;
+}
+
+// Inverse of termStateSave. Caller holds term_mutex.
+static void termStateLoad(const TermState* st) {
+    term_main_rows = st->main_rows;
+    term_alt_rows = st->alt_rows;
+    term_main_grid = st->main_grid;
+    term_alt_grid = st->alt_grid;
+    term_grid = st->on_alt_grid ? &term_alt_grid : &term_main_grid;
+    term_line_count = st->line_count;
+    term_scroll = st->scroll;
+    term_cursor_row = st->cursor_row;
+    term_cursor_col = st->cursor_col;
+    vt_state = st->vt_state;
+    vt_collect = st->vt_collect;
+    vt_collect_count = st->vt_collect_count;
+    memcpy(csi_params, st->csi_params, sizeof(csi_params));
+    csi_param_count = st->csi_param_count;
+    csi_param_idx = st->csi_param_idx;
+    csi_has_params = st->csi_has_params;
+    csi_private = st->csi_private;
+    term_mouse_tracking_mode_mask = st->mouse_mask;
+    term_mouse_sgr_mode = st->mouse_sgr;
+    scroll_region_top = st->region_top;
+    scroll_region_bot = st->region_bot;
+    scroll_region_set = st->region_set;
+    term_alt_active = st->alt_active;
+    saved_main_cursor_row = st->saved_main_cursor_row;
+    saved_main_cursor_col = st->saved_main_cursor_col;
+    saved_main_line_count = st->saved_main_line_count;
+    saved_main_scroll = st->saved_main_scroll;
+    saved_cursor_row = st->saved_cursor_row;
+    saved_cursor_col = st->saved_cursor_col;
+    cursor_visible = st->cursor_visible;
+    term_wrap_pending = st->wrap_pending;
+    utf8_remaining = st->utf8_remaining;
+    utf8_codepoint = st->utf8_codepoint;
+    hist_arena = st->hist_arena;
+    hist_start = st->hist_start;
+    hist_cache = st->hist_cache;
+    hist_first = st->hist_first;
+    hist_next = st->hist_next;
+    hist_write_pos = st->hist_write_pos;
+    term_view_hist = st->view_hist;
+}
+
+// Copy a grid's rows to new storage and repoint its row ring there.
+static void termGridMove(TermGrid& grid, char (*from)[TERM_COLS + 1], char (*to)[TERM_COLS + 1]) {
+    if (from == to) return;
+    memcpy(to, from, TERM_ROWS * (TERM_COLS + 1));
+    for (int i = 0; i < TERM_ROWS; i++) {
+        grid.rows[i] = to[(grid.rows[i] - from[0]) / (TERM_COLS + 1)];
+    }
+}
+
+static void termStateMoveRows(TermState* st, char (*main_rows)[TERM_COLS + 1],
+                              char (*alt_rows)[TERM_COLS + 1]) {
+    termGridMove(st->main_grid, st->main_rows, main_rows);
+    termGridMove(st->alt_grid, st->alt_rows, alt_rows);
+    st->main_rows = main_rows;
+    st->alt_rows = alt_rows;
+}
+
+// Run the parser (or terminalClear) against a parked state in place of the
+// session on screen. The screen's dirty flags and local-echo predictions
+// (which a RIS would reset) are put back afterwards. Caller holds term_mutex.
+static uint64_t term_session_dirty = 0;
+static bool term_session_all_dirty = false;
+static int term_session_pred_count = 0;
+static uint32_t term_session_pred_epoch = 0;
+static uint32_t term_session_pred_confirmed = 0;
+
+static void termSessionEnter(const TermState* st) {
+    term_session_dirty = term_row_dirty;
+    term_session_all_dirty = term_all_dirty;
+    term_session_pred_count = term_pred_count;
+    term_session_pred_epoch = term_pred_epoch;
+    term_session_pred_confirmed = term_pred_confirmed_epoch;
+    termStateSave(&term_state_scratch);
+    termStateLoad(st);
+}
+
+static void termSessionExit(TermState* st) {
+    termStateSave(st);
+    termStateLoad(&term_state_scratch);
+    term_row_dirty = term_session_dirty;
+    term_all_dirty = term_session_all_dirty;
+    term_pred_count = term_session_pred_count;
+    term_pred_epoch = term_session_pred_epoch;
+    term_pred_confirmed_epoch = term_session_pred_confirmed;
+}
+
+// term_rx parser, under term_mutex: one slice of a background session.
+static void termSessionParse(int session, const char* data, int len) {
+    TermState* st = term_sessions[session].term;
+    if (!st) return;
+    termSessionEnter(st);
+    terminalAppendOutput(data, len);
+    termSessionExit(st);
+}
+
+// First use of a session: PSRAM for its parked state, grids, receive ring
+// and scrollback, then a cleared terminal in it.
+static bool termSessionAlloc(int session) {
+    TermSession& s = term_sessions[session];
+    if (s.term) return true;
+
+    const size_t grid_bytes = TERM_ROWS * (TERM_COLS + 1);
+    TermState* st = (TermState*)ps_malloc(sizeof(TermState));
+    char (*main_store)[TERM_COLS + 1] = (char (*)[TERM_COLS + 1])ps_malloc(grid_bytes);
+    char (*alt_store)[TERM_COLS + 1] = (char (*)[TERM_COLS + 1])ps_malloc(grid_bytes);
+    uint8_t* ring = term_rx[session].buf ? term_rx[session].buf : (uint8_t*)ps_malloc(TERM_RX_SIZE);
+    if (!st || !main_store || !alt_store || !ring) {
+        free(st);
+        free(main_store);
+        free(alt_store);
+        if (ring != term_rx[session].buf) free(ring);
+        SERIAL_LOGF("Session %d: no PSRAM\n", session + 1);
+        return false;
+    }
+    memset(st, 0, sizeof(TermState));
+    s.main_store = main_store;
+    s.alt_store = alt_store;
+
+    if (session != term_session_active) {
+        // Its own scrollback; without it the session just keeps no history.
+        uint8_t* arena = (uint8_t*)ps_malloc(HIST_BYTES);
+        uint32_t* starts = (uint32_t*)ps_malloc(HIST_LINES * sizeof(uint32_t));
+        HistCacheLine* cache = (HistCacheLine*)ps_malloc(HIST_CACHE_LINES * sizeof(HistCacheLine));
+        if (arena && starts && cache) {
+            memset(cache, 0, HIST_CACHE_LINES * sizeof(HistCacheLine));
+        } else {
+            free(arena);
+            free(starts);
+            free(cache);
+            arena = NULL;
+            starts = NULL;
+            cache = NULL;
+            SERIAL_LOGF("Session %d: no scrollback\n", session + 1);
+        }
+
+        termLock();
+        termSessionEnter(st);   // zeroed; terminalClear fills in the rest
+        term_main_rows = main_store;
+        term_alt_rows = alt_store;
+        hist_arena = arena;
+        hist_start = starts;
+        hist_cache = cache;
+        terminalClear();
+        termSessionExit(st);
+        termUnlock();
+    }
+    term_rx[session].buf = ring;
+    s.term = st;
+    return true;
+}
+
+static constexpr uint32_t TERM_SESSION_SWITCH_WAIT_MS = 500;
+
+static volatile int term_session_switch_to = -1;   // Alt+Mic request, run by loop()
+
+// Bring session `to` on screen. loop(), holding state_mutex. Waits only the
+// default sshIOLock slice: *busy is set when ssh_io_mutex stays taken (an
+// exec channel open or close in flight) and the caller retries without
+// state_mutex.
+static bool termSessionSwitch(int to, bool* busy) {
+    *busy = false;
+    int from = term_session_active;
+    if (to == from || to < 0 || to >= TERM_SESSIONS) return false;
+    if (ssh_connecting) {   // the connect task owns the SSH globals
+        SERIAL_LOGLN("Session: switch refused while connecting");
+        return false;
+    }
+    if (!termSessionAlloc(from) || !termSessionAlloc(to)) return false;
+
+    termLock();
+    if (!sshIOLock()) {
+        termUnlock();
+        *busy = true;
+        return false;
+    }
+    sshTxDiscard();
+
+    TermSession& out = term_sessions[from];
+    termStateSave(out.term);
+    termStateMoveRows(out.term, out.main_store, out.alt_store);
+    out.sess = ssh_sess;
+    out.chan = ssh_chan;
+    out.connected = ssh_connected;
+    memcpy(out.last_host, ssh_last_host, sizeof(out.last_host));
+    memcpy(out.target_host, ssh_target_host, sizeof(out.target_host));
+    out.unseen = false;
+
+    TermSession& in = term_sessions[to];
+    termStateMoveRows(in.term, term_main_store, term_alt_store);
+    termStateLoad(in.term);
+    ssh_sess = in.sess;
+    ssh_chan = in.chan;
+    ssh_connected = in.connected;
+    memcpy(ssh_last_host, in.last_host, sizeof(ssh_last_host));
+    memcpy(ssh_target_host, in.target_host, sizeof(ssh_target_host));
+    in.sess = NULL;
+    in.chan = NULL;
+    in.connected = false;
+    in.unseen = false;
+    term_session_active = to;
+
+    term_all_dirty = true;
+    term_search_before = -1;
+    termPredReset();
+    termLineClear();
+    sshIOUnlock();
+    termUnlock();
+
+    connect_status_count = 0;
+    SERIAL_LOGF("Session: %d/%d %s\n", to + 1, TERM_SESSIONS, ssh_connected ? ssh_last_host : "(idle)");
+    return true;
+}
+
+// Alt+Mic: ask loop() for the next session. Key path, holding state_mutex.
+static bool termSessionCycle() {
+    if (term_session_switch_to < 0) {
+        term_session_switch_to = (term_session_active + 1) % TERM_SESSIONS;
+    }
+    return false;
+}
+
+// loop(), without state_mutex: run a switch termSessionCycle asked for.
+// The waits for queued keys and for ssh_io_mutex happen here, so neither
+// the key path nor the display snapshot stalls behind them.
+static void termSessionPollSwitch() {
+    int to = term_session_switch_to;
+    if (to < 0) return;
+
+    // Keys already typed belong to the session on screen.
+    uint32_t start = millis();
+    while (ssh_connected && sshTxPending() > 0 && millis() - start < TERM_SESSION_SWITCH_WAIT_MS) {
+        vTaskDelay(pdMS_TO_TICKS(10));
+    }
+
+    start = millis();
+    bool switched = false;
+    for (;;) {
+        bool busy = false;
+        if (xSemaphoreTake(state_mutex, pdMS_TO_TICKS(25)) == pdTRUE) {
+            switched = termSessionSwitch(to, &busy);
+            xSemaphoreGive(state_mutex);
+        } else {
+            busy = true;
+        }
+        if (!busy) break;
+        if (millis() - start >= TERM_SESSION_SWITCH_WAIT_MS) {
+            SERIAL_LOGLN("Session: switch gave up, SSH busy");
+            break;
+        }
+        vTaskDelay(pdMS_TO_TICKS(10));
+    }
+    term_session_switch_to = -1;
+    if (switched) requestRender(RENDER_TERMINAL | RENDER_STATUS);
+}
+
+// Status bar: sessions are in use once the first switch parked session 1.
+static bool termSessionsInUse() {
+    return term_sessions[0].term != NULL;
+}
+
+static bool termSessionUnseen() {
+    for (int i = 0; i < TERM_SESSIONS; i++) {
+        if (i != term_session_active && term_sessions[i].unseen) return true;
+    }
+    return false;
+}
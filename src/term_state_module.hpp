@@ -0,0 +1,133 @@
+#pragma once
+
+// --- Terminal State (shared, protected by term_mutex) ---
+
+// Terminal grid: a ring of row pointers over fixed row storage, one screen
+// high. termRow(r) maps a screen row to its storage, so a full-screen scroll
+// only advances the ring head and region scrolls rotate pointers. Lines
+// scrolled off the main screen go to the PSRAM scrollback (scrollback_module).
+// Main and alternate screens are separate grids; switching between them
+// swaps term_grid.
+struct TermGrid {
+    char* rows[TERM_ROWS];
+    int head;
+};
+static char term_main_store[TERM_ROWS][TERM_COLS + 1];
+static char term_alt_store[TERM_ROWS][TERM_COLS + 1];
+static TermGrid term_main_grid;
+static TermGrid term_alt_grid;
+static TermGrid* term_grid = &term_main_grid;
+// Storage the grids are reset onto: the stores above for the session on
+// screen, a background session's own PSRAM rows while the parser runs it
+// (term_session_module).
+static char (*term_main_rows)[TERM_COLS + 1] = term_main_store;
+static char (*term_alt_rows)[TERM_COLS + 1] = term_alt_store;
+
+static inline char*& termRowSlot(int row) {
+    int i = term_grid->head + row;
+    if (i >= TERM_ROWS) i -= TERM_ROWS;
+    return term_grid->rows[i];
+}
+
+static inline char* termRow(int row) {
+    return termRowSlot(row);
+}
+
+static void termGridReset(TermGrid& grid, char (*store)[TERM_COLS + 1], int rows) {
+    for (int i = 0; i < TERM_ROWS; i++) grid.rows[i] = store[i];
+    grid.head = 0;
+    for (int i = 0; i < rows; i++) {
+        memset(store[i], ' ', TERM_COLS);
+        store[i][TERM_COLS] = '\0';
+    }
+}
+
+static int  term_line_count = 1;
+static int  term_scroll     = 0;
+static int  term_cursor_row = 0;
+static int  term_cursor_col = 0;
+
+// Buffer rows written since the last snapshot, one bit per row, so a scroll
+// marks its region with one OR. term_all_dirty covers changes that touch
+// the whole buffer (clear, alt screen switch).
+static_assert(TERM_ROWS <= 64, "term_row_dirty has one bit per row");
+static uint64_t term_row_dirty = 0;
+static bool term_all_dirty = true;
+
+static inline void termMarkRow(int row) {
+    if (row >= 0 && row < TERM_ROWS) term_row_dirty |= 1ULL << row;
+}
+
+static inline void termMarkRows(int first, int last) {
+    if (first < 0) first = 0;
+    if (last >= TERM_ROWS) last = TERM_ROWS - 1;
+    if (first > last) return;
+    term_row_dirty |= (~0ULL >> (63 - last)) & (~0ULL << first);
+}
+
+static inline bool termRowDirty(int row) {
+    return (term_row_dirty >> row) & 1;
+}
+
+// Terminal snapshot (one row per screen line) — private to core 0
+static char term_snap_buf[ROWS_PER_SCREEN][TERM_COLS + 1];
+static int  term_snap_lines  = 1;
+static int  term_snap_scroll = 0;
+static int  term_snap_view   = 0;     // scrollback lines above the grid
+static int  term_snap_crow   = 0;     // cursor screen row
+static int  term_snap_ccol   = 0;
+
+// Escape parser state (VT500-style state machine, see terminalAppendOutput).
+// Everything lives here so sequences split across reads resume cleanly.
+enum VtState : uint8_t {
+    VT_GROUND,
+    VT_ESCAPE,
+    VT_ESCAPE_INTER,
+    VT_CSI_ENTRY,
+    VT_CSI_PARAM,
+    VT_CSI_INTER,
+    VT_CSI_IGNORE,
+    VT_OSC_STRING,
+    VT_DCS_ENTRY,
+    VT_DCS_PARAM,
+    VT_DCS_INTER,
+    VT_DCS_PASS,
+    VT_DCS_IGNORE,
+    VT_SOS_STRING,    // SOS / PM / APC
+    VT_STATE_COUNT,
+};
+static uint8_t vt_state = VT_GROUND;
+static uint8_t vt_collect = 0;        // first private marker / intermediate byte
+static uint8_t vt_collect_count = 0;
+#define MAX_CSI_PARAMS 16
+#define CSI_PARAM_MAX  65535
+static int  csi_params[MAX_CSI_PARAMS];
+static int  csi_param_count = 0;      // params of the sequence being dispatched
+static int  csi_param_idx = 0;        // param being collected
+static bool csi_has_params = false;
+static bool csi_private = false;      // '?' marker on the dispatched CSI
+// Mouse reporting modes requested by remote terminal app (DECSET private modes).
+static uint8_t term_mouse_tracking_mode_mask = 0; // ?1000/?1002/?1003
+static bool term_mouse_sgr_mode = false;          // ?1006
+
+// Scroll region (0-based screen rows)
+static int scroll_region_top = 0;
+static int scroll_region_bot = ROWS_PER_SCREEN - 1;
+static bool scroll_region_set = false;  // explicitly set by CSI r
+
+// Alternate screen state
+static bool term_alt_active = false;
+static int saved_main_cursor_row = 0, saved_main_cursor_col = 0;
+static int saved_main_line_count = 0, saved_main_scroll = 0;
+
+// Cursor save/restore (ESC 7/8, CSI s/u)
+static int saved_cursor_row = 0, saved_cursor_col = 0;
+
+// Cursor visibility
+static bool cursor_visible = true;
+static bool term_snap_cursor_visible = true;
+static bool term_wrap_pending = false; // delayed wrap after writing at last column
+
+// UTF-8 parsing state
+static int utf8_remaining = 0;
+static uint32_t utf8_codepoint = 0;
@@ -0,0 +1,466 @@
+// --- Notepad Text Buffer (piece table) ---
+//
+// The document is a sequence of pieces, each a slice of one of two buffers:
+//   text_orig  the file as loaded (read-only, PSRAM)
+//   text_add   append-only arena holding every typed character (PSRAM)
+// Typing appends to text_add and grows the piece that ends at the arena tip,
+// so a run of keystrokes stays one piece. Backspace trims a piece edge. Only
+// edits in the middle of a piece split it. Piece lookups walk from the last
+// piece touched, which is the cursor's piece during normal editing.
+// All functions: caller must hold state_mutex (or be the only editor writer).
+
+struct TextPiece {
+    uint8_t src;   // TEXT_SRC_ORIG or TEXT_SRC_ADD
+    int start;
+    int len;
+};
+
+#define TEXT_SRC_ORIG 0
+#define TEXT_SRC_ADD  1
+
+static char* text_orig = nullptr;
+static int   text_orig_len = 0;
+static char* text_add = nullptr;
+static int   text_add_len = 0;
+static int   text_add_cap = 0;
+static TextPiece* text_pieces = nullptr;
+static int   text_piece_count = 0;
+static int   text_piece_cap = 0;
+static int   text_hint_piece = 0;   // last piece located
+static int   text_hint_off   = 0;   // logical offset where it starts
+static uint32_t text_doc_id   = 0;  // bumped when a document is cleared or loaded
+static uint32_t text_edit_seq = 0;  // bumped by every insert and erase
+
+// Document storage prefers PSRAM; fall back to the internal heap without it.
+static void* textRealloc(void* ptr, size_t size) {
+    void* p = ps_realloc(ptr, size);
+    if (!p) p = realloc(ptr, size);
+    return p;
+}
+
+static void* textAlloc(size_t size) {
+    void* p = ps_malloc(size);
+    if (!p) p = malloc(size);
+    return p;
+}
+
+static inline const char* textPieceData(const TextPiece& pc) {
+    return (pc.src == TEXT_SRC_ADD ? text_add : text_orig) + pc.start;
+}
+
+// Find the piece containing logical offset off; returns its index and stores
+// its start offset. off == text_len yields text_piece_count.
+static int textLocate(int off, int* piece_start) {
+    int p = text_hint_piece;
+    int start = text_hint_off;
+    if (p > text_piece_count) { p = 0; start = 0; }
+    while (p > 0 && off < start) {
+        p--;
+        start -= text_pieces[p].len;
+    }
+    while (p < text_piece_count && off >= start + text_pieces[p].len) {
+        start += text_pieces[p].len;
+        p++;
+    }
+    text_hint_piece = p;
+    text_hint_off = start;
+    *piece_start = start;
+    return p;
+}
+
+static bool textPiecesReserve(int extra) {
+    if (text_piece_count + extra <= text_piece_cap) return true;
+    int new_cap = text_piece_cap > 0 ? text_piece_cap : 64;
+    while (new_cap < text_piece_count + extra) new_cap *= 2;
+    TextPiece* grown = (TextPiece*)textRealloc(text_pieces, new_cap * sizeof(TextPiece));
+    if (!grown) return false;
+    text_pieces = grown;
+    text_piece_cap = new_cap;
+    return true;
+}
+
+static bool textAddReserve(int extra) {
+    if (text_add_len + extra <= text_add_cap) return true;
+    int new_cap = text_add_cap > 0 ? text_add_cap : 4096;
+    while (new_cap < text_add_len + extra) new_cap *= 2;
+    char* grown = (char*)textRealloc(text_add, new_cap);
+    if (!grown) return false;
+    text_add = grown;
+    text_add_cap = new_cap;
+    return true;
+}
+
+static void textPiecesInsertAt(int p, const TextPiece* src, int n) {
+    memmove(&text_pieces[p + n], &text_pieces[p], (text_piece_count - p) * sizeof(TextPiece));
+    memcpy(&text_pieces[p], src, n * sizeof(TextPiece));
+    text_piece_count += n;
+}
+
+static void textPiecesRemoveAt(int p) {
+    memmove(&text_pieces[p], &text_pieces[p + 1], (text_piece_count - p - 1) * sizeof(TextPiece));
+    text_piece_count--;
+}
+
+static inline char textCharAt(int i) {
+    int start;
+    int p = textLocate(i, &start);
+    if (p >= text_piece_count) return '\0';
+    return textPieceData(text_pieces[p])[i - start];
+}
+
+// Longest contiguous run starting at logical pos; returns its length
+// (0 at end of text). Iterate with pos += run length.
+int textRunAt(int pos, const char** run) {
+    if (pos < 0) pos = 0;
+    int start;
+    int p = textLocate(pos, &start);
+    if (p >= text_piece_count) {
+        *run = "";
+        return 0;
+    }
+    *run = textPieceData(text_pieces[p]) + (pos - start);
+    return text_pieces[p].len - (pos - start);
+}
+
+// --- Wrapped Line Index ---
+//
+// A paragraph of L chars (excluding its '\n') wraps to L / COLS_PER_LINE + 1
+// visual lines, so layout only depends on where the newlines are. Each '\n'
+// gets a mark {pos, line}: its offset and the visual line that starts right
+// after it. Marks live in a gap array that tracks the edit point: marks in
+// front of the gap are absolute, marks behind it are stored relative to the
+// end (text_len - pos, text_total_lines - line), so an edit only touches the
+// paragraph around the gap. Lookups binary-search the marks: O(log n).
+
+struct TextLineMark {
+    int pos;
+    int line;
+};
+
+static TextLineMark* text_marks = nullptr;
+static int text_marks_cap  = 0;
+static int text_mark_gap_start = 0;
+static int text_mark_gap_end   = 0;
+static int text_total_lines = 1;
+
+static inline int textMarkCount() {
+    return text_mark_gap_start + (text_marks_cap - text_mark_gap_end);
+}
+
+static inline int textMarkPos(int k) {
+    if (k < text_mark_gap_start) return text_marks[k].pos;
+    return text_len - text_marks[k + (text_mark_gap_end - text_mark_gap_start)].pos;
+}
+
+static inline int textMarkLine(int k) {
+    if (k < text_mark_gap_start) return text_marks[k].line;
+    return text_total_lines - text_marks[k + (text_mark_gap_end - text_mark_gap_start)].line;
+}
+
+static bool textMarksReserve(int extra) {
+    int gap = text_mark_gap_end - text_mark_gap_start;
+    if (gap >= extra) return true;
+    int need = textMarkCount() + extra;
+    int new_cap = text_marks_cap > 0 ? text_marks_cap : 64;
+    while (new_cap < need) new_cap *= 2;
+    TextLineMark* grown = (TextLineMark*)textRealloc(text_marks, new_cap * sizeof(TextLineMark));
+    if (!grown) return false;
+    int tail = text_marks_cap - text_mark_gap_end;
+    memmove(&grown[new_cap - tail], &grown[text_mark_gap_end], tail * sizeof(TextLineMark));
+    text_marks = grown;
+    text_mark_gap_end = new_cap - tail;
+    text_marks_cap = new_cap;
+    return true;
+}
+
+// Move the mark gap so that exactly the marks with pos < off sit in front.
+static void textMarksMoveGap(int off) {
+    while (text_mark_gap_start > 0 && text_marks[text_mark_gap_start - 1].pos >= off) {
+        TextLineMark m = text_marks[--text_mark_gap_start];
+        text_marks[--text_mark_gap_end] = { text_len - m.pos, text_total_lines - m.line };
+    }
+    while (text_mark_gap_end < text_marks_cap && text_len - text_marks[text_mark_gap_end].pos < off) {
+        TextLineMark m = text_marks[text_mark_gap_end++];
+        text_marks[text_mark_gap_start++] = { text_len - m.pos, text_total_lines - m.line };
+    }
+}
+
+static inline int textWrapLines(int par_len) { return par_len / COLS_PER_LINE + 1; }
+
+// Paragraph around the mark gap: [*start, *end), first visual line *line.
+static void textGapParagraph(int* start, int* end, int* line) {
+    *start = text_mark_gap_start > 0 ? text_marks[text_mark_gap_start - 1].pos + 1 : 0;
+    *line  = text_mark_gap_start > 0 ? text_marks[text_mark_gap_start - 1].line : 0;
+    *end   = text_mark_gap_end < text_marks_cap ? text_len - text_marks[text_mark_gap_end].pos : text_len;
+}
+
+// Rebuild marks from the document (after loads). O(n), once per load.
+static void textMarksRebuild() {
+    text_mark_gap_start = 0;
+    text_mark_gap_end = text_marks_cap;
+    int par_start = 0;
+    int line = 0;
+    for (int pos = 0; pos < text_len;) {
+        const char* run;
+        int n = textRunAt(pos, &run);
+        const char* nl = (const char*)memchr(run, '\n', n);
+        if (!nl) { pos += n; continue; }
+        int i = pos + (int)(nl - run);
+        line += textWrapLines(i - par_start);
+        if (!textMarksReserve(1)) break;
+        text_marks[text_mark_gap_start++] = { i, line };
+        par_start = i + 1;
+        pos = i + 1;
+    }
+    text_total_lines = line + textWrapLines(text_len - par_start);
+}
+
+// --- Document Operations ---
+
+void textClear() {
+    journalDetach();
+    text_doc_id++;
+    free(text_orig);
+    text_orig = nullptr;
+    text_orig_len = 0;
+    text_add_len = 0;
+    text_piece_count = 0;
+    text_hint_piece = 0;
+    text_hint_off = 0;
+    text_len = 0;
+    cursor_pos = 0;
+    text_mark_gap_start = 0;
+    text_mark_gap_end = text_marks_cap;
+    text_total_lines = 1;
+}
+
+// Take ownership of a loaded file (allocated with textAlloc) as the original
+// buffer. The cursor is placed at the end.
+bool textAdoptOriginal(char* data, int len) {
+    textClear();
+    if (len > 0 && !textPiecesReserve(1)) {
+        free(data);
+        return false;
+    }
+    text_orig = data;
+    text_orig_len = len;
+    if (len > 0) {
+        text_pieces[0] = { TEXT_SRC_ORIG, 0, len };
+        text_piece_count = 1;
+    }
+    text_len = len;
+    cursor_pos = len;
+    textMarksRebuild();
+    return true;
+}
+
+// The cursor sits at the end of the newest typed run: the hint piece is the
+// one at the arena tip and ends at cursor_pos. True while typing or erasing
+// at the end of what was just typed, wherever that is in the document.
+static inline bool textAtTypedTip() {
+    if (text_hint_piece >= text_piece_count) return false;
+    const TextPiece& pc = text_pieces[text_hint_piece];
+    return pc.src == TEXT_SRC_ADD && pc.start + pc.len == text_add_len &&
+           text_hint_off + pc.len == cursor_pos;
+}
+
+// Length of the paragraph around the mark gap after moving it to off.
+static inline int textGapParagraphLen(int off) {
+    textMarksMoveGap(off);
+    int par_start, par_end, par_line;
+    textGapParagraph(&par_start, &par_end, &par_line);
+    return par_end - par_start;
+}
+
+// Insert c at cursor_pos and advance the cursor. Returns false when out of memory.
+bool textInsert(char c) {
+    if (c != '\n' && text_add_len < text_add_cap && textAtTypedTip()) {
+        // Fast path: grow the tip piece; only a wrap boundary changes layout.
+        int off = cursor_pos;
+        if ((textGapParagraphLen(off) + 1) % COLS_PER_LINE == 0) text_total_lines++;
+        text_pieces[text_hint_piece].len++;
+        text_add[text_add_len++] = c;
+        text_len++;
+        cursor_pos++;
+        text_edit_seq++;
+        journalNoteInsert(off, c);
+        return true;
+    }
+    if (!textAddReserve(1) || !textPiecesReserve(2)) return false;
+    if (c == '\n' && !textMarksReserve(1)) return false;
+
+    int off = cursor_pos;
+    textMarksMoveGap(off);
+    int par_start, par_end, par_line;
+    textGapParagraph(&par_start, &par_end, &par_line);
+    int par_len = par_end - par_start;
+    if (c == '\n') {
+        int head = off - par_start;
+        text_marks[text_mark_gap_start++] = { off, par_line + textWrapLines(head) };
+        text_total_lines += textWrapLines(head) + textWrapLines(par_len - head) - textWrapLines(par_len);
+    } else {
+        text_total_lines += textWrapLines(par_len + 1) - textWrapLines(par_len);
+    }
+
+    int start;
+    int p = textLocate(off, &start);
+    if (off == start && p > 0) {
+        TextPiece& prev = text_pieces[p - 1];
+        if (prev.src == TEXT_SRC_ADD && prev.start + prev.len == text_add_len) {
+            // Typing continues the last insert: grow that piece in place.
+            prev.len++;
+            text_hint_piece = p - 1;
+            text_hint_off = start - (prev.len - 1);
+            text_add[text_add_len++] = c;
+            text_len++;
+            cursor_pos++;
+            text_edit_seq++;
+            journalNoteInsert(off, c);
+            return true;
+        }
+    }
+
+    TextPiece added = { TEXT_SRC_ADD, text_add_len, 1 };
+    text_add[text_add_len++] = c;
+    if (off == start) {
+        textPiecesInsertAt(p, &added, 1);
+    } else {
+        TextPiece& cur = text_pieces[p];
+        int head = off - start;
+        TextPiece split[2] = { added, { cur.src, cur.start + head, cur.len - head } };
+        cur.len = head;
+        textPiecesInsertAt(p + 1, split, 2);
+    }
+    text_len++;
+    cursor_pos++;
+    text_edit_seq++;
+    journalNoteInsert(off, c);
+    return true;
+}
+
+// Delete the character before cursor_pos. Returns false at start of text.
+bool textBackspace() {
+    if (cursor_pos <= 0) return false;
+    if (textAtTypedTip() && text_pieces[text_hint_piece].len > 1 && text_add[text_add_len - 1] != '\n') {
+        // Fast path: take back the newest typed char and its arena byte.
+        int off = cursor_pos - 1;
+        if (textGapParagraphLen(off) % COLS_PER_LINE == 0) text_total_lines--;
+        text_pieces[text_hint_piece].len--;
+        text_add_len--;
+        text_len--;
+        cursor_pos--;
+        text_edit_seq++;
+        journalNoteErase(off);
+        return true;
+    }
+
+    int off = cursor_pos - 1;
+    int start;
+    int p = textLocate(off, &start);
+    if (p >= text_piece_count) return false;
+    if (!textPiecesReserve(1)) return false;
+    TextPiece& cur = text_pieces[p];
+    int rel = off - start;
+    bool is_newline = textPieceData(cur)[rel] == '\n';
+
+    textMarksMoveGap(off);
+    int par_start, par_end, par_line;
+    textGapParagraph(&par_start, &par_end, &par_line);
+    if (is_newline) {
+        // par_end == off: join this paragraph with the one after the '\n'.
+        text_mark_gap_end++;
+        int next_end = text_mark_gap_end < text_marks_cap
+            ? text_len - text_marks[text_mark_gap_end].pos : text_len;
+        int head = off - par_start;
+        int tail = next_end - (off + 1);
+        text_total_lines += textWrapLines(head + tail) - textWrapLines(head) - textWrapLines(tail);
+    } else {
+        int par_len = par_end - par_start;
+        text_total_lines += textWrapLines(par_len - 1) - textWrapLines(par_len);
+    }
+
+    if (rel == cur.len - 1) {
+        // Backspacing the newest typed char also releases its arena byte.
+        if (cur.src == TEXT_SRC_ADD && cur.start + cur.len == text_add_len) text_add_len--;
+        cur.len--;
+    } else if (rel == 0) {
+        cur.start++;
+        cur.len--;
+    } else {
+        TextPiece rest = { cur.src, cur.start + rel + 1, cur.len - rel - 1 };
+        cur.len = rel;
+        textPiecesInsertAt(p + 1, &rest, 1);
+    }
+    if (text_pieces[p].len == 0) textPiecesRemoveAt(p);
+
+    text_len--;
+    cursor_pos--;
+    text_edit_seq++;
+    journalNoteErase(off);
+    return true;
+}
+
+// Copy logical [from, from + len) into dst (no terminator). Returns bytes copied.
+int textCopyOut(int from, int len, char* dst) {
+    int copied = 0;
+    while (copied < len) {
+        const char* run;
+        int n = textRunAt(from + copied, &run);
+        if (n <= 0) break;
+        if (n > len - copied) n = len - copied;
+        memcpy(dst + copied, run, n);
+        copied += n;
+    }
+    return copied;
+}
+
+// Flat copy of the whole document (NUL-terminated) for callers that need one
+// buffer, e.g. the HTTP PUT body. Caller frees; nullptr when out of memory.
+char* textFlattenAlloc() {
+    char* out = (char*)textAlloc(text_len + 1);
+    if (!out) return nullptr;
+    textCopyOut(0, text_len, out);
+    out[text_len] = '\0';
+    return out;
+}
+
+int textTotalLines() { return text_total_lines; }
+
+// Visual line/column of offset cpos.
+LayoutInfo textComputeLayout(int cpos) {
+    if (cpos < 0) cpos = 0;
+    if (cpos > text_len) cpos = text_len;
+    // k = number of newlines before cpos
+    int lo = 0, hi = textMarkCount();
+    while (lo < hi) {
+        int mid = (lo + hi) / 2;
+        if (textMarkPos(mid) < cpos) lo = mid + 1;
+        else hi = mid;
+    }
+    int par_start = lo > 0 ? textMarkPos(lo - 1) + 1 : 0;
+    int par_line  = lo > 0 ? textMarkLine(lo - 1) : 0;
+    int rel = cpos - par_start;
+    LayoutInfo info;
+    info.total_lines = text_total_lines;
+    info.cursor_line = par_line + rel / COLS_PER_LINE;
+    info.cursor_col  = rel % COLS_PER_LINE;
+    return info;
+}
+
+// Offset of (line, col), clamped to the end of that visual line's paragraph.
+int textOffsetAt(int line, int col) {
+    if (line < 0) return 0;
+    if (line >= text_total_lines) return text_len;
+    // k = paragraph index = number of marks whose next line starts <= line
+    int lo = 0, hi = textMarkCount();
+    while (lo < hi) {
+        int mid = (lo + hi) / 2;
+        if (textMarkLine(mid) <= line) lo = mid + 1;
+        else hi = mid;
+    }
+    int par_start = lo > 0 ? textMarkPos(lo - 1) + 1 : 0;
+    int par_line  = lo > 0 ? textMarkLine(lo - 1) : 0;
+    int par_end   = lo < textMarkCount() ? textMarkPos(lo) : text_len;
+    int off = par_start + (line - par_line) * COLS_PER_LINE + col;
+    return off < par_end ? off : par_end;
+}
@@ -0,0 +1,144 @@
+// Glyph benchmark: a full 40x38 terminal frame (text rows plus the inverted
+// cursor cell) drawn and sent to the panel, against how it was done before
+// [user-012]. Then drawTerminalLines printed runs of non-space cells through
+// drawChar, one virtual drawPixel per glyph pixel, and fbBlit copied the
+// window into GxEPD2_BW's page buffer with one more drawPixel per pixel.
+// Now the atlas blitter draws the cells and fbSend writes the canvas rows
+// to the controller as bytes.
+
+#include "host_bench.hpp"
+#include "host_gfx.hpp"
+
+#include "../../src/framebuffer_module.hpp"
+#include "../../src/font_module.hpp"
+
+static const char* kBench = "bench_glyph";
+
+struct Screen {
+    char rows[ROWS_PER_SCREEN][TERM_COLS + 1];
+    int crow, ccol;
+};
+
+// The old drawTerminalLines body, on its own canvas.
+static void drawGfx(GFXcanvas1& canvas, const Screen& s) {
+    char run_buf[TERM_COLS + 1];
+    canvas.setTextColor(GxEPD_BLACK);
+    for (int r = 0; r < ROWS_PER_SCREEN; r++) {
+        int y = MARGIN_Y + r * CHAR_H;
+        int c = 0;
+        while (c < TERM_COLS) {
+            if (r == s.crow && c == s.ccol) {
+                int x = MARGIN_X + c * CHAR_W;
+                canvas.fillRect(x, y, CHAR_W, CHAR_H, GxEPD_BLACK);
+                if (s.rows[r][c] != ' ') {
+                    canvas.setTextColor(GxEPD_WHITE);
+                    canvas.setCursor(x, y + 1);
+                    canvas.print(s.rows[r][c]);
+                    canvas.setTextColor(GxEPD_BLACK);
+                }
+                c++;
+                continue;
+            }
+            if (s.rows[r][c] == ' ') { c++; continue; }
+            int run_start = c;
+            int run_len = 0;
+            while (c < TERM_COLS && s.rows[r][c] != ' ' && !(r == s.crow && c == s.ccol)) {
+                run_buf[run_len++] = s.rows[r][c++];
+            }
+            run_buf[run_len] = '\0';
+            canvas.setCursor(MARGIN_X + run_start * CHAR_W, y + 1);
+            canvas.print(run_buf);
+        }
+    }
+}
+
+// The old fbBlit, inside the page loop, then what nextPage sent.
+static void sendPerPixel(GFXcanvas1& canvas, const FbRect& r) {
+    const uint8_t* buf = canvas.getBuffer();
+    for (int y = r.y; y < r.y + r.h; y++) {
+        const uint8_t* row = buf + y * FB_STRIDE;
+        for (int x = r.x; x < r.x + r.w; x++) {
+            bool white = row[x >> 3] & (0x80 >> (x & 7));
+            display.drawPixel(x, y, white ? GxEPD_WHITE : GxEPD_BLACK);
+        }
+    }
+    display.epd2.writeImagePart(display.buffer, r.x, r.y, SCREEN_W, SCREEN_H, r.x, r.y, r.w, r.h);
+    display.epd2.refresh(r.x, r.y, r.w, r.h);
+    display.epd2.writeImagePartAgain(display.buffer, r.x, r.y, SCREEN_W, SCREEN_H, r.x, r.y, r.w, r.h);
+}
+
+static void drawBlit(const Screen& s) {
+    for (int r = 0; r < ROWS_PER_SCREEN; r++) {
+        int y = MARGIN_Y + r * CHAR_H;
+        if (r == s.crow) {
+            fbDrawText(MARGIN_X, y + 1, s.rows[r], s.ccol);
+            fbDrawCursorCell(MARGIN_X + s.ccol * CHAR_W, y, s.rows[r][s.ccol]);
+            fbDrawText(MARGIN_X + (s.ccol + 1) * CHAR_W, y + 1, s.rows[r] + s.ccol + 1, TERM_COLS - s.ccol - 1);
+        } else {
+            fbDrawText(MARGIN_X, y + 1, s.rows[r], TERM_COLS);
+        }
+    }
+}
+
+static Screen denseScreen() {
+    Screen s;
+    for (int r = 0; r < ROWS_PER_SCREEN; r++) {
+        for (int c = 0; c < TERM_COLS; c++) s.rows[r][c] = (char)('!' + (r * TERM_COLS + c) % 94);
+        s.rows[r][TERM_COLS] = '\0';
+    }
+    s.crow = ROWS_PER_SCREEN / 2;
+    s.ccol = TERM_COLS / 2;
+    return s;
+}
+
+// A shell session: a prompt, a directory listing and a half-typed command.
+static Screen shellScreen() {
+    Screen s = {};
+    for (int r = 0; r < ROWS_PER_SCREEN; r++) {
+        memset(s.rows[r], ' ', TERM_COLS);
+        s.rows[r][TERM_COLS] = '\0';
+    }
+    const char* lines[] = {
+        "user@host:~/tdeck$ ls -l src",
+        "total 412",
+        "-rw-r--r-- 1 user user  5182 cli.hpp",
+        "-rw-r--r-- 1 user user  7310 font.hpp",
+        "-rw-r--r-- 1 user user 91424 main.cpp",
+        "-rw-r--r-- 1 user user 12877 net.hpp",
+        "user@host:~/tdeck$ git status",
+        "On branch main",
+        "nothing to commit, working tree clean",
+        "user@host:~/tdeck$ make -C te",
+    };
+    int n = sizeof(lines) / sizeof(lines[0]);
+    for (int r = 0; r < n; r++) memcpy(s.rows[r], lines[r], strlen(lines[r]));
+    s.crow = n - 1;
+    s.ccol = (int)strlen(lines[n - 1]);
+    return s;
+}
+
+// The whole frame is the window, as after a screen switch or a full redraw.
+static void compare(const char* what, const Screen& s) {
+    static GFXcanvas1 gfx_canvas(SCREEN_W, SCREEN_H);
+    const FbRect all = {0, 0, SCREEN_W, SCREEN_H};
+    double old_s = hostBenchSeconds([] { gfx_canvas.fillScreen(GxEPD_WHITE); }, [&] {
+        drawGfx(gfx_canvas, s);
+        sendPerPixel(gfx_canvas, all);
+    });
+    std::vector<uint8_t> old_panel(display.epd2.current, display.epd2.current + sizeof(display.epd2.current));
+    double new_s = hostBenchSeconds([] { frame_canvas.fillScreen(GxEPD_WHITE); }, [&] {
+        drawBlit(s);
+        fbSend(all, false);
+    });
+    HOST_CHECK(memcmp(gfx_canvas.getBuffer(), frame_canvas.getBuffer(), FB_STRIDE * SCREEN_H) == 0,
+               "%s: blitted frame differs from GFX", what);
+    HOST_CHECK(memcmp(old_panel.data(), display.epd2.current, old_panel.size()) == 0,
+               "%s: panel differs from the per-pixel send", what);
+    hostBenchCompare(kBench, what, old_s, new_s);
+}
+
+int main() {
+    compare("40x38 frame, every cell inked", denseScreen());
+    compare("40x38 frame, shell screen", shellScreen());
+    return hostReport(kBench);
+}
@@ -0,0 +1,106 @@
+// Notepad layout benchmark: the cursor's visual line/column and the offset
+// of the line above it, the two lookups behind cursorUp. The line index
+// answers both by binary search; before [user-002] both were scans from the
+// start of the buffer (computeLayoutFrom and cursorUp's loop, copied here).
+
+#include "host_bench.hpp"
+#include "host_editor.hpp"
+
+static const char* kBench = "bench_layout";
+static const int kLookups = 200;
+
+static LayoutInfo scanLayout(const char* buf, int len, int cpos) {
+    LayoutInfo info = {0, 0, 0};
+    int line = 0, col = 0;
+    for (int i = 0; i < len; i++) {
+        if (i == cpos) {
+            info.cursor_line = line;
+            info.cursor_col  = col;
+        }
+        if (buf[i] == '\n') {
+            line++; col = 0;
+        } else {
+            col++;
+            if (col >= COLS_PER_LINE) { line++; col = 0; }
+        }
+    }
+    if (cpos == len) {
+        info.cursor_line = line;
+        info.cursor_col  = col;
+    }
+    info.total_lines = line + 1;
+    return info;
+}
+
+static int scanOffsetAt(const char* buf, int len, int target_line, int target_col) {
+    int line = 0, col = 0;
+    for (int i = 0; i <= len; i++) {
+        if (line == target_line && col == target_col) return i;
+        if (i >= len) break;
+        if (buf[i] == '\n') {
+            if (line == target_line) return i;
+            line++; col = 0;
+        } else {
+            col++;
+            if (col >= COLS_PER_LINE) { line++; col = 0; }
+        }
+    }
+    return -1;
+}
+
+// Paragraphs from empty to three wrapped lines long.
+static std::string makeDocument(int size) {
+    std::string doc;
+    uint32_t seed = 12345;
+    while ((int)doc.size() < size) {
+        seed = seed * 1103515245u + 12345u;
+        int n = (seed >> 16) % (COLS_PER_LINE * 3);
+        for (int i = 0; i < n; i++) doc += (char)('a' + (i + n) % 26);
+        doc += '\n';
+    }
+    doc.resize(size);
+    return doc;
+}
+
+// Cursor positions spread over the document, all below the first line.
+static std::vector<int> lookupPositions(int len) {
+    std::vector<int> pos;
+    int first = COLS_PER_LINE * 4;
+    for (int k = 0; k < kLookups; k++) pos.push_back(first + (int)((int64_t)(len - first) * k / kLookups));
+    return pos;
+}
+
+int main() {
+    const int sizes[] = {4 << 10, 64 << 10, 256 << 10, 1 << 20};
+    const char* names[] = {"4 KB", "64 KB", "256 KB", "1 MB"};
+    for (int s = 0; s < 4; s++) {
+        std::string doc = makeDocument(sizes[s]);
+        std::vector<int> pos = lookupPositions((int)doc.size());
+        hostLoad(doc);
+
+        std::vector<int> old_up(kLookups), new_up(kLookups);
+        double old_s = hostBenchSeconds([] {}, [&] {
+            for (int k = 0; k < kLookups; k++) {
+                LayoutInfo li = scanLayout(doc.data(), (int)doc.size(), pos[k]);
+                old_up[k] = scanOffsetAt(doc.data(), (int)doc.size(), li.cursor_line - 1, li.cursor_col);
+            }
+        });
+        double new_s = hostBenchSeconds([] {}, [&] {
+            for (int k = 0; k < kLookups; k++) {
+                LayoutInfo li = textComputeLayout(pos[k]);
+                new_up[k] = textOffsetAt(li.cursor_line - 1, li.cursor_col);
+            }
+        });
+        for (int k = 0; k < kLookups; k++) {
+            HOST_CHECK(old_up[k] == new_up[k], "%s: line above %d is %d, scan says %d", names[s], pos[k], new_up[k],
+                       old_up[k]);
+        }
+        HOST_CHECK(textTotalLines() == scanLayout(doc.data(), (int)doc.size(), 0).total_lines,
+                   "%s: line count differs", names[s]);
+
+        char what[64];
+        snprintf(what, sizeof(what), "cursor up x%d, %s doc", kLookups, names[s]);
+        hostBenchCompare(kBench, what, old_s, new_s);
+    }
+    return hostReport(kBench);
+}
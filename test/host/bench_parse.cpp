@@ -0,0 +1,83 @@
+// Terminal parse benchmark: the test_term captures and a plain-text flood
+// (cat of a file) through terminalAppendOutput, with the bulk path for
+// printable runs against sending every byte through the state machine.
+// [user-016] added the bulk path to the old branch-ladder parser, which
+// [user-017] replaced; the per-byte side here is today's parser without
+// the bulk path, so the difference is the bulk path alone.
+
+#include "host_bench.hpp"
+#include "host_term.hpp"
+
+#include <fstream>
+#include <sstream>
+
+static const char* kBench = "bench_parse";
+
+static void perByteAppend(const char* data, int len) {
+    const unsigned char* bytes = (const unsigned char*)data;
+    for (int i = 0; i < len; i++) {
+        unsigned char c = bytes[i];
+        terminalDebugTraceRecord(c);
+        if (utf8_remaining > 0 && (c & 0xC0) != 0x80) utf8_remaining = 0;
+        uint8_t t = vt_table[vt_state][vtByteClass(c)];
+        vt_state = t & 0x0F;
+        terminalParserAction(t >> 4, c);
+    }
+    if (term_cursor_row >= term_scroll + ROWS_PER_SCREEN) {
+        term_scroll = term_cursor_row - ROWS_PER_SCREEN + 1;
+    }
+    if (term_cursor_row < term_scroll) {
+        term_scroll = term_cursor_row;
+    }
+}
+
+static std::string readFile(const std::string& path) {
+    std::ifstream in(path, std::ios::binary);
+    std::stringstream ss;
+    ss << in.rdbuf();
+    return ss.str();
+}
+
+// 256 KB of prose-like lines, some longer than a row.
+static std::string floodText() {
+    std::string out;
+    for (int n = 0; out.size() < (256 << 10); n++) {
+        char line[160];
+        int len = snprintf(line, sizeof(line), "%05d the quick brown fox jumps over the lazy dog%s\r\n", n,
+                           n % 3 ? "" : " and keeps on running past the end of the row");
+        out.append(line, len);
+    }
+    return out;
+}
+
+// Feed in 1 KB reads, about what one SSH read hands the parser.
+template <typename Append>
+static void feed(const std::string& s, Append append) {
+    for (size_t off = 0; off < s.size(); off += 1024) {
+        size_t n = s.size() - off < 1024 ? s.size() - off : 1024;
+        append(s.data() + off, (int)n);
+    }
+}
+
+static void compare(const char* what, const std::string& bytes) {
+    HOST_CHECK(!bytes.empty(), "%s: no input (run from test/host)", what);
+    double old_s = hostBenchSeconds(hostTermReset, [&] { feed(bytes, perByteAppend); });
+    std::vector<std::string> old_rows;
+    for (int r = 0; r < ROWS_PER_SCREEN; r++) old_rows.push_back(hostTermRow(r));
+    int old_row = term_cursor_row, old_col = term_cursor_col;
+
+    double new_s = hostBenchSeconds(hostTermReset, [&] { feed(bytes, terminalAppendOutput); });
+    for (int r = 0; r < ROWS_PER_SCREEN; r++) {
+        HOST_CHECK(hostTermRow(r) == old_rows[r], "%s: row %d differs", what, r);
+    }
+    HOST_CHECK(term_cursor_row == old_row && term_cursor_col == old_col, "%s: cursor differs", what);
+    hostBenchCompareRate(kBench, what, (double)bytes.size(), old_s, new_s);
+}
+
+int main() {
+    compare("vim capture", readFile("fixtures/vim.raw"));
+    compare("tmux capture", readFile("fixtures/tmux.raw"));
+    compare("top capture", readFile("fixtures/top.raw"));
+    compare("plain text flood, 256 KB", floodText());
+    return hostReport(kBench);
+}
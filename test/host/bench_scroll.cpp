@@ -0,0 +1,120 @@
+// Terminal scroll benchmark: line feeds at the bottom of the screen or of a
+// scroll region, each followed by a line of text, through the row-pointer
+// ring against the row copies it replaced (terminalScrollRegionUp before
+// [user-014]). Rates are bytes of text scrolled through per second. The main
+// screen case is the whole change: the old 100-row buffer that doubled as
+// scrollback against the 38-row ring feeding the PSRAM history. The output
+// cases feed newline-heavy text through terminalAppendOutput, so the rate is
+// bytes of output processed with the parser, the dirty marks and the
+// prediction bookkeeping around each scroll. The emulator the ring replaced
+// is not kept, so those report the current rate only.
+
+#include "host_bench.hpp"
+#include "host_term.hpp"
+
+static const char* kBench = "bench_scroll";
+static const int kLines = 100000;
+static const int kOldRows = 100;
+
+static char old_buf[kOldRows][TERM_COLS + 1];
+
+static void oldScrollUp(int rows, int top, int bot) {
+    if (top < 0) top = 0;
+    if (bot >= rows) bot = rows - 1;
+    for (int i = top; i < bot; i++) {
+        memcpy(old_buf[i], old_buf[i + 1], TERM_COLS + 1);
+    }
+    memset(old_buf[bot], ' ', TERM_COLS);
+    old_buf[bot][TERM_COLS] = '\0';
+}
+
+static void oldClear() {
+    for (int i = 0; i < kOldRows; i++) {
+        memset(old_buf[i], ' ', TERM_COLS);
+        old_buf[i][TERM_COLS] = '\0';
+    }
+}
+
+// Lines written after each scroll, made up front so the loop is the scroll.
+static char line_text[64][TERM_COLS + 1];
+
+// Both sides write the line through this one copy. Inlined, GCC picked
+// rep movs for one side and vector moves for the other, and rep movs'
+// startup cost outweighed the scroll being measured.
+__attribute__((noinline)) static void putLine(char* row, int n) {
+    memcpy(row, line_text[n & 63], TERM_COLS);
+}
+
+static void makeLines() {
+    for (int n = 0; n < 64; n++) {
+        memset(line_text[n], ' ', TERM_COLS);
+        int len = snprintf(line_text[n], TERM_COLS + 1, "line %d of the output being scrolled", n);
+        line_text[n][len] = ' ';
+    }
+}
+
+// Scroll rows top..bot kLines times; old_rows is the old buffer's height.
+static void compare(const char* what, bool alt, int top, int bot, int old_rows) {
+    int old_bot = bot + (old_rows - ROWS_PER_SCREEN);
+    double old_s = hostBenchSeconds(oldClear, [&] {
+        for (int n = 0; n < kLines; n++) {
+            oldScrollUp(old_rows, top, old_bot);
+            putLine(old_buf[old_bot], n);
+        }
+    });
+    double new_s = hostBenchSeconds([&] {
+        hostTermReset();
+        if (alt) enterAltScreen();
+    }, [&] {
+        for (int n = 0; n < kLines; n++) {
+            terminalScrollRegionUp(top, bot);
+            putLine(termRow(bot), n);
+        }
+    });
+    int shift = old_rows - ROWS_PER_SCREEN;
+    for (int r = 0; r < ROWS_PER_SCREEN; r++) {
+        HOST_CHECK(memcmp(termRow(r), old_buf[r + (r >= top ? shift : 0)], TERM_COLS) == 0,
+                   "%s: row %d differs", what, r);
+    }
+    hostBenchCompareRate(kBench, what, (double)kLines * TERM_COLS, old_s, new_s);
+}
+
+// One short line per scroll, after setup (an alternate screen, a region).
+static std::string lineOutput(const char* setup) {
+    std::string out = setup;
+    for (int n = 0; n < kLines; n++) {
+        out += line_text[n & 63];
+        out.resize(out.find_last_not_of(' ') + 1);
+        out += "\r\n";
+    }
+    return out;
+}
+
+// Fed in 1 KB reads, as bench_parse does.
+static void output(const char* what, const char* setup, int bot) {
+    std::string out = lineOutput(setup);
+    std::string last = line_text[(kLines - 1) & 63];
+    last.resize(last.find_last_not_of(' ') + 1);
+    double s = hostBenchSeconds(hostTermReset, [&] {
+        for (size_t off = 0; off < out.size(); off += 1024) {
+            size_t n = out.size() - off < 1024 ? out.size() - off : 1024;
+            terminalAppendOutput(out.data() + off, (int)n);
+        }
+    });
+    // The last line sits one row above the cursor at the bottom of the region.
+    HOST_CHECK(term_cursor_row == bot && hostTermRow(bot - 1) == last, "%s: row %d \"%s\", want \"%s\"", what,
+               bot - 1, hostTermRow(bot - 1).c_str(), last.c_str());
+    hostBenchRate(kBench, what, (double)out.size(), s);
+}
+
+int main() {
+    makeLines();
+    compare("main screen, 100-row buffer vs ring", false, 0, TERM_ROWS - 1, kOldRows);
+    compare("alt screen, full", true, 0, ROWS_PER_SCREEN - 1, ROWS_PER_SCREEN);
+    compare("alt screen, region 1-36", true, 1, ROWS_PER_SCREEN - 2, ROWS_PER_SCREEN);
+    HOST_CHECK(termHistoryCount() == 0, "alt screen scrolls reached the history");
+    output("output, main screen", "", ROWS_PER_SCREEN - 1);
+    output("output, alt screen", "\x1b[?1049h", ROWS_PER_SCREEN - 1);
+    output("output, alt region 2-37", "\x1b[?1049h\x1b[2;37r\x1b[37;1H", ROWS_PER_SCREEN - 2);
+    return hostReport(kBench);
+}
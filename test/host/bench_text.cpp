@@ -0,0 +1,81 @@
+// Notepad edit benchmark: typing and backspace through the piece table
+// against the flat buffer it replaced, where every key moved the text after
+// the cursor (keyboard_module before [user-001]). The flat buffer here is
+// sized to the case; on the device it was capped at 4 KB.
+
+#include "host_bench.hpp"
+#include "host_editor.hpp"
+
+static const char* kBench = "bench_text";
+static const int kTyped = 100000;
+static const char kWords[] = "the quick brown fox jumps over the lazy dog\n";
+
+static std::vector<char> flat_buf;
+static int flat_len = 0;
+static int flat_cursor = 0;
+
+static void flatLoad(const std::string& doc, int cursor, int room) {
+    flat_buf.assign(doc.size() + room + 1, 0);
+    memcpy(flat_buf.data(), doc.data(), doc.size());
+    flat_len = (int)doc.size();
+    flat_cursor = cursor;
+}
+
+static void flatInsert(char c) {
+    memmove(&flat_buf[flat_cursor + 1], &flat_buf[flat_cursor], flat_len - flat_cursor);
+    flat_buf[flat_cursor] = c;
+    flat_len++;
+    flat_cursor++;
+    flat_buf[flat_len] = '\0';
+}
+
+static void flatBackspace() {
+    if (flat_cursor == 0) return;
+    memmove(&flat_buf[flat_cursor - 1], &flat_buf[flat_cursor], flat_len - flat_cursor);
+    flat_len--;
+    flat_cursor--;
+    flat_buf[flat_len] = '\0';
+}
+
+static std::string makeDocument(int size) {
+    std::string doc;
+    while ((int)doc.size() < size) doc += kWords;
+    doc.resize(size);
+    return doc;
+}
+
+static void typeThenErase(const std::string& doc, int at, bool erase, const char* what) {
+    double old_s = hostBenchSeconds([&] { flatLoad(doc, at, kTyped); }, [&] {
+        for (int i = 0; i < kTyped; i++) flatInsert(kWords[i % (sizeof(kWords) - 1)]);
+        if (erase) for (int i = 0; i < kTyped; i++) flatBackspace();
+    });
+    std::string flat(flat_buf.data(), flat_len);
+
+    double new_s = hostBenchSeconds([&] {
+        hostLoad(doc);
+        cursor_pos = at;
+    }, [&] {
+        for (int i = 0; i < kTyped; i++) textInsert(kWords[i % (sizeof(kWords) - 1)]);
+        if (erase) for (int i = 0; i < kTyped; i++) textBackspace();
+    });
+    HOST_CHECK(hostDocument() == flat, "%s: documents differ", what);
+    HOST_CHECK(cursor_pos == flat_cursor, "%s: cursor %d, want %d", what, cursor_pos, flat_cursor);
+    hostBenchCompare(kBench, what, old_s, new_s);
+}
+
+int main() {
+    const int sizes[] = {4 << 10, 64 << 10, 1 << 20};
+    const char* names[] = {"4 KB", "64 KB", "1 MB"};
+    char what[64];
+    for (int i = 0; i < 3; i++) {
+        std::string doc = makeDocument(sizes[i]);
+        snprintf(what, sizeof(what), "tail: type+erase 100k, %s doc", names[i]);
+        typeThenErase(doc, (int)doc.size(), true, what);
+    }
+    for (int i = 0; i < 3; i++) {
+        std::string doc = makeDocument(sizes[i]);
+        snprintf(what, sizeof(what), "middle: type 100k, %s doc", names[i]);
+        typeThenErase(doc, (int)doc.size() / 2, false, what);
+    }
+    return hostReport(kBench);
+}
@@ -0,0 +1,158 @@
+#!/usr/bin/env python3
+"""Record terminal captures for test_term and the terminal benchmarks.
+
+Each app runs in a pty the size of the device terminal (40x38, TERM=xterm,
+as network_module requests) and is driven by a fixed key script. The raw
+output goes to <app>.raw. At each checkpoint the bytes so far are replayed
+into a detached tmux pane of the same size and its screen and cursor are
+saved to <app>.grids as the reference:
+
+    @ <byte offset> <cursor row> <cursor col>
+    <38 rows, UTF-8, trailing spaces trimmed>
+
+htop is not installed in the recording environment; top stands in for it.
+Recording needs vim, tmux and top; the tests only read the files.
+"""
+
+import fcntl
+import os
+import pty
+import select
+import struct
+import subprocess
+import sys
+import tempfile
+import termios
+import time
+
+COLS, ROWS = 40, 38
+HERE = os.path.dirname(os.path.abspath(__file__))
+CHECKPOINT = object()
+
+
+def vim_script(workdir):
+    path = os.path.join(workdir, "notes.txt")
+    with open(path, "w") as f:
+        for i in range(1, 81):
+            f.write("line %02d: the quick brown fox jumps over the lazy dog%s\n"
+                    % (i, " again and again" * (i % 3)))
+    cmd = ["vim", "-u", "NONE", "-N", "-i", "NONE", "-n", path]
+    keys = [
+        (1.5, ":set nu\r"), (0.4, "G"), (0.4, "gg"), (0.4, "20j"), (0.4, "/brown\r"),
+        (0.4, "n"), (0.4, "ofresh line typed in insert mode"), (0.4, "\x1b"), (0.4, "dd"),
+        (0.4, "u"), (0.4, ":%s/fox/cat/g\r"), (0.4, "\x06"), (0.4, "\x02"), (0.4, "10l"),
+        (0.6, CHECKPOINT), (0.0, ":q!\r"), (1.0, None),
+    ]
+    return cmd, keys
+
+
+def tmux_script(workdir):
+    conf = os.path.join(workdir, "tmux.conf")
+    with open(conf, "w") as f:
+        f.write('set -g default-command "/bin/sh"\nset -g escape-time 0\n')
+    cmd = ["tmux", "-L", "tdeck-capture", "-f", conf, "new-session"]
+    keys = [
+        (1.5, "seq 1 50\r"), (0.6, '\x02"'), (0.6, "echo hello from the lower pane\r"),
+        (0.6, "\x02%"), (0.6, "ls /\r"), (0.6, "\x02o"),
+        (0.6, 'printf "wrap %s " $(seq 1 30); echo\r'), (0.8, CHECKPOINT),
+        (0.0, "exit\r"), (0.6, "exit\r"), (0.6, "exit\r"), (1.0, None),
+    ]
+    return cmd, keys
+
+
+def top_script(workdir):
+    cmd = ["top", "-d", "0.5"]
+    keys = [(3.0, CHECKPOINT), (0.0, "q"), (1.0, None)]
+    return cmd, keys
+
+
+APPS = {"vim": vim_script, "tmux": tmux_script, "top": top_script}
+
+
+def run(cmd, keys, workdir):
+    env = dict(os.environ, TERM="xterm", LANG="C.UTF-8", LC_ALL="C.UTF-8",
+               PS1="$ ", HOME=workdir, ENV="")
+    pid, fd = pty.fork()
+    if pid == 0:
+        os.chdir(workdir)
+        os.execvpe(cmd[0], cmd, env)
+    fcntl.ioctl(fd, termios.TIOCSWINSZ, struct.pack("HHHH", ROWS, COLS, 0, 0))
+    out = bytearray()
+    checkpoints = []
+
+    def drain(seconds):
+        end = time.time() + seconds
+        while True:
+            left = end - time.time()
+            if left <= 0:
+                return
+            r, _, _ = select.select([fd], [], [], left)
+            if not r:
+                continue
+            try:
+                data = os.read(fd, 65536)
+            except OSError:
+                return
+            if not data:
+                return
+            out.extend(data)
+
+    for delay, key in keys:
+        drain(delay)
+        if key is CHECKPOINT:
+            checkpoints.append(len(out))
+        elif key is not None:
+            os.write(fd, key.encode())
+    drain(0.5)
+    try:
+        os.kill(pid, 9)
+    except OSError:
+        pass
+    os.waitpid(pid, 0)
+    checkpoints.append(len(out))
+    return bytes(out), checkpoints
+
+
+def reference(data, workdir):
+    """Screen and cursor tmux shows after the bytes."""
+    raw = os.path.join(workdir, "ref.raw")
+    with open(raw, "wb") as f:
+        f.write(data)
+    conf = os.path.join(workdir, "ref.conf")
+    with open(conf, "w") as f:
+        f.write("set -g status off\n")
+    tmux = ["tmux", "-L", "tdeck-ref", "-f", conf]
+    subprocess.run(tmux + ["kill-server"], stderr=subprocess.DEVNULL)
+    subprocess.run(tmux + ["new-session", "-d", "-x", str(COLS), "-y", str(ROWS),
+                           "stty -echo; cat %s; sleep 60" % raw], check=True,
+                   env=dict(os.environ, LANG="C.UTF-8", LC_ALL="C.UTF-8"))
+    time.sleep(1.0)
+    size = subprocess.run(tmux + ["display", "-p", "#{pane_width}x#{pane_height}"],
+                          capture_output=True, text=True, check=True).stdout.strip()
+    assert size == "%dx%d" % (COLS, ROWS), size
+    screen = subprocess.run(tmux + ["capture-pane", "-p"], capture_output=True, check=True).stdout
+    cursor = subprocess.run(tmux + ["display", "-p", "#{cursor_y} #{cursor_x}"],
+                            capture_output=True, text=True, check=True).stdout.split()
+    subprocess.run(tmux + ["kill-server"], stderr=subprocess.DEVNULL)
+    rows = screen.decode("utf-8").split("\n")[:ROWS]
+    rows += [""] * (ROWS - len(rows))
+    return int(cursor[0]), int(cursor[1]), [r.rstrip(" ") for r in rows]
+
+
+def main(names):
+    for name in names or sorted(APPS):
+        with tempfile.TemporaryDirectory() as workdir:
+            cmd, keys = APPS[name](workdir)
+            data, checkpoints = run(cmd, keys, workdir)
+            with open(os.path.join(HERE, name + ".raw"), "wb") as f:
+                f.write(data)
+            with open(os.path.join(HERE, name + ".grids"), "w", encoding="utf-8") as f:
+                for off in checkpoints:
+                    row, col, rows = reference(data[:off], workdir)
+                    f.write("@ %d %d %d\n" % (off, row, col))
+                    f.write("\n".join(rows) + "\n")
+            print("%s: %d bytes, checkpoints %s" % (name, len(data), checkpoints))
+
+
+if __name__ == "__main__":
+    main(sys.argv[1:])
@@ -0,0 +1,57 @@
+#pragma once
+
+// --- Host Benchmarks ---
+//
+// Wall-clock timing for the bench_* programs. A case runs at least three
+// times and until 200 ms have gone by; the fastest run is reported, which
+// keeps scheduler noise out of small cases. Each bench pits the code a
+// request replaced (copied from before it, in the bench file) against the
+// module as it is now, and checks both produce the same result. Cases with
+// no old code to run report the module's throughput alone.
+
+#include "host_env.hpp"
+
+#include <chrono>
+
+template <typename Setup, typename Run>
+static double hostBenchSeconds(Setup setup, Run run) {
+    using clock = std::chrono::steady_clock;
+    double best = 1e30;
+    clock::duration total{};
+    for (int n = 0; n < 3 || total < std::chrono::milliseconds(200); n++) {
+        setup();
+        clock::time_point t0 = clock::now();
+        run();
+        clock::duration d = clock::now() - t0;
+        total += d;
+        double s = std::chrono::duration<double>(d).count();
+        if (s < best) best = s;
+    }
+    return best;
+}
+
+static void hostBenchPrintTime(double s) {
+    if (s >= 1.0) printf("%8.2f s ", s);
+    else if (s >= 1e-3) printf("%8.2f ms", s * 1e3);
+    else printf("%8.2f us", s * 1e6);
+}
+
+// One line: the case, old and new time per run, and the speedup.
+static void hostBenchCompare(const char* bench, const char* what, double old_s, double new_s) {
+    printf("%s: %-34s old ", bench, what);
+    hostBenchPrintTime(old_s);
+    printf("  new ");
+    hostBenchPrintTime(new_s);
+    printf("  x%.1f\n", old_s / new_s);
+}
+
+// Same, as throughput over the bytes one run moves.
+static void hostBenchCompareRate(const char* bench, const char* what, double bytes, double old_s, double new_s) {
+    printf("%s: %-34s old %8.1f MB/s  new %8.1f MB/s  x%.1f\n", bench, what, bytes / old_s / 1e6,
+           bytes / new_s / 1e6, old_s / new_s);
+}
+
+// Throughput alone, for a case with nothing to compare against.
+static void hostBenchRate(const char* bench, const char* what, double bytes, double s) {
+    printf("%s: %-34s %8.1f MB/s\n", bench, what, bytes / s / 1e6);
+}
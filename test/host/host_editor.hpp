@@ -0,0 +1,109 @@
+#pragma once
+
+// --- Host Editor ---
+//
+// The notepad document stack (piece table, edit journal, storage worker)
+// over host_env, with the main.cpp globals it reads. The storage queue is
+// never created, so saves run inline like they do at boot.
+
+#include "host_env.hpp"
+
+enum RenderHint : uint32_t {
+    RENDER_EDITOR   = 1U << 0,
+    RENDER_TERMINAL = 1U << 1,
+    RENDER_STATUS   = 1U << 2,
+    RENDER_SCROLL   = 1U << 3,
+    RENDER_TYPING   = 1U << 4,
+    RENDER_OUTPUT   = 1U << 5,
+};
+
+static void requestRender(uint32_t hints) { (void)hints; }
+
+static char host_cmd_result[128];
+
+void cmdSetResult(const char* fmt, ...) {
+    va_list ap;
+    va_start(ap, fmt);
+    vsnprintf(host_cmd_result, sizeof(host_cmd_result), fmt, ap);
+    va_end(ap);
+}
+
+void journalNoteInsert(int off, char c);
+void journalNoteErase(int off);
+void journalDetach();
+
+static SemaphoreHandle_t state_mutex = NULL;
+static bool sd_mounted = true;
+static String current_file = "";
+static bool file_modified = false;
+static bool file_is_remote = false;
+static int  text_len    = 0;
+static int  cursor_pos  = 0;
+static int  scroll_line = 0;
+
+struct LayoutInfo {
+    int total_lines;
+    int cursor_line;
+    int cursor_col;
+};
+
+void sdAcquire() {}
+void sdRelease() {}
+
+#include "../../src/text_buffer_module.hpp"
+#include "../../src/journal_module.hpp"
+#include "../../src/storage_module.hpp"
+
+// Same as main.cpp's loadFromFile.
+bool loadFromFile(const char* path) {
+    storageWaitIdle();
+    sdAcquire();
+    journalRecoverPath(path);
+    File f = SD.open(path, FILE_READ);
+    if (!f) { sdRelease(); return false; }
+    size_t sz = f.size();
+    char* data = (char*)textAlloc(sz + 1);
+    if (!data) { f.close(); sdRelease(); return false; }
+    size_t got = 0;
+    uint32_t crc = 0;
+    while (got < sz) {
+        size_t chunk = sz - got > 4096 ? 4096 : sz - got;
+        int n = f.read((uint8_t*)data + got, chunk);
+        if (n <= 0) break;
+        crc = crc32_le(crc, (const uint8_t*)data + got, n);
+        got += n;
+    }
+    f.close();
+    if (!textAdoptOriginal(data, (int)got)) { sdRelease(); return false; }
+    journalAttach(path, (uint32_t)got, crc);
+    if (!journalReplay(path)) journalCompactNow(path);
+    sdRelease();
+    scroll_line = 0;
+    file_modified = false;
+    return true;
+}
+
+// --- Helpers ---
+
+// Open doc as if just read from a file, cursor at the end.
+static void hostLoad(const std::string& doc) {
+    char* data = (char*)textAlloc(doc.size() + 1);
+    memcpy(data, doc.data(), doc.size());
+    textAdoptOriginal(data, (int)doc.size());
+}
+
+static std::string hostDocument() {
+    std::string s(text_len, '\0');
+    textCopyOut(0, text_len, &s[0]);
+    return s;
+}
+
+static void hostType(int at, const char* s) {
+    cursor_pos = at;
+    for (; *s; s++) textInsert(*s);
+}
+
+static void hostErase(int at, int n) {
+    cursor_pos = at;
+    for (int i = 0; i < n; i++) textBackspace();
+}
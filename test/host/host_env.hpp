@@ -0,0 +1,260 @@
+#pragma once
+
+// --- Host Environment ---
+//
+// Just enough of Arduino, FreeRTOS and the SD library for the header-only
+// firmware modules to compile and run under g++. Time is a fake clock the
+// tests advance; locks and critical sections are no-ops (one thread).
+//
+// SD is an in-memory FAT stand-in with power-cut injection: every byte
+// written and every create, remove and rename spends one unit of
+// host_sd_budget. When the budget runs out mid-operation the write is torn
+// there and the card is dead until hostSdPowerOn(), as after a power loss.
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <rom/crc.h>
+
+#include "../../src/firmware/layout.h"
+
+#define SERIAL_LOG_BEGIN(baud) do { (void)(baud); } while (0)
+#define SERIAL_LOGF(...) do {} while (0)
+#define SERIAL_LOG(...) do {} while (0)
+#define SERIAL_LOGLN(...) do {} while (0)
+
+#define IRAM_ATTR
+
+// --- Time ---
+
+static uint32_t host_now_ms = 0;
+
+static inline uint32_t millis() { return host_now_ms; }
+static inline uint32_t micros() { return host_now_ms * 1000U; }
+
+// --- Memory ---
+
+static inline void* ps_malloc(size_t size) { return malloc(size); }
+static inline void* ps_realloc(void* ptr, size_t size) { return realloc(ptr, size); }
+
+// --- FreeRTOS ---
+
+typedef uint32_t TickType_t;
+typedef int BaseType_t;
+typedef void* SemaphoreHandle_t;
+typedef void* QueueHandle_t;
+typedef void* TaskHandle_t;
+typedef int portMUX_TYPE;
+
+#define pdTRUE  1
+#define pdFALSE 0
+#define pdMS_TO_TICKS(ms) ((TickType_t)(ms))
+#define portMAX_DELAY ((TickType_t)0xFFFFFFFFU)
+#define portMUX_INITIALIZER_UNLOCKED 0
+#define portENTER_CRITICAL(mux) do { (void)(mux); } while (0)
+#define portEXIT_CRITICAL(mux) do { (void)(mux); } while (0)
+#define taskYIELD() do {} while (0)
+
+enum eNotifyAction { eSetBits };
+
+static inline BaseType_t xSemaphoreTake(SemaphoreHandle_t, TickType_t) { return pdTRUE; }
+static inline BaseType_t xSemaphoreGive(SemaphoreHandle_t) { return pdTRUE; }
+static inline void vTaskDelay(TickType_t ticks) { host_now_ms += ticks; }
+static inline void xTaskNotifyGive(TaskHandle_t) {}
+static inline BaseType_t xTaskNotify(TaskHandle_t, uint32_t, eNotifyAction) { return pdTRUE; }
+static inline uint32_t ulTaskNotifyTake(BaseType_t, TickType_t) { return 0; }
+
+// Modules only create queues and tasks from their start functions, which
+// the host tests never call; a NULL queue selects their inline paths.
+static inline QueueHandle_t xQueueCreate(int, size_t) { return NULL; }
+static inline BaseType_t xQueueSend(QueueHandle_t, const void*, TickType_t) { return pdFALSE; }
+static inline BaseType_t xQueuePeek(QueueHandle_t, void*, TickType_t) { return pdFALSE; }
+static inline BaseType_t xQueueReceive(QueueHandle_t, void*, TickType_t) { return pdFALSE; }
+static inline int uxQueueMessagesWaiting(QueueHandle_t) { return 0; }
+static inline int uxQueueSpacesAvailable(QueueHandle_t) { return 0; }
+static inline BaseType_t xTaskCreatePinnedToCore(void (*)(void*), const char*, uint32_t, void*, int,
+                                                 TaskHandle_t*, int) {
+    return pdFALSE;
+}
+
+// --- Arduino String ---
+
+class String {
+public:
+    String() {}
+    String(const char* s) : s_(s ? s : "") {}
+    String(const std::string& s) : s_(s) {}
+    const char* c_str() const { return s_.c_str(); }
+    unsigned int length() const { return (unsigned int)s_.size(); }
+    String substring(unsigned int from, unsigned int to) const { return String(s_.substr(from, to - from)); }
+    String operator+(const String& o) const { return String(s_ + o.s_); }
+    String operator+(const char* o) const { return String(s_ + o); }
+    bool operator==(const String& o) const { return s_ == o.s_; }
+    bool operator==(const char* o) const { return s_ == (o ? o : ""); }
+    bool operator!=(const String& o) const { return s_ != o.s_; }
+private:
+    std::string s_;
+};
+
+// --- SD ---
+
+#define FILE_READ   "r"
+#define FILE_WRITE  "w"
+#define FILE_APPEND "a"
+
+static std::map<std::string, std::string> host_sd_files;
+static long host_sd_budget = -1;     // units left before the power cut, -1 = none
+static bool host_sd_dead = false;
+static long host_sd_spent = 0;       // units spent since hostSdReset
+
+// Spend up to n units; returns how many the card still performs.
+static size_t hostSdSpend(size_t n) {
+    if (host_sd_dead) return 0;
+    size_t ok = n;
+    if (host_sd_budget >= 0 && (long)n > host_sd_budget) {
+        ok = (size_t)host_sd_budget;
+        host_sd_dead = true;
+    }
+    if (host_sd_budget >= 0) host_sd_budget -= (long)ok;
+    host_sd_spent += (long)ok;
+    return ok;
+}
+
+static void hostSdReset() {
+    host_sd_files.clear();
+    host_sd_budget = -1;
+    host_sd_dead = false;
+    host_sd_spent = 0;
+}
+
+// Power comes back: the card works again with whatever landed.
+static void hostSdPowerOn() {
+    host_sd_budget = -1;
+    host_sd_dead = false;
+}
+
+class File {
+public:
+    File() {}
+    explicit operator bool() const { return (bool)impl_; }
+
+    size_t write(const uint8_t* buf, size_t len) {
+        if (!impl_ || impl_->dir) return 0;
+        auto it = host_sd_files.find(impl_->path);
+        if (it == host_sd_files.end()) return 0;
+        size_t n = hostSdSpend(len);
+        it->second.append((const char*)buf, n);
+        return n;
+    }
+    size_t read(uint8_t* buf, size_t len) {
+        if (!impl_ || impl_->dir) return 0;
+        auto it = host_sd_files.find(impl_->path);
+        if (it == host_sd_files.end() || impl_->pos >= it->second.size()) return 0;
+        size_t n = it->second.size() - impl_->pos;
+        if (n > len) n = len;
+        memcpy(buf, it->second.data() + impl_->pos, n);
+        impl_->pos += n;
+        return n;
+    }
+    size_t size() const {
+        if (!impl_) return 0;
+        auto it = host_sd_files.find(impl_->path);
+        return it == host_sd_files.end() ? 0 : it->second.size();
+    }
+    const char* name() const { return impl_ ? impl_->name.c_str() : ""; }
+    bool isDirectory() const { return impl_ && impl_->dir; }
+    void close() { impl_.reset(); }
+
+    // Flat root listing only.
+    File openNextFile() {
+        File f;
+        if (!impl_ || !impl_->dir) return f;
+        auto it = host_sd_files.upper_bound(impl_->cursor);
+        if (impl_->cursor.empty()) it = host_sd_files.begin();
+        if (it == host_sd_files.end()) return f;
+        impl_->cursor = it->first;
+        f.impl_ = std::make_shared<Impl>();
+        f.impl_->path = it->first;
+        f.impl_->name = it->first.substr(it->first.rfind('/') + 1);
+        return f;
+    }
+
+private:
+    struct Impl {
+        std::string path;
+        std::string name;
+        bool dir = false;
+        size_t pos = 0;
+        std::string cursor;   // directory listing position
+    };
+    std::shared_ptr<Impl> impl_;
+    friend class HostSD;
+};
+
+class HostSD {
+public:
+    File open(const char* path, const char* mode = FILE_READ) {
+        File f;
+        std::string p = path;
+        if (p == "/") {
+            f.impl_ = std::make_shared<File::Impl>();
+            f.impl_->path = p;
+            f.impl_->dir = true;
+            return f;
+        }
+        bool exists = host_sd_files.count(p) > 0;
+        if (mode[0] == 'r') {
+            if (!exists) return f;
+        } else if (mode[0] == 'w' || !exists) {
+            if (hostSdSpend(1) == 0) return f;   // create / truncate
+            host_sd_files[p].clear();
+        }
+        f.impl_ = std::make_shared<File::Impl>();
+        f.impl_->path = p;
+        f.impl_->name = p.substr(p.rfind('/') + 1);
+        return f;
+    }
+    bool exists(const char* path) { return host_sd_files.count(path) > 0; }
+    bool remove(const char* path) {
+        if (!host_sd_files.count(path) || hostSdSpend(1) == 0) return false;
+        host_sd_files.erase(path);
+        return true;
+    }
+    // Like FAT: fails when the target exists.
+    bool rename(const char* from, const char* to) {
+        if (!host_sd_files.count(from) || host_sd_files.count(to) || hostSdSpend(1) == 0) return false;
+        host_sd_files[to] = host_sd_files[from];
+        host_sd_files.erase(from);
+        return true;
+    }
+};
+
+static HostSD SD;
+
+// --- Test Helpers ---
+
+static int host_failures = 0;
+
+#define HOST_CHECK(cond, ...) do { \
+    if (!(cond)) { \
+        host_failures++; \
+        fprintf(stderr, "%s:%d: check failed: %s: ", __FILE__, __LINE__, #cond); \
+        fprintf(stderr, __VA_ARGS__); \
+        fputc('\n', stderr); \
+    } \
+} while (0)
+
+static int hostReport(const char* name) {
+    if (host_failures) fprintf(stderr, "%s: %d failures\n", name, host_failures);
+    else printf("%s: ok\n", name);
+    return host_failures ? 1 : 0;
+}
@@ -0,0 +1,152 @@
+#pragma once
+
+// --- Host Display ---
+//
+// GFXcanvas1 and the GxEPD2 panel as far as framebuffer_module and
+// font_module use them. The canvas keeps Adafruit GFX's shape: drawPixel is
+// virtual and drawChar/print go through it pixel by pixel, so benchmarks
+// against it see the cost the glyph blitter removes. The panel records
+// what the partial windows wrote, so tests can compare it with the canvas.
+
+#include "host_env.hpp"
+#include "glcdfont.h"
+
+#define GxEPD_BLACK 0x0000
+#define GxEPD_WHITE 0xFFFF
+
+struct GFXfont;
+
+class GFXcanvas1 {
+public:
+    GFXcanvas1(int16_t w, int16_t h) : w_(w), h_(h), buf_((w + 7) / 8 * h, 0) {}
+    virtual ~GFXcanvas1() {}
+
+    uint8_t* getBuffer() { return buf_.data(); }
+    int16_t width() const { return w_; }
+    int16_t height() const { return h_; }
+
+    virtual void drawPixel(int16_t x, int16_t y, uint16_t color) {
+        if (x < 0 || y < 0 || x >= w_ || y >= h_) return;
+        uint8_t* p = &buf_[(x / 8) + y * ((w_ + 7) / 8)];
+        if (color) *p |= 0x80 >> (x & 7);
+        else *p &= ~(0x80 >> (x & 7));
+    }
+    void fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color) {
+        for (int16_t j = y; j < y + h; j++) {
+            for (int16_t i = x; i < x + w; i++) drawPixel(i, j, color);
+        }
+    }
+    void fillScreen(uint16_t color) { memset(buf_.data(), color ? 0xFF : 0x00, buf_.size()); }
+    void drawLine(int16_t x0, int16_t y0, int16_t x1, int16_t y1, uint16_t color) {
+        if (y0 == y1) fillRect(x0 < x1 ? x0 : x1, y0, (x1 > x0 ? x1 - x0 : x0 - x1) + 1, 1, color);
+        else if (x0 == x1) fillRect(x0, y0 < y1 ? y0 : y1, 1, (y1 > y0 ? y1 - y0 : y0 - y1) + 1, color);
+    }
+
+    // Adafruit_GFX::drawChar for the classic font at size 1.
+    void drawChar(int16_t x, int16_t y, unsigned char c, uint16_t color, uint16_t bg, uint8_t size) {
+        (void)size;
+        if (x >= w_ || y >= h_ || x + 5 < 0 || y + 7 < 0) return;
+        const uint8_t* cols = (c >= 0x20 && c <= 0x7E) ? host_glcdfont[c - 0x20] : NULL;
+        for (int8_t i = 0; i < 5; i++) {
+            uint8_t line = cols ? cols[i] : 0;
+            for (int8_t j = 0; j < 8; j++, line >>= 1) {
+                if (line & 1) drawPixel(x + i, y + j, color);
+                else if (bg != color) drawPixel(x + i, y + j, bg);
+            }
+        }
+        if (bg != color) fillRect(x + 5, y, 1, 8, bg);
+    }
+
+    void setCursor(int16_t x, int16_t y) { cx_ = x; cy_ = y; }
+    void setTextColor(uint16_t c) { fg_ = c; bg_ = c; }
+    void setTextColor(uint16_t c, uint16_t bg) { fg_ = c; bg_ = bg; }
+    void setFont(const GFXfont* f) { (void)f; }
+    void setTextWrap(bool w) { wrap_ = w; }
+
+    size_t print(const char* s) {
+        size_t n = 0;
+        for (; *s; s++, n++) {
+            if (*s == '\n') { cx_ = 0; cy_ += 8; continue; }
+            if (*s == '\r') continue;
+            if (wrap_ && cx_ + 6 > w_) { cx_ = 0; cy_ += 8; }
+            drawChar(cx_, cy_, (unsigned char)*s, fg_, bg_, 1);
+            cx_ += 6;
+        }
+        return n;
+    }
+    size_t print(char c) { char s[2] = {c, 0}; return print(s); }
+    size_t print(int v) { char s[16]; snprintf(s, sizeof(s), "%d", v); return print(s); }
+
+private:
+    int16_t w_, h_;
+    std::vector<uint8_t> buf_;
+    int16_t cx_ = 0, cy_ = 0;
+    uint16_t fg_ = 0xFFFF, bg_ = 0xFFFF;
+    bool wrap_ = true;
+};
+
+// The controller as GxEPD2's driver layer (display.epd2) drives it: image
+// writes land in its current-frame RAM, the "again" writes in the
+// previous-frame RAM that the next differential update compares against.
+// Windows are byte-aligned, as framebuffer_module sends them.
+class HostEpd {
+public:
+    static constexpr int kStride = SCREEN_W / 8;
+    uint8_t current[kStride * SCREEN_H];
+    uint8_t previous[kStride * SCREEN_H];
+    int windows = 0;          // partial refreshes since the last reset
+    int full_refreshes = 0;
+
+    void writeImage(const uint8_t* bitmap, int16_t x, int16_t y, int16_t w, int16_t h) {
+        copy(current, bitmap, 0, 0, w, x, y, w, h);
+    }
+    void writeImageAgain(const uint8_t* bitmap, int16_t x, int16_t y, int16_t w, int16_t h) {
+        copy(previous, bitmap, 0, 0, w, x, y, w, h);
+    }
+    void writeImagePart(const uint8_t* bitmap, int16_t x_part, int16_t y_part, int16_t w_bitmap, int16_t h_bitmap,
+                        int16_t x, int16_t y, int16_t w, int16_t h) {
+        (void)h_bitmap;
+        copy(current, bitmap, x_part, y_part, w_bitmap, x, y, w, h);
+    }
+    void writeImagePartAgain(const uint8_t* bitmap, int16_t x_part, int16_t y_part, int16_t w_bitmap,
+                             int16_t h_bitmap, int16_t x, int16_t y, int16_t w, int16_t h) {
+        (void)h_bitmap;
+        copy(previous, bitmap, x_part, y_part, w_bitmap, x, y, w, h);
+    }
+    void refresh(bool partial_update_mode) {
+        (void)partial_update_mode;
+        full_refreshes++;
+    }
+    void refresh(int16_t x, int16_t y, int16_t w, int16_t h) {
+        (void)x; (void)y; (void)w; (void)h;
+        windows++;
+    }
+
+private:
+    static void copy(uint8_t* ram, const uint8_t* bitmap, int x_part, int y_part, int w_bitmap, int x, int y, int w,
+                     int h) {
+        for (int j = 0; j < h; j++) {
+            memcpy(ram + (y + j) * kStride + x / 8, bitmap + (y_part + j) * (w_bitmap / 8) + x_part / 8, w / 8);
+        }
+    }
+};
+
+// GxEPD2_BW with a full-height page buffer. drawPixel is virtual, as it is
+// through Adafruit_GFX; bench_glyph uses it for the per-pixel blit that
+// framebuffer_module did before [user-012].
+class HostPanel {
+public:
+    HostEpd epd2;
+    uint8_t buffer[SCREEN_W / 8 * SCREEN_H];
+
+    virtual ~HostPanel() {}
+    virtual void drawPixel(int16_t x, int16_t y, uint16_t color) {
+        if (x < 0 || y < 0 || x >= SCREEN_W || y >= SCREEN_H) return;
+        uint8_t* p = &buffer[(x / 8) + y * (SCREEN_W / 8)];
+        if (color) *p |= 0x80 >> (x & 7);
+        else *p &= ~(0x80 >> (x & 7));
+    }
+};
+
+static HostPanel display;
+static int partial_count = 0;
@@ -0,0 +1,54 @@
+#pragma once
+
+// --- Host Terminal ---
+//
+// The terminal emulator (term_state, scrollback, term_predict, term_emu)
+// over host_env, with the main.cpp pieces it calls. The parser runs on the
+// caller's thread, so term_mutex is a no-op.
+
+#include "host_env.hpp"
+
+static SemaphoreHandle_t term_mutex = NULL;
+static inline void termLock() {}
+static inline void termUnlock() {}
+
+#include "../../src/term_state_module.hpp"
+
+void terminalDebugTraceRecord(uint8_t b) { (void)b; }
+
+#include "../../src/scrollback_module.hpp"
+#include "../../src/term_predict_module.hpp"
+#include "../../src/term_emu_module.hpp"
+
+// Fresh emulator: empty screens and history, parser in the ground state.
+static void hostTermReset() {
+    static bool history_ready = false;
+    if (!history_ready) {
+        termHistoryInit();
+        history_ready = true;
+    }
+    termHistoryClear();
+    terminalClear();
+}
+
+// Screen row r as on the panel, trailing blanks trimmed.
+static std::string hostTermRow(int r) {
+    std::string row(termRow(r), TERM_COLS);
+    size_t end = row.find_last_not_of(' ');
+    return end == std::string::npos ? std::string() : row.substr(0, end + 1);
+}
+
+static void hostTermFeed(const std::string& bytes, size_t from, size_t to) {
+    if (to > from) terminalAppendOutput(bytes.data() + from, (int)(to - from));
+}
+
+// Feed bytes[0, end) in pieces cut at the sorted offsets in cuts.
+static void hostTermFeedCut(const std::string& bytes, size_t end, const std::vector<size_t>& cuts) {
+    size_t from = 0;
+    for (size_t cut : cuts) {
+        if (cut >= end) break;
+        hostTermFeed(bytes, from, cut);
+        from = cut;
+    }
+    hostTermFeed(bytes, from, end);
+}
@@ -0,0 +1,16 @@
+#pragma once
+
+// Host stand-in for the ESP32 ROM CRC: crc32_le(0, buf, len) is the usual
+// IEEE CRC-32 and chains like zlib's crc32().
+
+#include <stddef.h>
+#include <stdint.h>
+
+static inline uint32_t crc32_le(uint32_t crc, const uint8_t* buf, uint32_t len) {
+    crc = ~crc;
+    for (uint32_t i = 0; i < len; i++) {
+        crc ^= buf[i];
+        for (int k = 0; k < 8; k++) crc = (crc >> 1) ^ (0xEDB88320U & (0U - (crc & 1U)));
+    }
+    return ~crc;
+}
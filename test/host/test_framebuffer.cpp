@@ -0,0 +1,219 @@
+// fbDiffRects and fbPush on frames the notepad actually produces: a typed
+// character, a line join, a scroll, a cursor blink, changes at byte
+// boundaries, and far-apart changes merged into FB_MAX_WINDOWS windows.
+
+#include "host_gfx.hpp"
+
+#include "../../src/framebuffer_module.hpp"
+#include "../../src/font_module.hpp"
+
+static uint8_t prev_frame[FB_STRIDE * SCREEN_H];
+
+struct Box {
+    int x0, y0, x1, y1;   // inclusive pixel bounds; x0 > x1 when empty
+};
+
+static bool pixelAt(const uint8_t* buf, int x, int y) {
+    return buf[y * FB_STRIDE + (x >> 3)] & (0x80 >> (x & 7));
+}
+
+static Box diffBox(const uint8_t* a, const uint8_t* b) {
+    Box box = {SCREEN_W, SCREEN_H, -1, -1};
+    for (int y = 0; y < SCREEN_H; y++) {
+        for (int x = 0; x < SCREEN_W; x++) {
+            if (pixelAt(a, x, y) == pixelAt(b, x, y)) continue;
+            if (x < box.x0) box.x0 = x;
+            if (x > box.x1) box.x1 = x;
+            if (y < box.y0) box.y0 = y;
+            if (y > box.y1) box.y1 = y;
+        }
+    }
+    return box;
+}
+
+// Every changed pixel is inside a byte-aligned rectangle on screen; with a
+// single window it is exactly the byte-aligned bounding box.
+static int checkDiff(const char* what, const uint8_t* prev, const uint8_t* next, int max_rects, FbRect* out) {
+    int n = fbDiffRects(prev, next, FB_STRIDE, SCREEN_H, out, max_rects);
+    Box box = diffBox(prev, next);
+    bool same = box.x1 < 0;
+    HOST_CHECK(same == (n == 0), "%s: %d rects for %s frames", what, n, same ? "identical" : "different");
+    HOST_CHECK(n <= max_rects, "%s: %d rects over the budget of %d", what, n, max_rects);
+    for (int i = 0; i < n; i++) {
+        const FbRect& r = out[i];
+        HOST_CHECK(r.x % 8 == 0 && r.w % 8 == 0 && r.w > 0 && r.h > 0, "%s: rect %d not byte aligned", what, i);
+        HOST_CHECK(r.x >= 0 && r.y >= 0 && r.x + r.w <= SCREEN_W && r.y + r.h <= SCREEN_H,
+                   "%s: rect %d off screen", what, i);
+    }
+    for (int y = 0; y < SCREEN_H; y++) {
+        for (int x = 0; x < SCREEN_W; x++) {
+            if (pixelAt(prev, x, y) == pixelAt(next, x, y)) continue;
+            bool covered = false;
+            for (int i = 0; i < n && !covered; i++) {
+                covered = x >= out[i].x && x < out[i].x + out[i].w && y >= out[i].y && y < out[i].y + out[i].h;
+            }
+            HOST_CHECK(covered, "%s: changed pixel (%d,%d) not sent", what, x, y);
+            if (!covered) return n;
+        }
+    }
+    if (n == 1) {
+        int x = box.x0 & ~7, w = ((box.x1 | 7) + 1) - x;
+        HOST_CHECK(out[0].x == x && out[0].w == w && out[0].y == box.y0 && out[0].h == box.y1 - box.y0 + 1,
+                   "%s: window (%d,%d %dx%d), want (%d,%d %dx%d)", what, out[0].x, out[0].y, out[0].w, out[0].h,
+                   x, box.y0, w, box.y1 - box.y0 + 1);
+    }
+    return n;
+}
+
+// Notepad rows: text drawn from row_y + 1, status bar at the bottom.
+static void drawPage(const std::vector<std::string>& lines, int first = 0) {
+    frame_canvas.fillScreen(GxEPD_WHITE);
+    for (int r = 0; r < ROWS_PER_SCREEN && first + r < (int)lines.size(); r++) {
+        const std::string& s = lines[first + r];
+        fbDrawText(0, r * CHAR_H + 1, s.data(), (int)s.size() < COLS_PER_LINE ? (int)s.size() : COLS_PER_LINE);
+    }
+    frame_canvas.fillRect(0, SCREEN_H - STATUS_H, SCREEN_W, STATUS_H, GxEPD_BLACK);
+}
+
+static std::vector<std::string> sampleLines(int n) {
+    std::vector<std::string> lines;
+    for (int i = 0; i < n; i++) {
+        char buf[64];
+        snprintf(buf, sizeof(buf), "line %02d: the quick brown fox jumps", i);
+        lines.push_back(buf);
+    }
+    return lines;
+}
+
+static void keep() { memcpy(prev_frame, frame_canvas.getBuffer(), sizeof(prev_frame)); }
+
+static void testEditorFrames() {
+    FbRect r[FB_MAX_WINDOWS];
+    std::vector<std::string> lines = sampleLines(60);
+
+    drawPage(lines);
+    keep();
+    HOST_CHECK(checkDiff("unchanged", prev_frame, frame_canvas.getBuffer(), FB_MAX_WINDOWS, r) == 0, "redraw");
+
+    // Typing one char at the end of row 5 (col 34 = x 204..209, bytes 25-26).
+    lines[5] += "q";
+    drawPage(lines);
+    int n = checkDiff("single char", prev_frame, frame_canvas.getBuffer(), FB_MAX_WINDOWS, r);
+    HOST_CHECK(n == 1 && r[0].x == 200 && r[0].w == 16 && r[0].y >= 5 * CHAR_H + 1 && r[0].y + r[0].h <= 6 * CHAR_H + 2,
+               "single char window (%d,%d %dx%d)", r[0].x, r[0].y, r[0].w, r[0].h);
+    keep();
+
+    // Joining rows 10 and 11: row 10 grows, everything below moves up a row.
+    lines[10] = lines[10].substr(0, 20) + lines[11].substr(0, 12);
+    lines.erase(lines.begin() + 11);
+    drawPage(lines);
+    n = checkDiff("line join", prev_frame, frame_canvas.getBuffer(), FB_MAX_WINDOWS, r);
+    HOST_CHECK(n == 1 && r[0].y <= 10 * CHAR_H + 1 && r[0].y + r[0].h >= ROWS_PER_SCREEN * CHAR_H,
+               "line join window (%d,%d %dx%d)", r[0].x, r[0].y, r[0].w, r[0].h);
+    keep();
+
+    // Scrolling one row: the whole text area changes, the status bar does not.
+    drawPage(lines, 1);
+    n = checkDiff("scroll", prev_frame, frame_canvas.getBuffer(), FB_MAX_WINDOWS, r);
+    HOST_CHECK(n == 1 && r[0].y <= 2 && r[0].y + r[0].h > (ROWS_PER_SCREEN - 1) * CHAR_H &&
+               r[0].y + r[0].h <= SCREEN_H - STATUS_H,
+               "scroll window (%d,%d %dx%d)", r[0].x, r[0].y, r[0].w, r[0].h);
+    keep();
+
+    // Cursor blink at row 3, col 4 (x 24..29, inside byte 3): one 8x8 window.
+    fbDrawCursorCell(4 * CHAR_W, 3 * CHAR_H + 1, lines[4][4]);
+    n = checkDiff("cursor on", prev_frame, frame_canvas.getBuffer(), FB_MAX_WINDOWS, r);
+    HOST_CHECK(n == 1 && r[0].x == 24 && r[0].w == 8 && r[0].y == 3 * CHAR_H + 1 && r[0].h == CHAR_H,
+               "cursor window (%d,%d %dx%d)", r[0].x, r[0].y, r[0].w, r[0].h);
+    keep();
+    drawPage(lines, 1);
+    n = checkDiff("cursor off", prev_frame, frame_canvas.getBuffer(), FB_MAX_WINDOWS, r);
+    HOST_CHECK(n == 1 && r[0].x == 24 && r[0].w == 8, "cursor off window (%d,%d %dx%d)", r[0].x, r[0].y, r[0].w,
+               r[0].h);
+
+    // A cell straddling two bytes (col 1 = x 6..11) needs both.
+    keep();
+    fbDrawCursorCell(1 * CHAR_W, 20 * CHAR_H + 1, 'x');
+    n = checkDiff("straddling cursor", prev_frame, frame_canvas.getBuffer(), FB_MAX_WINDOWS, r);
+    HOST_CHECK(n == 1 && r[0].x == 0 && r[0].w == 16, "straddling window (%d,%d %dx%d)", r[0].x, r[0].y, r[0].w,
+               r[0].h);
+}
+
+// Single pixels at the byte edges widen to exactly their byte.
+static void testByteEdges() {
+    static const struct { int x0, x1, want_x, want_w; } cases[] = {
+        {0, 0, 0, 8},   {7, 7, 0, 8},     {8, 8, 8, 8},       {7, 8, 0, 16},
+        {15, 16, 8, 16}, {232, 232, 232, 8}, {239, 239, 232, 8}, {0, 239, 0, 240},
+    };
+    for (const auto& c : cases) {
+        frame_canvas.fillScreen(GxEPD_WHITE);
+        keep();
+        frame_canvas.drawPixel(c.x0, 100, GxEPD_BLACK);
+        frame_canvas.drawPixel(c.x1, 101, GxEPD_BLACK);
+        FbRect r[1];
+        char what[32];
+        snprintf(what, sizeof(what), "pixels %d,%d", c.x0, c.x1);
+        int n = checkDiff(what, prev_frame, frame_canvas.getBuffer(), 1, r);
+        HOST_CHECK(n == 1 && r[0].x == c.want_x && r[0].w == c.want_w && r[0].y == 100 && r[0].h == 2,
+                   "%s: window (%d,%d %dx%d)", what, r[0].x, r[0].y, r[0].w, r[0].h);
+    }
+}
+
+// Far-apart changes: bands merge closest-first down to the window budget.
+static void testMerge() {
+    frame_canvas.fillScreen(GxEPD_WHITE);
+    keep();
+    frame_canvas.drawPixel(10, 0, GxEPD_BLACK);      // top row
+    frame_canvas.drawPixel(100, 40, GxEPD_BLACK);    // 40 rows down
+    frame_canvas.drawPixel(200, 315, GxEPD_BLACK);   // status bar
+    FbRect r[3];
+    int n = checkDiff("three bands", prev_frame, frame_canvas.getBuffer(), 3, r);
+    HOST_CHECK(n == 3, "three separate bands, got %d", n);
+    n = checkDiff("two windows", prev_frame, frame_canvas.getBuffer(), 2, r);
+    HOST_CHECK(n == 2 && r[0].y == 0 && r[0].h == 41 && r[1].y == 315, "closest bands merged first");
+    n = checkDiff("one window", prev_frame, frame_canvas.getBuffer(), FB_MAX_WINDOWS, r);
+    HOST_CHECK(n == 1 && r[0].x == 8 && r[0].w == 200 && r[0].y == 0 && r[0].h == 316,
+               "merged window (%d,%d %dx%d)", r[0].x, r[0].y, r[0].w, r[0].h);
+
+    // Rows within FB_MERGE_GAP_ROWS join one band; more bands than
+    // FB_MAX_BANDS fold into the last one.
+    frame_canvas.fillScreen(GxEPD_WHITE);
+    frame_canvas.drawPixel(50, 100, GxEPD_BLACK);
+    frame_canvas.drawPixel(60, 100 + FB_MERGE_GAP_ROWS, GxEPD_BLACK);
+    n = checkDiff("gap rows", prev_frame, frame_canvas.getBuffer(), 3, r);
+    HOST_CHECK(n == 1, "rows %d apart make one band, got %d", FB_MERGE_GAP_ROWS, n);
+    frame_canvas.fillScreen(GxEPD_WHITE);
+    for (int i = 0; i < 20; i++) frame_canvas.drawPixel(i * 12, i * 15, GxEPD_BLACK);
+    FbRect many[FB_MAX_BANDS];
+    n = checkDiff("many bands", prev_frame, frame_canvas.getBuffer(), FB_MAX_BANDS, many);
+    HOST_CHECK(n == FB_MAX_BANDS, "20 bands capped at %d, got %d", FB_MAX_BANDS, n);
+    n = checkDiff("many bands, one window", prev_frame, frame_canvas.getBuffer(), FB_MAX_WINDOWS, r);
+}
+
+// fbPush sends only the window and leaves the panel equal to the canvas.
+static void testPush() {
+    std::vector<std::string> lines = sampleLines(40);
+    drawPage(lines);
+    fbPushFull();
+    HOST_CHECK(memcmp(display.epd2.current, frame_canvas.getBuffer(), sizeof(frame_shadow)) == 0, "full push");
+    display.epd2.windows = 0;
+    HOST_CHECK(!fbPush(), "nothing to send");
+    lines[2] = "changed";
+    lines[30] += "!";
+    drawPage(lines);
+    HOST_CHECK(fbPush() && display.epd2.windows == FB_MAX_WINDOWS, "one partial window, got %d",
+               display.epd2.windows);
+    HOST_CHECK(memcmp(display.epd2.current, frame_canvas.getBuffer(), sizeof(frame_shadow)) == 0,
+               "panel matches canvas after partial push");
+    HOST_CHECK(memcmp(display.epd2.previous, frame_canvas.getBuffer(), sizeof(frame_shadow)) == 0,
+               "previous-frame RAM matches canvas after partial push");
+    HOST_CHECK(memcmp(frame_shadow, frame_canvas.getBuffer(), sizeof(frame_shadow)) == 0, "shadow updated");
+}
+
+int main() {
+    testEditorFrames();
+    testByteEdges();
+    testMerge();
+    testPush();
+    return hostReport("test_framebuffer");
+}
@@ -0,0 +1,200 @@
+// Edit journal power-loss test: cut the power at every unit of SD work in a
+// run of saves (each journal byte, the .tmp write, remove and rename of a
+// compaction), boot through journalRecoverAll and check the document is the
+// last one whose save had committed. Then cut and corrupt a finished
+// journal at every byte offset.
+
+#include "host_editor.hpp"
+
+static const char* kBase = "/note.txt";
+static const char* kJournal = "/.note.txt.jnl";
+static const char* kBaseText = "first line\nsecond line of the base file\nthird\n";
+
+// Boot-time state for a fresh run: a document that was never opened.
+static void hostBoot() {
+    textClear();
+    jnl_write_failed = false;
+    jnl_overflow = false;
+    jnl_base_len = 0;
+    jnl_base_crc = 0;
+    current_file = "";
+    file_modified = false;
+}
+
+// saveToFile, or autoSaveDirty's compacting save when compact is set.
+static void save(bool compact) {
+    storageRequestSave(kBase, compact, false, true);
+}
+
+static void putBase() {
+    hostSdReset();
+    host_sd_files[kBase] = kBaseText;
+}
+
+// The edit session under test. docs[i] is the document once save i has
+// committed (docs[0] is the base); done_at[i] is the SD work spent by then.
+static void scenario(std::vector<std::string>& docs, std::vector<long>& done_at) {
+    hostBoot();
+    loadFromFile(kBase);
+    docs.push_back(hostDocument());
+    done_at.push_back(host_sd_spent);
+    auto saved = [&](bool compact) {
+        save(compact);
+        docs.push_back(hostDocument());
+        done_at.push_back(host_sd_spent);
+    };
+
+    hostType(text_len, "typed at the end");
+    saved(false);                          // new journal: header + batch
+    hostType(5, ", middle");
+    hostErase(text_len, 3);
+    saved(false);                          // append
+    hostType(0, "head\n");
+    saved(true);                           // compaction: .tmp, remove, rename, drop .jnl
+    hostType(text_len, "\nafter compaction");
+    saved(false);                          // journal against the new base
+    hostErase(12, 4);
+    hostType(3, "xyz");
+    saved(false);
+}
+
+// Boot after the power cut: recover every journal, then open the file.
+static std::string rebootAndLoad() {
+    hostSdPowerOn();
+    hostBoot();
+    journalRecoverAll();
+    hostBoot();
+    if (!loadFromFile(kBase)) return "<missing>";
+    return hostDocument();
+}
+
+static void testPowerCutEveryUnit() {
+    std::vector<std::string> docs;
+    std::vector<long> done_at;
+    putBase();
+    scenario(docs, done_at);
+    long total = host_sd_spent;
+    HOST_CHECK(rebootAndLoad() == docs.back(), "clean run reloads the final document");
+
+    int last_index = 0;
+    for (long cut = 0; cut <= total; cut++) {
+        std::vector<std::string> unused_docs;
+        std::vector<long> unused_done;
+        putBase();
+        host_sd_budget = cut;
+        scenario(unused_docs, unused_done);
+
+        std::string got = rebootAndLoad();
+        size_t committed = 0;
+        while (committed + 1 < done_at.size() && done_at[committed + 1] <= cut) committed++;
+        int index = -1;
+        if (got == docs[committed]) index = (int)committed;
+        else if (committed + 1 < docs.size() && got == docs[committed + 1]) index = (int)committed + 1;
+        HOST_CHECK(index >= 0, "cut at %ld: got \"%s\", want save %zu \"%s\"", cut, got.c_str(), committed,
+                   docs[committed].c_str());
+        HOST_CHECK(index < 0 || index >= last_index, "cut at %ld: went back to save %d", cut, index);
+        if (index >= 0) last_index = index;
+
+        // Recovery leaves a journal later appends can extend.
+        std::string want = got + "!";
+        hostType(text_len, "!");
+        save(false);
+        HOST_CHECK(rebootAndLoad() == want, "cut at %ld: append after recovery lost", cut);
+    }
+    HOST_CHECK(last_index == (int)docs.size() - 1, "the last save was never recovered");
+}
+
+// A finished two-batch journal cut at every byte, and with each payload
+// byte flipped: replay keeps whole batches up to the damage.
+static void testJournalCutAndCorrupt() {
+    putBase();
+    hostBoot();
+    loadFromFile(kBase);
+    std::string doc0 = hostDocument();
+    hostType(text_len, "one");
+    save(false);
+    std::string doc1 = hostDocument();
+    size_t batch1_end = host_sd_files[kJournal].size();
+    hostType(4, "two");
+    hostErase(text_len, 2);
+    save(false);
+    std::string doc2 = hostDocument();
+    const std::string journal = host_sd_files[kJournal];
+    HOST_CHECK(journal.size() > batch1_end, "second batch appended");
+
+    for (size_t len = 0; len <= journal.size(); len++) {
+        host_sd_files[kBase] = kBaseText;
+        host_sd_files[kJournal] = journal.substr(0, len);
+        std::string want = len == journal.size() ? doc2 : len >= batch1_end ? doc1 : doc0;
+        std::string got = rebootAndLoad();
+        HOST_CHECK(got == want, "journal cut at %zu: got \"%s\", want \"%s\"", len, got.c_str(), want.c_str());
+    }
+
+    for (size_t at = JOURNAL_HDR_LEN; at < journal.size(); at++) {
+        std::string bad = journal;
+        bad[at] ^= 0x5A;
+        host_sd_files[kBase] = kBaseText;
+        host_sd_files[kJournal] = bad;
+        std::string want = at >= batch1_end ? doc1 : doc0;
+        std::string got = rebootAndLoad();
+        HOST_CHECK(got == want, "journal byte %zu flipped: got \"%s\", want \"%s\"", at, got.c_str(), want.c_str());
+    }
+}
+
+// Stale journal from a compaction cut after the rename: dropped.
+static void testStaleJournal() {
+    putBase();
+    hostBoot();
+    loadFromFile(kBase);
+    hostType(0, "x");
+    save(false);
+    std::string journal = host_sd_files[kJournal];
+    host_sd_files[kBase] = "rewritten base\n";
+    host_sd_files[kJournal] = journal;
+    HOST_CHECK(rebootAndLoad() == "rewritten base\n", "stale journal applied");
+    HOST_CHECK(host_sd_files.count(kJournal) == 0, "stale journal kept");
+}
+
+// file_modified follows what landed: a failed save leaves the document
+// dirty, and a save finished after more typing, or for a document that
+// has since been closed, does not touch the open one.
+static void testModifiedFlag() {
+    putBase();
+    hostBoot();
+    loadFromFile(kBase);
+    hostType(text_len, "a");
+    file_modified = true;
+    host_sd_budget = 0;
+    save(false);
+    HOST_CHECK(file_modified && jnl_overflow, "failed save left the document clean");
+    hostSdPowerOn();
+    save(false);
+    HOST_CHECK(!file_modified, "save after the failure left the document dirty");
+    HOST_CHECK(rebootAndLoad() == std::string(kBaseText) + "a", "save after the failure lost the edit");
+
+    StorageOutcome o;
+    memset(&o, 0, sizeof(o));
+    o.saved = true;
+    o.saved_doc = text_doc_id;
+    o.saved_seq = text_edit_seq;
+    hostType(0, "b");
+    file_modified = true;
+    storageApply(o);
+    HOST_CHECK(file_modified, "save planned before the last edit cleaned the document");
+
+    memset(&o, 0, sizeof(o));
+    o.failed = 1;
+    o.failed_doc = text_doc_id - 1;
+    file_modified = false;
+    jnl_overflow = false;
+    storageApply(o);
+    HOST_CHECK(!file_modified && !jnl_overflow, "failure of a closed document dirtied the open one");
+}
+
+int main() {
+    testPowerCutEveryUnit();
+    testJournalCutAndCorrupt();
+    testStaleJournal();
+    testModifiedFlag();
+    return hostReport("test_journal");
+}
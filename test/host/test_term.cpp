@@ -0,0 +1,273 @@
+// Terminal conformance and throughput: replay vim, tmux and top sessions
+// captured at the device's 40x38 xterm size (fixtures/record.py) and compare
+// the screen and cursor with what tmux shows for the same bytes. Each
+// capture is also fed cut at every byte of every escape and UTF-8 sequence,
+// which must not change the result, and timed in bytes/s. The row ring and
+// the scrollback history are checked on their own.
+
+#include "host_term.hpp"
+
+#include <chrono>
+#include <fstream>
+#include <sstream>
+
+// Well above any link the device sees; a parser that went per-byte
+// expensive or quadratic drops under it.
+static const double kMinBytesPerSec = 4e6;
+
+struct Checkpoint {
+    size_t offset;
+    int row, col;
+    std::vector<std::string> rows;
+};
+
+struct Capture {
+    std::string name;
+    std::string raw;
+    std::vector<Checkpoint> checkpoints;
+};
+
+static std::string readFile(const std::string& path) {
+    std::ifstream in(path, std::ios::binary);
+    std::stringstream ss;
+    ss << in.rdbuf();
+    return ss.str();
+}
+
+// A tmux row is UTF-8; the panel shows unicodeToAscii's stand-ins.
+static std::string panelRow(const std::string& utf8) {
+    std::string out;
+    for (size_t i = 0; i < utf8.size();) {
+        uint8_t c = (uint8_t)utf8[i];
+        int extra = c < 0x80 ? 0 : c >= 0xF0 ? 3 : c >= 0xE0 ? 2 : 1;
+        uint32_t cp = extra == 0 ? c : extra == 1 ? (c & 0x1F) : extra == 2 ? (c & 0x0F) : (c & 0x07);
+        for (int k = 1; k <= extra && i + k < utf8.size(); k++) cp = (cp << 6) | ((uint8_t)utf8[i + k] & 0x3F);
+        i += extra + 1;
+        char mapped = cp < 0x80 ? (char)cp : unicodeToAscii(cp);
+        out += mapped ? mapped : '?';
+    }
+    return out;
+}
+
+static Capture loadCapture(const char* name) {
+    Capture cap;
+    cap.name = name;
+    cap.raw = readFile(std::string("fixtures/") + name + ".raw");
+    std::istringstream grids(readFile(std::string("fixtures/") + name + ".grids"));
+    std::string line;
+    while (std::getline(grids, line)) {
+        Checkpoint cp;
+        if (sscanf(line.c_str(), "@ %zu %d %d", &cp.offset, &cp.row, &cp.col) != 3) continue;
+        for (int r = 0; r < ROWS_PER_SCREEN && std::getline(grids, line); r++) cp.rows.push_back(panelRow(line));
+        cap.checkpoints.push_back(cp);
+    }
+    HOST_CHECK(!cap.raw.empty() && !cap.checkpoints.empty(), "%s: fixture missing (run from test/host)", name);
+    return cap;
+}
+
+static bool matches(const Capture& cap, const Checkpoint& cp, const char* how) {
+    bool ok = true;
+    for (int r = 0; r < ROWS_PER_SCREEN; r++) {
+        std::string got = hostTermRow(r);
+        if (got != cp.rows[r]) {
+            HOST_CHECK(false, "%s @%zu %s: row %d \"%s\", want \"%s\"", cap.name.c_str(), cp.offset, how, r,
+                       got.c_str(), cp.rows[r].c_str());
+            ok = false;
+        }
+    }
+    // After the last column the cursor waits there; tmux reports the same cell.
+    int col = term_cursor_col < TERM_COLS ? term_cursor_col : TERM_COLS - 1;
+    if (term_cursor_row != cp.row || col != cp.col) {
+        HOST_CHECK(false, "%s @%zu %s: cursor %d,%d, want %d,%d", cap.name.c_str(), cp.offset, how,
+                   term_cursor_row, col, cp.row, cp.col);
+        ok = false;
+    }
+    return ok;
+}
+
+// One call per checkpoint prefix, as one big read would deliver it.
+static void testWholeReads(const Capture& cap) {
+    for (const Checkpoint& cp : cap.checkpoints) {
+        hostTermReset();
+        hostTermFeed(cap.raw, 0, cp.offset);
+        matches(cap, cp, "whole");
+    }
+}
+
+// Offsets where the parser is inside a sequence: every byte after an
+// escape, control string or UTF-8 lead byte up to the one that ends it.
+struct Sequence {
+    size_t start, len;
+};
+
+static std::vector<Sequence> findSequences(const Capture& cap) {
+    std::vector<Sequence> seqs;
+    hostTermReset();
+    bool inside = false;
+    size_t start = 0;
+    for (size_t i = 0; i < cap.raw.size(); i++) {
+        if (!inside) start = i;
+        hostTermFeed(cap.raw, i, i + 1);
+        bool now = vt_state != VT_GROUND || utf8_remaining > 0;
+        if (inside && !now) seqs.push_back({start, i + 1 - start});
+        inside = now;
+    }
+    return seqs;
+}
+
+// Pass j cuts every sequence before its j-th byte; the plain text between
+// sequences stays in whole runs, so the bulk path sees the cuts too.
+static void testSplitSequences(const Capture& cap) {
+    std::vector<Sequence> seqs = findSequences(cap);
+    size_t longest = 0;
+    for (const Sequence& s : seqs) longest = s.len > longest ? s.len : longest;
+    HOST_CHECK(seqs.size() > 20, "%s: only %zu escape sequences", cap.name.c_str(), seqs.size());
+
+    for (size_t j = 1; j < longest; j++) {
+        std::vector<size_t> cuts;
+        for (const Sequence& s : seqs) {
+            if (j < s.len) cuts.push_back(s.start + j);
+        }
+        char how[40];
+        snprintf(how, sizeof(how), "cut at byte %zu", j);
+        for (const Checkpoint& cp : cap.checkpoints) {
+            hostTermReset();
+            hostTermFeedCut(cap.raw, cp.offset, cuts);
+            if (!matches(cap, cp, how)) return;
+        }
+    }
+
+    // Every byte its own read.
+    for (const Checkpoint& cp : cap.checkpoints) {
+        hostTermReset();
+        for (size_t i = 0; i < cp.offset; i++) hostTermFeed(cap.raw, i, i + 1);
+        matches(cap, cp, "byte by byte");
+    }
+}
+
+static void testThroughput(const Capture& cap) {
+    using clock = std::chrono::steady_clock;
+    size_t bytes = 0;
+    clock::duration spent{};
+    while (spent < std::chrono::milliseconds(300)) {
+        hostTermReset();
+        clock::time_point t0 = clock::now();
+        hostTermFeed(cap.raw, 0, cap.raw.size());
+        spent += clock::now() - t0;
+        bytes += cap.raw.size();
+    }
+    double per_sec = bytes / std::chrono::duration<double>(spent).count();
+    printf("test_term: %-5s %6zu bytes  %7.1f MB/s\n", cap.name.c_str(), cap.raw.size(), per_sec / 1e6);
+    HOST_CHECK(per_sec >= kMinBytesPerSec, "%s: %.0f bytes/s, want >= %.0f", cap.name.c_str(), per_sec,
+               kMinBytesPerSec);
+}
+
+// Region scrolls at every ring head: rows in consecutive slots shift with
+// one memmove, a region across the wrap goes row by row. Both must match
+// shifting a plain array of rows.
+static void testRegionScrollRing() {
+    const int regions[][2] = {{0, ROWS_PER_SCREEN - 2}, {1, ROWS_PER_SCREEN - 1}, {5, 20}, {30, 31}};
+    for (int head = 0; head < TERM_ROWS; head++) {
+        for (const auto& reg : regions) {
+            for (int dir = -1; dir <= 1; dir += 2) {
+                hostTermReset();
+                enterAltScreen();
+                term_grid->head = head;
+                std::vector<std::string> want;
+                for (int r = 0; r < ROWS_PER_SCREEN; r++) {
+                    char text[TERM_COLS + 1];
+                    snprintf(text, sizeof(text), "row %d", r);
+                    memcpy(termRow(r), text, strlen(text));
+                    want.push_back(hostTermRow(r));
+                }
+                int top = reg[0], bot = reg[1];
+                if (dir < 0) {
+                    terminalScrollRegionUp(top, bot);
+                    want.erase(want.begin() + top);
+                    want.insert(want.begin() + bot, "");
+                } else {
+                    terminalScrollRegionDown(top, bot);
+                    want.erase(want.begin() + bot);
+                    want.insert(want.begin() + top, "");
+                }
+                for (int r = 0; r < ROWS_PER_SCREEN; r++) {
+                    HOST_CHECK(hostTermRow(r) == want[r], "head %d region %d-%d dir %d: row %d \"%s\", want \"%s\"",
+                               head, top, bot, dir, r, hostTermRow(r).c_str(), want[r].c_str());
+                }
+            }
+        }
+    }
+}
+
+static std::string trimmed(const char* row) {
+    std::string s(row, TERM_COLS);
+    size_t end = s.find_last_not_of(' ');
+    return end == std::string::npos ? std::string() : s.substr(0, end + 1);
+}
+
+// Line n as printed: runs of spaces of every length, some rows full.
+static std::string historyLine(int n) {
+    char buf[TERM_COLS + 1];
+    int len = snprintf(buf, sizeof(buf), "%05d%*s|%s", n, n % 7, "", n % 5 ? "x y  z" : "");
+    if (n % 11 == 0) {
+        memset(buf + len, '#', TERM_COLS - len);
+        len = TERM_COLS;
+    }
+    return std::string(buf, len);
+}
+
+static void testHistory() {
+    hostTermReset();
+    const int kLines = 20000;
+    std::string out;
+    for (int n = 0; n < kLines; n++) out += historyLine(n) + "\r\n";
+    hostTermFeed(out, 0, out.size());
+
+    // The cursor sits on an empty last row; the newest history line is
+    // the one just above the top of the screen.
+    int hist = termHistoryCount();
+    int newest = kLines - ROWS_PER_SCREEN;
+    HOST_CHECK(hist >= 10000, "history kept %d lines, want >= 10000", hist);
+    for (int j = 0; j < hist; j++) {
+        std::string want = historyLine(newest - j);
+        std::string got = trimmed(termHistoryLine(hist - 1 - j));
+        if (got != want) {
+            HOST_CHECK(false, "history line %d: \"%s\", want \"%s\"", hist - 1 - j, got.c_str(), want.c_str());
+            break;
+        }
+    }
+
+    // Search: a line in history scrolls the view to it; repeating goes
+    // further back; a line on the grid leaves the view live.
+    char pat[16];
+    snprintf(pat, sizeof(pat), "%05d", newest - 100);
+    int v = termSearch(pat, NULL);
+    HOST_CHECK(v == hist - 101 && term_view_hist == 101, "search %s: line %d view %d", pat, v, term_view_hist);
+    HOST_CHECK(termSearch("", NULL) == -1, "repeat found a second %s", pat);
+    snprintf(pat, sizeof(pat), "%05d", kLines - 2);
+    v = termSearch(pat, NULL);
+    HOST_CHECK(v == hist + (kLines - 2 - newest - 1) && term_view_hist == 0, "search %s: line %d view %d", pat, v,
+               term_view_hist);
+    termViewLive();
+
+    // Worst case for the arena: every cell printed.
+    hostTermReset();
+    out.clear();
+    for (int n = 0; n < kLines; n++) out += std::string(TERM_COLS, (char)('A' + n % 26)) + "\r\n";
+    hostTermFeed(out, 0, out.size());
+    HOST_CHECK(termHistoryCount() >= 12000, "full rows: history kept %d lines", termHistoryCount());
+}
+
+int main() {
+    testRegionScrollRing();
+    testHistory();
+    const char* names[] = {"vim", "tmux", "top"};
+    for (const char* name : names) {
+        Capture cap = loadCapture(name);
+        if (cap.checkpoints.empty()) continue;
+        testWholeReads(cap);
+        testSplitSequences(cap);
+        testThroughput(cap);
+    }
+    return hostReport("test_term");
+}